@@ -36,6 +36,22 @@ void DecompressorBase::removeFile(const PPSystemString& fileName)
 	XMFile::remove(fileName);
 }
 
+bool DecompressorBase::decompress(const PPSystemString& outFileName, Hints hint)
+{
+	bool result = false;
+	
+	{
+		XMFile f(outFileName, true);
+		if (f.isOpenForWriting())
+			result = decompress(f, hint);
+	}
+	
+	if (!result)
+		removeFile(outFileName);
+	
+	return result;
+}
+
 bool DecompressorBase::identify()
 {
 	XMFile f(fileName);
@@ -114,6 +130,44 @@ const PPSimpleVector<Descriptor>& Decompressor::getDescriptors(Hints hint) const
 	return descriptors;
 }
 	
+bool Decompressor::decompress(XMFileBase& outFile, Hints hint)
+{
+	const mp_uint32 start = outFile.pos();
+
+	for (pp_int32 i = 0; i < decompressors.size(); i++)
+	{
+		if (decompressors.get(i)->identify())
+		{
+			if (decompressors.get(i)->decompress(outFile, hint))
+				return true;
+				
+			if (outFile.pos() != start)
+				return false;
+		}
+	}
+	
+	return false;
+}
+
+bool Decompressor::decompress(XMBufferFile& outFile, Hints hint)
+{
+	const mp_uint32 start = outFile.size();
+	outFile.seek(start);
+
+	for (pp_int32 i = 0; i < decompressors.size(); i++)
+	{
+		if (decompressors.get(i)->identify())
+		{
+			if (decompressors.get(i)->decompress(outFile, hint))
+				return true;
+				
+			outFile.truncate(start);
+		}
+	}
+	
+	return false;
+}
+
 bool Decompressor::decompress(const PPSystemString& outFileName, Hints hint)
 {
 	bool result = false;
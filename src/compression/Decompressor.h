@@ -34,6 +34,8 @@
 #include "BasicTypes.h"
 #include "SimpleVector.h"
 
+class XMFileBase;
+class XMBufferFile;
 class XMFile;
 
 class DecompressorBase
@@ -66,7 +68,11 @@ public:
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const = 0;
 	
-	virtual bool decompress(const PPSystemString& outFileName, Hints hint) = 0;
+	// decompress into outFile, e.g. an XMBufferFile to load from memory
+	virtual bool decompress(XMFileBase& outFile, Hints hint) = 0;
+
+	// decompress into a file of that name, the file is removed on failure
+	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
 	
 	static void removeFile(const PPSystemString& fileName);
 	
@@ -94,6 +100,13 @@ public:
 	
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
+	// streams straight into outFile, a failed attempt which has written 
+	// something already can't be undone, no other decompressor is tried then
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
+
+	// decompresses straight into the buffer, failed attempts are cut off again
+	bool decompress(XMBufferFile& outFile, Hints hint);
+
 	virtual bool decompress(const PPSystemString& outFileName, Hints hint);
 	
 	virtual DecompressorBase* clone();
@@ -55,7 +55,7 @@ const PPSimpleVector<Descriptor>& DecompressorGZIP::getDescriptors(Hints hint) c
 	return descriptors;
 }
 
-bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
+bool DecompressorGZIP::decompress(XMFileBase& outFile, Hints hint)
 {
 	gzFile gz_input_file = NULL;
 	int len = 0;
@@ -67,8 +67,6 @@ bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
 	if ((buf = new pp_uint8[0x10000]) == NULL)
 		return false;
 
-	XMFile fOut(outFileName, true);
-
 	while (true)
 	{
 		len = gzread (gz_input_file, buf, 0x10000);
@@ -81,7 +79,7 @@ bool DecompressorGZIP::decompress(const PPSystemString& outFileName, Hints hint)
 
 		if (len == 0) break;
 
-		fOut.write(buf, 1, len);
+		outFile.write(buf, 1, len);
 	}
 
 	if (gzclose (gz_input_file) != Z_OK)
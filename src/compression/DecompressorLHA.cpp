@@ -121,7 +121,7 @@ const PPSimpleVector<Descriptor>& DecompressorLHA::getDescriptors(Hints hint) co
 	return descriptors;
 }		
 	
-bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorLHA::decompress(XMFileBase& outFile, Hints hint)
 {
 	XMFile f(fileName);
 	
@@ -151,11 +151,6 @@ bool DecompressorLHA::decompress(const PPSystemString& outFilename, Hints hint)
 
 		if (bytes_read > 0 && XModule::identifyModule(buf) != NULL)
 		{
-			// Write to output file
-			XMFile outFile(outFilename, true);
-			if (!outFile.isOpenForWriting())
-				return false;
-
 			// Decompress into outFile
 			do
 			{
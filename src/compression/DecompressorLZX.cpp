@@ -36,14 +36,12 @@
 
 struct ModuleIdentificator : public Unlzx::FileIdentificator 
 {
-	virtual bool identify(const PPSystemString& filename) const
+	virtual bool identify(const unsigned char* buffer, unsigned long size) const
 	{
-		XMFile file(filename);
-		
 		mp_ubyte buff[XModule::IdentificationBufferSize];
 		memset(buff, 0, sizeof(buff));
 
-		file.read(buff, 1, sizeof(buff));
+		memcpy(buff, buffer, size < sizeof(buff) ? size : sizeof(buff));
 		
 		return XModule::identifyModule(buff) != NULL;
 	}
@@ -72,7 +70,7 @@ const PPSimpleVector<Descriptor>& DecompressorLZX::getDescriptors(Hints hint) co
 	return descriptors;
 }		
 	
-bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorLZX::decompress(XMFileBase& outFile, Hints hint)
 {
 	// If client requests something else than a module we can't deal we that
 	if (hint != HintAll &&
@@ -82,7 +80,7 @@ bool DecompressorLZX::decompress(const PPSystemString& outFilename, Hints hint)
 	ModuleIdentificator identificator;
 	Unlzx unlzx(fileName, &identificator);
 	
-	return unlzx.extractFile(true, &outFilename);
+	return unlzx.extractFile(true, &outFile);
 }
 
 DecompressorBase* DecompressorLZX::clone()
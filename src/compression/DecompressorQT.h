@@ -51,6 +51,9 @@ public:
 
 	virtual const PPSimpleVector<Descriptor>& getDescriptors(Hints hint) const;
 
+	// QTKit only exports to files, this goes through a temporary one
+	virtual bool decompress(XMFileBase& outFile, Hints hint);
+
 	virtual bool decompress(const PPSystemString& outFilename, Hints hint);
 	
 	virtual DecompressorBase* clone();
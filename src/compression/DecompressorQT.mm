@@ -136,6 +136,38 @@ bool DecompressorQT::decompress(const PPSystemString& outFilename, Hints hint)
 	return res;	
 }
 
+bool DecompressorQT::decompress(XMFileBase& outFile, Hints hint)
+{
+	NSAutoreleasePool* pool = [[NSAutoreleasePool alloc] init];
+	
+	NSString* tempPath = [NSTemporaryDirectory() stringByAppendingPathComponent:[[NSProcessInfo processInfo] globallyUniqueString]];
+	PPSystemString tempFile([tempPath UTF8String]);
+	
+	[pool release];
+	
+	bool res = decompress(tempFile, hint);
+	
+	if (res)
+	{
+		XMFile f(tempFile);
+		
+		pp_uint8 buffer[0x10000];
+		mp_sint32 len;
+		while ((len = f.read(buffer, 1, sizeof(buffer))) > 0)
+		{
+			if (outFile.write(buffer, 1, len) != len)
+			{
+				res = false;
+				break;
+			}
+		}
+	}
+	
+	removeFile(tempFile);
+	
+	return res;
+}
+
 DecompressorBase* DecompressorQT::clone()
 {
 	return new DecompressorQT(fileName);
@@ -65,12 +65,12 @@ const PPSimpleVector<Descriptor>& DecompressorZIP::getDescriptors(Hints hint) co
 	return descriptors;
 }		
 	
-bool DecompressorZIP::decompress(const PPSystemString& outFilename, Hints hint)
+bool DecompressorZIP::decompress(XMFileBase& outFile, Hints hint)
 {
 	ZipExtractor extractor(fileName);
 	
 	pp_int32 error = 0;
-	bool res = extractor.parseZip(error, true, &outFilename);
+	bool res = extractor.parseZip(error, true, &outFile);
 	return (res && error == 0);
 }
 
@@ -610,21 +610,45 @@ void Unlzx::decrunch(struct UnLZX *unlzx)
 	unlzx->global_shift = shift;
 }
 
-XMFile* Unlzx::open_output(const PPSystemString& filename)
+XMFileBase* Unlzx::open_output(struct UnLZX *unlzx)
 {
-	XMFile *file = new XMFile(filename, true);
+	// files are collected in memory until we know whether they're wanted
+	if (unlzx->outFile)
+		return new XMBufferFile();
+
+	XMFile *file = new XMFile(PPSystemString((const char*)unlzx->work_buffer), true);
 	
 	if (!file->isOpenForWriting())
+	{
+		delete file;
 		return NULL;
+	}
 	
 	return(file);
 }
 
+bool Unlzx::close_output(XMFileBase* out_file, struct UnLZX *unlzx, bool keep)
+{
+	bool found = false;
+	
+	if (keep && unlzx->outFile)
+	{
+		XMBufferFile* file = static_cast<XMBufferFile*>(out_file);
+		
+		if (!identificator || identificator->identify(file->getBuffer(), file->size()))
+			found = unlzx->outFile->write(file->getBuffer(), 1, file->size()) == (signed long)file->size();
+	}
+	
+	delete out_file;
+	
+	return found;
+}
+
 signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	found = false;
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned char *pos, *temp;
 	unsigned long count;
 	signed long abort = 0;
@@ -651,12 +675,13 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 			strcpy((char*)unlzx->work_buffer, (char*)node->filename);
 		}
 		fflush(stdout);
-		if (!pmatch((char*)unlzx->match_pattern, (char*)node->filename))
+		// the rest of a merged group still has to be decrunched once we have found something
+		if (!found && !pmatch((char*)unlzx->match_pattern, (char*)node->filename))
 		{
 #ifdef UNLZX_DEBUG
 			printf("Extracting \"%s\"...", (char *)node->filename);
 #endif			
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx);
 		}
 		else
 		{
@@ -741,16 +766,11 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			found = close_output(out_file, unlzx, !abort);
 		}
 	}
 	return(abort);
@@ -759,7 +779,7 @@ signed long Unlzx::extract_normal(XMFile* in_file, struct UnLZX *unlzx, bool& fo
 signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& found)
 {
 	struct filename_node *node;
-	XMFile *out_file = NULL;
+	XMFileBase *out_file = NULL;
 	unsigned long count;
 	signed long abort = 0;
 	
@@ -776,12 +796,12 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 			strcpy((char*)unlzx->work_buffer, (char*)node->filename);
 		}
 		fflush(stdout);
-		if (!pmatch((char*)unlzx->match_pattern, (char*)node->filename))
+		if (!found && !pmatch((char*)unlzx->match_pattern, (char*)node->filename))
 		{
 #ifdef UNLZX_DEBUG
 			printf("Storing \"%s\"...", (char *)node->filename);
 #endif
-			out_file = unlzx->temporaryFile ? open_output(*(unlzx->temporaryFile)) : open_output(PPSystemString((const char*)unlzx->work_buffer));
+			out_file = open_output(unlzx);
 		}
 		else
 		{
@@ -825,16 +845,11 @@ signed long Unlzx::extract_store(XMFile* in_file, struct UnLZX *unlzx, bool& fou
 		}
 		if (out_file)
 		{
-			PPSystemString fileName = out_file->getFileName();
-			delete out_file;
-			if (!abort)
-			{
 #ifdef UNLZX_DEBUG
+			if (!abort)
 				printf(" crc %s\n", (char *)((node->crc == unlzx->sum) ? "good" : "bad"));
 #endif				
-				if (identificator)
-					found = identificator->identify(fileName);
-			}
+			found = close_output(out_file, unlzx, !abort);
 		}
 	}
 	return(abort);
@@ -1323,7 +1338,7 @@ Unlzx::~Unlzx()
 		unlzx_free(unlzx);
 }
 
-bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
+bool Unlzx::extractFile(bool extract, XMFileBase* outFile)
 {
 	int result = 0;
 	
@@ -1332,7 +1347,7 @@ bool Unlzx::extractFile(bool extract, const PPSystemString* outFilename)
 		if (extract)
 		{
 			unlzx->mode = 1;
-			unlzx->temporaryFile = outFilename;
+			unlzx->outFile = outFile;
 			bool found = false;
 			// TODO: make this all type safe
 			result = process_archive(archiveFilename, unlzx, found);
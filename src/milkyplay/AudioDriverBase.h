@@ -88,6 +88,10 @@ public:
 	// start has been called, return true here
 	virtual		bool		supportsTimeQuery() const = 0;
 
+	// return true here if the device can take 32 bit float samples from the 
+	// mixer directly (see MasterMixer::setSampleFormat)
+	virtual		bool		supportsFloatOutput() const = 0;
+
 	// should be kinda unique
 	virtual		const char* getDriverID() = 0;
 
@@ -157,6 +161,8 @@ public:
 	// start has been called, return true here
 	virtual		bool		supportsTimeQuery() const { return false; }
 
+	virtual		bool		supportsFloatOutput() const { return false; }
+
 	// required by wav/null drivers, ignore if you're not writing a wav writer
 	virtual		void		advance() { }
 
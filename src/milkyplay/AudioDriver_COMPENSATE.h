@@ -68,12 +68,18 @@ public:
 		
 		MasterMixer* mixer = this->mixer;
 
-		// Attention: Sample buffer MUST be 16 bit stereo, otherwise this will not work
-		this->sampleCounter+=length>>2;
+		// Attention: Sample buffer MUST be stereo in the mixer's output 
+		// sample format (16 bit or float), otherwise this will not work
+		this->sampleCounter+=length / mixer->getOutputFrameSize();
 		//mixer->updateSampleCounter(length>>2);
 
 		if (isMixerActive())
-			mixer->mixerHandler((mp_sword*)stream);
+		{
+			if (mixer->getOutputSampleFormat() == MasterMixer::SampleFormatFloat32)
+				mixer->mixerHandler((float*)stream);
+			else
+				mixer->mixerHandler((mp_sword*)stream);
+		}
 		else
 			memset(stream, 0, length);
 	}
@@ -40,13 +40,15 @@
 
 AudioDriver_NULL::AudioDriver_NULL() :
 	numSamplesWritten(0),
-	compensateBuffer(0)
+	compensateBuffer(0),
+	compensateBufferFloat(0)
 {
 }
 
 AudioDriver_NULL::~AudioDriver_NULL() 
 {
 	delete[] compensateBuffer;
+	delete[] compensateBufferFloat;
 }
 
 mp_sint32 AudioDriver_NULL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFrequency, MasterMixer* mixer)
@@ -58,7 +60,14 @@ mp_sint32 AudioDriver_NULL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mi
 	numSamplesWritten = 0;
 	
 	delete[] compensateBuffer;
-	compensateBuffer = new mp_sword[bufferSizeInWords];
+	compensateBuffer = NULL;
+	delete[] compensateBufferFloat;
+	compensateBufferFloat = NULL;
+
+	if (mixer->getOutputSampleFormat() == MasterMixer::SampleFormatFloat32)
+		compensateBufferFloat = new float[bufferSizeInWords];
+	else
+		compensateBuffer = new mp_sword[bufferSizeInWords];
 
 	return MP_OK;
 }
@@ -88,11 +97,23 @@ mp_sint32 AudioDriver_NULL::resume()
 	return MP_OK;
 }
 
+void AudioDriver_NULL::truncate(mp_uint32 numFrames)
+{
+	const mp_uint32 bufferFrames = bufferSize / MP_NUMCHANNELS;
+	if (numFrames < bufferFrames)
+		numSamplesWritten-=bufferFrames - numFrames;
+}
+
 void AudioDriver_NULL::advance()
 {
 	numSamplesWritten+=bufferSize / MP_NUMCHANNELS;	
 	
     if (mixer->isPlaying())
-        mixer->mixerHandler(compensateBuffer);	
+	{
+		if (compensateBufferFloat)
+			mixer->mixerHandler(compensateBufferFloat);
+		else
+			mixer->mixerHandler(compensateBuffer);	
+	}
 }
 
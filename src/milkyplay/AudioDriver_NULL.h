@@ -46,6 +46,7 @@ class AudioDriver_NULL : public AudioDriverBase
 protected:
 	mp_uint32	numSamplesWritten;
 	mp_sword*	compensateBuffer;
+	float*		compensateBufferFloat;
 	
 public:
 				AudioDriver_NULL();
@@ -63,10 +64,15 @@ public:
 
 	virtual		mp_uint32	getNumPlayedSamples() const { return numSamplesWritten; };
 
+	virtual		bool		supportsFloatOutput() const { return true; }
+
 	virtual		const char* getDriverID() { return "NULL"; }
 	virtual		mp_sint32	getPreferredBufferSize() const { return 0; }
 
 	virtual		void		advance();
+	// drop the end of the buffer mixed by the last advance(), only its 
+	// first numFrames frames are kept
+	virtual		void		truncate(mp_uint32 numFrames);
 
 };
 
@@ -36,6 +36,7 @@
  */
 
 #include "AudioDriver_WAVWriter.h"
+#include "MasterMixer.h"
 
 struct TWAVHeader
 {
@@ -44,12 +45,12 @@ struct TWAVHeader
 	mp_ubyte WAVE[4];			// "WAVE"
 	mp_ubyte FMT[4];			// "fmt "
 	mp_dword fmtDataLength;		// = 16
-	mp_uword encodingTag;		
+	mp_uword encodingTag;		// 1 = PCM, 3 = IEEE float
 	mp_uword numChannels;		// Channels: 1 = mono, 2 = stereo
 	mp_dword sampleRate;		// Samples per second: e.g., 44100
 	mp_dword bytesPerSecond;	// sample rate * block align
 	mp_uword blockAlign;		// channels * numBits / 8
-	mp_uword numBits;			// 8 or 16
+	mp_uword numBits;			// 8, 16 or 32 (float)
 	mp_ubyte DATA[4];			// "data"
 	mp_dword dataLength;		// sample data size
 };
@@ -80,7 +81,9 @@ static void writeWAVHeader(XMFile* f, const TWAVHeader& hdr)
 WAVWriter::WAVWriter(const SYSCHAR* fileName) :
 	AudioDriver_NULL(),
 	f(NULL),
-	mixFreq(44100)
+	mixFreq(44100),
+	floatOutput(false),
+	numPendingWords(0)
 {
 	TWAVHeader hdr;
 	
@@ -125,6 +128,8 @@ mp_sint32 WAVWriter::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mixFreque
 		return res;
 
 	mixFreq = mixFrequency;
+	floatOutput = compensateBufferFloat != NULL;
+	numPendingWords = 0;
 	return MP_OK;
 }
 
@@ -133,22 +138,24 @@ mp_sint32 WAVWriter::closeDevice()
 	if (!f)
 		return MP_DEVICE_ERROR;
 		
+	writePending();
+
 	TWAVHeader hdr;
 	
 	// build wav header
 	memcpy(hdr.RIFF, "RIFF", 4);
-	hdr.length = 44 + numSamplesWritten*4 - 8;
 	memcpy(hdr.WAVE, "WAVE", 4);
 	memcpy(hdr.FMT, "fmt ", 4);
 	hdr.fmtDataLength = 16;
-	hdr.encodingTag = 1;
+	hdr.encodingTag = floatOutput ? 3 : 1;
 	hdr.numChannels = 2;
 	hdr.sampleRate = mixFreq;
-	hdr.numBits = 16;
+	hdr.numBits = floatOutput ? 32 : 16;
 	hdr.blockAlign = (hdr.numChannels*hdr.numBits) / 8;
 	hdr.bytesPerSecond = hdr.sampleRate*hdr.blockAlign;
 	memcpy(hdr.DATA, "data", 4);
 	hdr.dataLength = (numSamplesWritten*2*hdr.numBits)/8;	
+	hdr.length = 44 + hdr.dataLength - 8;
 		
 	f->seek(0);
 
@@ -157,13 +164,35 @@ mp_sint32 WAVWriter::closeDevice()
 	return MP_OK;
 }
 
+void WAVWriter::writePending()
+{
+	if (!f || !numPendingWords)
+		return;
+	
+	// floats are written as their little endian bit pattern
+	if (compensateBufferFloat)
+		f->writeDwords((mp_dword*)compensateBufferFloat, numPendingWords);
+	else
+		f->writeWords((mp_uword*)compensateBuffer, numPendingWords);
+		
+	numPendingWords = 0;
+}
+
 void WAVWriter::advance()
 {
+	// the buffer is about to be mixed into again
+	writePending();
+
 	AudioDriver_NULL::advance();
 
-	if (!f)
-		return;
+	numPendingWords = bufferSize;
+}
+
+void WAVWriter::truncate(mp_uint32 numFrames)
+{
+	AudioDriver_NULL::truncate(numFrames);
 	
-	f->writeWords((mp_uword*)compensateBuffer, bufferSize);
+	if (numFrames*MP_NUMCHANNELS < numPendingWords)
+		numPendingWords = numFrames*MP_NUMCHANNELS;
 }
 
@@ -46,6 +46,11 @@ class WAVWriter : public AudioDriver_NULL
 private:
 	XMFile*		f;
 	mp_sint32	mixFreq;
+	bool		floatOutput;
+	// the last buffer is only written once it can't be truncated anymore
+	mp_uint32	numPendingWords;
+	
+	void		writePending();
 	
 public:
 				WAVWriter(const SYSCHAR* fileName);
@@ -58,6 +63,7 @@ public:
 	virtual		const char* getDriverID() { return "WAVWriter"; }
 
 	virtual		void		advance();
+	virtual		void		truncate(mp_uint32 numFrames);
 
 	bool					isOpen() { return f != NULL; }
 };
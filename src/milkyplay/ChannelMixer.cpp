@@ -42,17 +42,20 @@
 #include "ResamplerFactory.h"
 #include "ResamplerMacros.h"
 #include "AudioDriverManager.h"
+#include "WorkerPool.h"
+#include "ScopeBuffer.h"
  
 #include "ResamplerYM.h"
 
-
-
-ResamplerYM gResamplerYM;
-bool	    gResamplerYMInitialized = false;
-
 // Ramp out will last (THEBEATLENGTH*RAMPDOWNFRACTION)>>8 samples
 #define RAMPDOWNFRACTION 256
 
+// Concurrent mixing: minimum number of playing channels mixed by one thread
+enum
+{
+	MinChannelsPerGroup = 4
+};
+
 static inline mp_sint32 myMod(mp_sint32 a, mp_sint32 b)
 {
 	mp_sint32 r = a % b;
@@ -112,13 +115,89 @@ void ChannelMixer::panToVol (ChannelMixer::TMixerChannel *chn, mp_sint32 &volL,
 		volL = volR = 0;
 }
 
+void ChannelMixer::addChannelNormal(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength)
+{
+	TMixerChannel* chn = &channel[c];
+
+	switch (chn->flags&(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN|MP_SAMPLE_FADEOFF))
+	{
+	case MP_SAMPLE_FADEOFF:
+	{
+		chn->flags&=~(MP_SAMPLE_PLAY | MP_SAMPLE_FADEOFF);
+		return;
+	}
+
+	case MP_SAMPLE_FADEOUT:
+	{
+		chn->sample = newChannel[c].sample;
+		chn->smplen = newChannel[c].smplen;
+		chn->loopstart = newChannel[c].loopstart;
+		chn->loopend = newChannel[c].loopend;
+		chn->smppos = newChannel[c].smppos;
+		chn->smpposfrac = newChannel[c].smpposfrac;
+		chn->flags = newChannel[c].flags;
+		chn->loopendcopy = newChannel[c].loopendcopy;
+		chn->fixedtime = newChannel[c].fixedtimefrac;
+		chn->fixedtimefrac = newChannel[c].fixedtimefrac;
+		// break is missing here intentionally!!!
+	}
+	default:
+	{
+		panToVol(chn, chn->finalvoll, chn->finalvolr);
+		break;
+	}
+	}
+
+	// mix here
+	addChannelToResampler(resampler,chn, buffer32, beatlength, beatlength);
+}
+
+// adds a channel which was mixed on its own and leaves its mono sum in the scratch buffer
+static inline void addScratchBuffer(mp_sint32* buffer32, mp_sint32* scratch, mp_sint32 beatlength)
+{
+	for (mp_sint32 i = 0; i < beatlength; i++)
+	{
+		const mp_sint32 l = scratch[i*2];
+		const mp_sint32 r = scratch[i*2+1];
+		buffer32[i*2] += l;
+		buffer32[i*2+1] += r;
+		scratch[i] = l + r;
+	}
+}
+
+void ChannelMixer::addChannel(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength, bool ramping, mp_sint32* scratch)
+{
+	mp_sint32* dst = buffer32;
+	
+	if (scratch)
+	{
+		memset(scratch, 0, beatlength*MP_NUMCHANNELS*sizeof(mp_sint32));
+		dst = scratch;
+	}
+
+	if (ramping)
+		addChannelRamping(resampler, c, dst, beatlength);
+	else
+		addChannelNormal(resampler, c, dst, beatlength);
+
+	if (scratch)
+	{
+		addScratchBuffer(buffer32, scratch, beatlength);
+		scopeBuffer->write(c, scratch, beatlength);
+	}
+}
+
 void ChannelMixer::addChannelsNormal(mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
 {
-	ResamplerBase* resampler = resamplerTable[resamplerType];
+	ResamplerBase* resampler = getMixingResampler();
     bool isfirstymchannel = true;
+	const bool concurrent = workerPool && resampler->supportsConcurrentMixing();
+	mp_sint32* scratch = fastForward ? NULL : getScopeScratch(0);
 
 	//assert(numChannels == 7);
 
+	numGroupChannels = 0;
+
 	for (mp_uint32 c=0 ; c < numChannels ; c++) 
 	{
 		TMixerChannel* chn = &channel[c];
@@ -127,64 +206,231 @@ void ChannelMixer::addChannelsNormal(mp_uint32 numChannels, mp_sint32* buffer32,
 		if (!(chn->flags & MP_SAMPLE_PLAY))
         {
 			if (chn->isymchannel == false)
+			{
+				if (scratch)
+					scopeBuffer->writeSilence(c, beatlength);
 				continue;
+			}
         }
 
 		chn->mute = (chn->flags & MP_SAMPLE_MUTE) != 0;
 
 		if (chn->isymchannel)
 		{
+			// all YM channels of this mixer drive its one chip, render it
+			// once right here instead of splitting it across jobs
 			if (ymresampler != NULL)
 			{
 				if (isfirstymchannel)
 				{
-					addChannelToResampler(ymresampler, chn, buffer32, beatlength, beatlength);
+					// the chip has no sample to check, it renders the whole packet
+					if (scratch)
+					{
+						memset(scratch, 0, beatlength*MP_NUMCHANNELS*sizeof(mp_sint32));
+						ymresampler->addBlockNoCheck(scratch, chn, beatlength);
+						addScratchBuffer(buffer32, scratch, beatlength);
+						
+						// the voices can't be told apart, every YM channel shows the chip
+						for (mp_uint32 i = c; i < numChannels; i++)
+							if (channel[i].isymchannel)
+								scopeBuffer->write(i, scratch, beatlength);
+					}
+					else
+					{
+						ymresampler->addBlockNoCheck(buffer32, chn, beatlength);
+					}
 					isfirstymchannel = false;
 				}
 
 				ymresampler->SetMute(chn->ymchannel, chn->mute);
 			}
+			else if (scratch)
+			{
+				scopeBuffer->writeSilence(c, beatlength);
+			}
+		}
+		else if (concurrent)
+		{
+			groupChannels[numGroupChannels++] = c;
 		}
 		else
 		{
-			switch (chn->flags&(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN|MP_SAMPLE_FADEOFF))
-			{
-			case MP_SAMPLE_FADEOFF:
-			{
-				chn->flags&=~(MP_SAMPLE_PLAY | MP_SAMPLE_FADEOFF);
-				continue;
-			}
+			addChannel(resampler, c, buffer32, beatlength, false, scratch);
+		}
+	}
 
-			case MP_SAMPLE_FADEOUT:
-			{
-				chn->sample = newChannel[c].sample;
-				chn->smplen = newChannel[c].smplen;
-				chn->loopstart = newChannel[c].loopstart;
-				chn->loopend = newChannel[c].loopend;
-				chn->smppos = newChannel[c].smppos;
-				chn->smpposfrac = newChannel[c].smpposfrac;
-				chn->flags = newChannel[c].flags;
-				chn->loopendcopy = newChannel[c].loopendcopy;
-				chn->fixedtime = newChannel[c].fixedtimefrac;
-				chn->fixedtimefrac = newChannel[c].fixedtimefrac;
-				// break is missing here intentionally!!!
-			}
-			default:
-			{
-				panToVol(chn, chn->finalvoll, chn->finalvolr);
-				break;
-			}
-			}
+	if (numGroupChannels)
+	{
+		groupRamping = false;
+		addChannelGroups(buffer32, beatlength);
+	}
+}
+
+void ChannelMixer::addChannelRamping(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength)
+{
+	ChannelMixer::TMixerChannel* chn = &channel[c];
+
+	switch (chn->flags&(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN|MP_SAMPLE_FADEOFF))
+	{
+		case MP_SAMPLE_FADEOFF:
+		{
+			mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
+			mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
+
+			if (beatl > maxramp || beatl <= 0)
+				beatl = maxramp;
+			
+			chn->rampFromVolStepL = (-chn->finalvoll)/beatl; 
+			chn->rampFromVolStepR = (-chn->finalvolr)/beatl; 
+			
+			if (beatl)
+				addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
+			chn->flags&=~(MP_SAMPLE_PLAY | MP_SAMPLE_FADEOFF);
+			return;
+		}
+	
+		case MP_SAMPLE_FADEIN:
+		{
+			chn->flags = (chn->flags&~(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN))/*|MP_SAMPLE_FADEIN*/;
+
+			//mp_sint32 beatl = (beatlength*RAMPDOWNFRACTION)>>8;
+			
+			mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
+			mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
 
+			if (beatl > maxramp || beatl <= 0)
+				beatl = maxramp;
+
+			mp_sint32 volL, volR;
+			panToVol(chn, volL, volR);
+			
+			chn->rampFromVolStepL = (volL-chn->finalvoll)/beatl;				
+			chn->rampFromVolStepR = (volR-chn->finalvolr)/beatl;
+			
+			// mix here
+			if (beatl)
+				addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
+
+			//chn->finalvoll = volL;
+			//chn->finalvolr = volR;
+
+			chn->rampFromVolStepL = 0;				
+			chn->rampFromVolStepR = 0;
+			
+			mp_sint32 offset = beatl;
+			
+			beatl = beatlength - beatl;
+			
+			if (beatl)
+				addChannelToResampler(resampler, chn, buffer32+offset*MP_NUMCHANNELS, beatl, beatlength);
+			break;
+		}
+		
+		case MP_SAMPLE_FADEOUT:
+		{
+			mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
+			mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
+
+			if (beatl > maxramp || beatl <= 0)
+				beatl = maxramp;
+			
+			chn->rampFromVolStepL = (0-chn->finalvoll)/beatl;				
+			chn->rampFromVolStepR = (0-chn->finalvolr)/beatl;
+			
+			chn->flags = (chn->flags&~(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN))/*|MP_SAMPLE_FADEIN*/;
+			
+			// for the last active sample we need to retrieve the last active sample rate
+			// which is temporarly stored in newChannel[c]
+			// get it, fill it in and restore the original value later
+			mp_sint32 tmpsmpadd = chn->smpadd;
+			mp_sint32 tmprsmpadd = chn->rsmpadd;
+			mp_sint32 tmpcurrsample = chn->currsample; 
+			mp_sint32 tmpprevsample = chn->prevsample;					
+			mp_sint32 tmpa = chn->a;
+			mp_sint32 tmpb = chn->b;
+			mp_sint32 tmpc = chn->c;
+			chn->smpadd = newChannel[c].smpadd;
+			chn->rsmpadd = newChannel[c].rsmpadd;
+			chn->currsample = newChannel[c].currsample;
+			chn->prevsample = newChannel[c].prevsample;
+			chn->a = newChannel[c].a;
+			chn->b = newChannel[c].b;
+			chn->c = newChannel[c].c;				
+			if (beatl)
+				addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
+			chn->smpadd = tmpsmpadd;
+			chn->rsmpadd = tmprsmpadd;
+			chn->currsample = tmpcurrsample; 
+			chn->prevsample = tmpprevsample;					
+			chn->a = tmpa;
+			chn->b = tmpb;
+			chn->c = tmpc;
+
+			// fade in new sample
+			chn->sample = newChannel[c].sample;
+			chn->smplen = newChannel[c].smplen;
+			chn->loopstart = newChannel[c].loopstart;
+			chn->loopend = newChannel[c].loopend;
+			chn->smppos = newChannel[c].smppos;				
+			chn->smpposfrac = newChannel[c].smpposfrac;
+			chn->flags = newChannel[c].flags;
+			chn->loopendcopy = newChannel[c].loopendcopy;
+			chn->fixedtime = newChannel[c].fixedtimefrac;
+			chn->fixedtimefrac = newChannel[c].fixedtimefrac;
+
+			beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
+
+			if (beatl > maxramp || beatl <= 0)
+				beatl = maxramp;
+			
+			mp_sint32 volL, volR;
+			panToVol(chn, volL, volR);
+
+			chn->rampFromVolStepL = volL/beatl;				
+			chn->rampFromVolStepR = volR/beatl;
+
+			chn->finalvoll = chn->finalvolr = 0;
+
+			if (beatl)
+				addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
+
+			chn->rampFromVolStepL = 0;				
+			chn->rampFromVolStepR = 0;
+			
+			mp_sint32 offset = beatl;
+			
+			beatl = beatlength - beatl;
+			
+			if (beatl)
+				addChannelToResampler(resampler, chn, buffer32+offset*MP_NUMCHANNELS, beatl, beatlength);
+			
+			return;
+		}
+		default:
+		{
+			mp_sint32 volL, volR;
+			panToVol(chn, volL, volR);
+			
+			chn->rampFromVolStepL = (volL-chn->finalvoll)/beatlength;				
+			chn->rampFromVolStepR = (volR-chn->finalvolr)/beatlength;
+			
 			// mix here
 			addChannelToResampler(resampler,chn, buffer32, beatlength, beatlength);
+
+			//chn->finalvoll = volL;
+			//chn->finalvolr = volR;	
+			break;
 		}
 	}
 }
 
 void ChannelMixer::addChannelsRamping(mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength)
 {	
-	ResamplerBase* resampler = resamplerTable[resamplerType];
+	ResamplerBase* resampler = getMixingResampler();
+	const bool concurrent = workerPool && resampler->supportsConcurrentMixing();
+	mp_sint32* scratch = fastForward ? NULL : getScopeScratch(0);
+
+	numGroupChannels = 0;
 
 	for (mp_uint32 c=0;c<numChannels;c++) 
 	{	
@@ -192,161 +438,175 @@ void ChannelMixer::addChannelsRamping(mp_uint32 numChannels, mp_sint32* buffer32
 		chn->index = c;		// For Amiga resampler
 		
 		if (!(chn->flags & MP_SAMPLE_PLAY))
+		{
+			if (scratch)
+				scopeBuffer->writeSilence(c, beatlength);
 			continue;
+		}
 		
-		switch (chn->flags&(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN|MP_SAMPLE_FADEOFF))
+		if (concurrent)
+			groupChannels[numGroupChannels++] = c;
+		else
+			addChannel(resampler, c, buffer32, beatlength, true, scratch);
+	}
+
+	if (numGroupChannels)
+	{
+		groupRamping = true;
+		addChannelGroups(buffer32, beatlength);
+	}
+}
+
+/*
+ * Stands in for the current resampler while fast forwarding. Blocks are 
+ * skipped in one step if the resampler allows it, anything else (full 
+ * checked blocks, the filter history) is left to the resampler itself 
+ * which then mixes into a scratch buffer.
+ */
+class ChannelMixer::ResamplerFastForward : public ChannelMixer::ResamplerBase
+{
+private:
+	ResamplerBase*	resampler;
+	mp_sint32*		scratchBuffer;
+	mp_uint32		scratchBufferSize;
+
+	mp_sint32* getScratchBuffer(mp_uint32 count)
+	{
+		if (count > scratchBufferSize)
 		{
-			case MP_SAMPLE_FADEOFF:
-			{
-				mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
-				mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
-
-				if (beatl > maxramp || beatl <= 0)
-					beatl = maxramp;
-				
-				chn->rampFromVolStepL = (-chn->finalvoll)/beatl; 
-				chn->rampFromVolStepR = (-chn->finalvolr)/beatl; 
-				
-				if (beatl)
-					addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
-				chn->flags&=~(MP_SAMPLE_PLAY | MP_SAMPLE_FADEOFF);
-				continue;
-			}
-		
-			case MP_SAMPLE_FADEIN:
-			{
-				chn->flags = (chn->flags&~(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN))/*|MP_SAMPLE_FADEIN*/;
-
-				//mp_sint32 beatl = (beatlength*RAMPDOWNFRACTION)>>8;
-				
-				mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
-				mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
-
-				if (beatl > maxramp || beatl <= 0)
-					beatl = maxramp;
-
-				mp_sint32 volL, volR;
-				panToVol(chn, volL, volR);
-				
-				chn->rampFromVolStepL = (volL-chn->finalvoll)/beatl;				
-				chn->rampFromVolStepR = (volR-chn->finalvolr)/beatl;
-				
-				// mix here
-				if (beatl)
-					addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
-
-				//chn->finalvoll = volL;
-				//chn->finalvolr = volR;
-
-				chn->rampFromVolStepL = 0;				
-				chn->rampFromVolStepR = 0;
-				
-				mp_sint32 offset = beatl;
-				
-				beatl = beatlength - beatl;
-				
-				if (beatl)
-					addChannelToResampler(resampler, chn, buffer32+offset*MP_NUMCHANNELS, beatl, beatlength);
-				break;
-			}
-			
-			case MP_SAMPLE_FADEOUT:
-			{
-				mp_sint32 maxramp = (beatlength*RAMPDOWNFRACTION)>>8;
-				mp_sint32 beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
-
-				if (beatl > maxramp || beatl <= 0)
-					beatl = maxramp;
-				
-				chn->rampFromVolStepL = (0-chn->finalvoll)/beatl;				
-				chn->rampFromVolStepR = (0-chn->finalvolr)/beatl;
-				
-				chn->flags = (chn->flags&~(MP_SAMPLE_FADEOUT|MP_SAMPLE_FADEIN))/*|MP_SAMPLE_FADEIN*/;
-				
-				// for the last active sample we need to retrieve the last active sample rate
-				// which is temporarly stored in newChannel[c]
-				// get it, fill it in and restore the original value later
-				mp_sint32 tmpsmpadd = chn->smpadd;
-				mp_sint32 tmprsmpadd = chn->rsmpadd;
-				mp_sint32 tmpcurrsample = chn->currsample; 
-				mp_sint32 tmpprevsample = chn->prevsample;					
-				mp_sint32 tmpa = chn->a;
-				mp_sint32 tmpb = chn->b;
-				mp_sint32 tmpc = chn->c;
-				chn->smpadd = newChannel[c].smpadd;
-				chn->rsmpadd = newChannel[c].rsmpadd;
-				chn->currsample = newChannel[c].currsample;
-				chn->prevsample = newChannel[c].prevsample;
-				chn->a = newChannel[c].a;
-				chn->b = newChannel[c].b;
-				chn->c = newChannel[c].c;				
-				if (beatl)
-					addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
-				chn->smpadd = tmpsmpadd;
-				chn->rsmpadd = tmprsmpadd;
-				chn->currsample = tmpcurrsample; 
-				chn->prevsample = tmpprevsample;					
-				chn->a = tmpa;
-				chn->b = tmpb;
-				chn->c = tmpc;
-
-				// fade in new sample
-				chn->sample = newChannel[c].sample;
-				chn->smplen = newChannel[c].smplen;
-				chn->loopstart = newChannel[c].loopstart;
-				chn->loopend = newChannel[c].loopend;
-				chn->smppos = newChannel[c].smppos;				
-				chn->smpposfrac = newChannel[c].smpposfrac;
-				chn->flags = newChannel[c].flags;
-				chn->loopendcopy = newChannel[c].loopendcopy;
-				chn->fixedtime = newChannel[c].fixedtimefrac;
-				chn->fixedtimefrac = newChannel[c].fixedtimefrac;
-
-				beatl = (!(chn->flags & 3)) ? (ChannelMixer::fixedmul(chn->loopend,chn->rsmpadd) >> 1) : maxramp; 
-
-				if (beatl > maxramp || beatl <= 0)
-					beatl = maxramp;
-				
-				mp_sint32 volL, volR;
-				panToVol(chn, volL, volR);
-
-				chn->rampFromVolStepL = volL/beatl;				
-				chn->rampFromVolStepR = volR/beatl;
-
-				chn->finalvoll = chn->finalvolr = 0;
-
-				if (beatl)
-					addChannelToResampler(resampler,chn, buffer32, beatl, beatlength);
-
-				chn->rampFromVolStepL = 0;				
-				chn->rampFromVolStepR = 0;
-				
-				mp_sint32 offset = beatl;
-				
-				beatl = beatlength - beatl;
-				
-				if (beatl)
-					addChannelToResampler(resampler, chn, buffer32+offset*MP_NUMCHANNELS, beatl, beatlength);
-				
-				continue;
-			}
-			default:
-			{
-				mp_sint32 volL, volR;
-				panToVol(chn, volL, volR);
-				
-				chn->rampFromVolStepL = (volL-chn->finalvoll)/beatlength;				
-				chn->rampFromVolStepR = (volR-chn->finalvolr)/beatlength;
-				
-				// mix here
-				addChannelToResampler(resampler,chn, buffer32, beatlength, beatlength);
+			delete[] scratchBuffer;
+			scratchBuffer = new mp_sint32[count*MP_NUMCHANNELS];
+			scratchBufferSize = count;
+		}
+		memset(scratchBuffer, 0, count*MP_NUMCHANNELS*sizeof(mp_sint32));
+		return scratchBuffer;
+	}
+
+public:
+	ResamplerFastForward() :
+		resampler(NULL),
+		scratchBuffer(NULL),
+		scratchBufferSize(0)
+	{
+	}
 	
-				//chn->finalvoll = volL;
-				//chn->finalvolr = volR;	
-				break;
-			}
+	virtual ~ResamplerFastForward()
+	{
+		delete[] scratchBuffer;
+	}
+	
+	void setResampler(ResamplerBase* resampler) { this->resampler = resampler; }
+
+	virtual bool isRamping() { return resampler->isRamping(); }
+	virtual bool supportsFullChecking() { return resampler->supportsFullChecking(); }
+	virtual bool supportsNoChecking() { return resampler->supportsNoChecking(); }
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, TMixerChannel* chn, mp_uint32 count)
+	{
+		// the filter history depends on the sample data
+		if (!resampler->supportsFastForward() ||
+			(chn->cutoff != MP_INVALID_VALUE && chn->resonance != MP_INVALID_VALUE))
+		{
+			resampler->addBlockNoCheck(getScratchBuffer(count), chn, count);
+			return;
 		}
+	
+		const mp_sint32 smpadd = (chn->flags&MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
 		
+		if (resampler->isRamping())
+		{
+			chn->finalvoll += chn->rampFromVolStepL*(mp_sint32)count;
+			chn->finalvolr += chn->rampFromVolStepR*(mp_sint32)count;
+		}
+	}
+	
+	virtual void addBlockFull(mp_sint32* buffer, TMixerChannel* chn, mp_uint32 count)
+	{
+		resampler->addBlockFull(getScratchBuffer(count), chn, count);
+	}
+};
+
+ChannelMixer::ResamplerBase* ChannelMixer::getMixingResampler()
+{
+	ResamplerBase* resampler = resamplerTable[resamplerType];
+	
+	if (!fastForward)
+		return resampler;
+		
+	fastForwardResampler->setResampler(resampler);
+	return fastForwardResampler;
+}
+
+void ChannelMixer::setFastForward(bool fastForward)
+{
+	if (fastForward && fastForwardResampler == NULL)
+		fastForwardResampler = new ResamplerFastForward();
+		
+	this->fastForward = fastForward;
+}
+
+class ChannelMixer::ChannelGroupJob : public WorkerPool::Job
+{
+private:
+	ChannelMixer& mixer;
+
+public:
+	ChannelGroupJob(ChannelMixer& mixer) :
+		mixer(mixer)
+	{
+	}
+
+	virtual void run(mp_uint32 index)
+	{
+		mixer.mixChannelGroup(index);
+	}
+};
+
+void ChannelMixer::mixChannelGroup(mp_uint32 group)
+{
+	ResamplerBase* resampler = resamplerTable[resamplerType];
+	mp_sint32* buffer32 = mixbuffGroups + group*beatPacketSize*MP_NUMCHANNELS;
+	mp_sint32* scratch = fastForward ? NULL : getScopeScratch(group + 1);
+
+	memset(buffer32, 0, groupBeatLength*MP_NUMCHANNELS*sizeof(mp_sint32));
+
+	// channels are dealt out round robin
+	for (mp_uint32 i = group; i < numGroupChannels; i+=numActiveChannelGroups)
+		addChannel(resampler, groupChannels[i], buffer32, groupBeatLength, groupRamping, scratch);
+}
+
+void ChannelMixer::addChannelGroups(mp_sint32* buffer32, mp_sint32 beatlength)
+{
+	// not worth waking up other threads
+	if (numGroupChannels < MinChannelsPerGroup*2)
+	{
+		ResamplerBase* resampler = resamplerTable[resamplerType];
+		mp_sint32* scratch = fastForward ? NULL : getScopeScratch(0);
+		for (mp_uint32 i = 0; i < numGroupChannels; i++)
+			addChannel(resampler, groupChannels[i], buffer32, beatlength, groupRamping, scratch);
+		return;
+	}
+
+	mp_uint32 numGroups = numGroupChannels / MinChannelsPerGroup;
+	if (numGroups > numChannelGroups)
+		numGroups = numChannelGroups;
+
+	numActiveChannelGroups = numGroups;
+	groupBeatLength = beatlength;
+	
+	ChannelGroupJob job(*this);
+	workerPool->runRealtime(job, numGroups);
+
+	// sum up the accumulators in a fixed order
+	const mp_sint32 count = beatlength*MP_NUMCHANNELS;
+	for (mp_uint32 g = 0; g < numGroups; g++)
+	{
+		const mp_sint32* src = mixbuffGroups + g*beatPacketSize*MP_NUMCHANNELS;
+		mp_sint32* dst = buffer32;
+		for (mp_sint32 i = 0; i < count; i++)
+			dst[i] += src[i];
 	}
 }
 
@@ -560,12 +820,19 @@ void ChannelMixer::setFrequency(mp_sint32 frequency)
 	
 	mixbuffBeatPacket = new mp_sint32[beatPacketSize*MP_NUMCHANNELS];
 	
+	// group accumulators are beat packet sized too
+	lastGroupBeatPacketSize = 0;
+	
 	// channels contain information based on beatPacketSize so this might
 	// have been changed
 	reallocChannels();
 	
 	if (resamplerType != MixerSettings::MIXER_INVALID && resamplerTable[resamplerType])
 		resamplerTable[resamplerType]->setFrequency(frequency);
+
+	// not in the mixer callback, where the filters are set
+	if (allowFilters)
+		buildFilterTables();
 }
 
 void ChannelMixer::reallocChannels()
@@ -589,10 +856,100 @@ void ChannelMixer::reallocChannels()
 	
 	mixerLastNumAllocatedChannels = mixerNumAllocatedChannels;
 
+	reallocChannelGroups();
+	reallocScopeBuffer();
+
 	if (resamplerType != MixerSettings::MIXER_INVALID && resamplerTable[resamplerType])
 		resamplerTable[resamplerType]->setNumChannels(mixerNumAllocatedChannels);
 }
 
+void ChannelMixer::reallocChannelGroups()
+{
+	const mp_uint32 numGroups = workerPool ? workerPool->getConcurrency() : 0;
+	
+	if (numGroups != numChannelGroups || beatPacketSize != lastGroupBeatPacketSize)
+	{
+		delete[] mixbuffGroups;
+		mixbuffGroups = numGroups ? new mp_sint32[numGroups*beatPacketSize*MP_NUMCHANNELS] : NULL;
+		numChannelGroups = numGroups;
+		lastGroupBeatPacketSize = beatPacketSize;
+	}
+	
+	delete[] groupChannels;
+	groupChannels = numGroups ? new mp_uint32[mixerNumAllocatedChannels] : NULL;
+	numGroupChannels = 0;
+	
+	if (scopeBuffer)
+	{
+		delete[] scopeScratch;
+		scopeScratch = new mp_sint32[(numGroups+1)*beatPacketSize*MP_NUMCHANNELS];
+	}
+}
+
+void ChannelMixer::reallocScopeBuffer()
+{
+	if (scopeBuffer == NULL)
+		return;
+		
+	// readers look up to one buffer back from the one being played, 
+	// which itself is followed by the rest of the last beat packet
+	scopeBuffer->resize(mixerNumAllocatedChannels, mixBufferSize*2 + beatPacketSize, beatPacketSize);
+}
+
+void ChannelMixer::setScopeBufferEnabled(bool enabled)
+{
+	if (enabled == (scopeBuffer != NULL))
+		return;
+		
+	if (enabled)
+	{
+		scopeBuffer = new ScopeBuffer();
+		reallocChannelGroups();
+		reallocScopeBuffer();
+	}
+	else
+	{
+		delete scopeBuffer;
+		scopeBuffer = NULL;
+		delete[] scopeScratch;
+		scopeScratch = NULL;
+	}
+}
+
+mp_sint32* ChannelMixer::getScopeScratch(mp_uint32 slot) const
+{
+	return scopeScratch ? scopeScratch + slot*beatPacketSize*MP_NUMCHANNELS : NULL;
+}
+
+void ChannelMixer::addScopeSilence(mp_sint32 beatlength)
+{
+	for (mp_uint32 c = 0; c < mixerNumActiveChannels; c++)
+		scopeBuffer->writeSilence(c, beatlength);
+}
+
+bool ChannelMixer::grabScopeData(mp_uint32 c, mp_sint32 smpPos, mp_sint32* buffer, mp_uint32 count) const
+{
+	if (scopeBuffer == NULL || !startPlay)
+		return false;
+
+	if (smpPos < 0)
+		smpPos = 0;
+	if (smpPos > (mp_sint32)mixBufferSize)
+		smpPos = mixBufferSize;
+
+	const mp_int64 endFrame = scopeBuffer->getTimeStamp() - mixBufferSize + smpPos;
+	return scopeBuffer->read(c, endFrame, buffer, count);
+}
+
+void ChannelMixer::setWorkerPool(WorkerPool* workerPool)
+{
+	if (this->workerPool == workerPool)
+		return;
+		
+	this->workerPool = workerPool;
+	reallocChannelGroups();
+}
+
 void ChannelMixer::clearChannels()
 {
 	for (mp_uint32 i = 0; i < mixerNumAllocatedChannels; i++)
@@ -605,7 +962,7 @@ void ChannelMixer::clearChannels()
 ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 						   mp_uint32 frequency, 
 						   MixerSettings::ResamplerTypes resampleTypes,
-						   bool		 mainplayer) :
+						   bool		 emulateYM) :
 	mixerNumAllocatedChannels(numChannels),
 	mixerNumActiveChannels(numChannels),
 	mixerLastNumAllocatedChannels(0),
@@ -618,8 +975,25 @@ ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 	paused(false),
 	disableMixing(false),
 	allowFilters(false),
+	fastForward(false),
+	fastForwardResampler(NULL),
+	workerPool(NULL),
+	mixbuffGroups(NULL),
+	numChannelGroups(0),
+	numActiveChannelGroups(0),
+	lastGroupBeatPacketSize(0),
+	groupChannels(NULL),
+	numGroupChannels(0),
+	groupRamping(false),
+	groupBeatLength(0),
+	scopeBuffer(NULL),
+	scopeScratch(NULL),
+	filterInvAngles(NULL),
+	filterLosses(NULL),
+	filterTableFrequency(0),
 	initialized(false),
 	sampleCounter(0),
+	timerSampleCounter(0),
 	ymresampler(NULL)
 {	
 	memset(resamplerTable, 0, sizeof(resamplerTable));
@@ -638,21 +1012,8 @@ ChannelMixer::ChannelMixer(mp_uint32 numChannels,
 
 	setResamplerType(resampleTypes);
 
-	if (mainplayer)
-	{
-		assert(gResamplerYMInitialized == false);
-		gResamplerYMInitialized = true;
-
-		bool init = gResamplerYM.Init();
-		if (init == false)
-		{
-			char message[512] = "Cannot init resampler YM\n";
-			strcat(message, gResamplerYM.GetError());
-			throw ErrorInfo(message, true);	 
-		}
-		assert(init);
-		ymresampler = &gResamplerYM;
-	}
+	if (emulateYM)
+		ymresampler = new ResamplerYM();
 
 	setBufferSize(MixerSettings::BUFFERSIZE_DEFAULT);
 
@@ -678,6 +1039,18 @@ ChannelMixer::~ChannelMixer()
 	if (newChannel) 
 		delete[] newChannel;
 	
+	delete[] mixbuffGroups;
+	delete[] groupChannels;
+	
+	delete scopeBuffer;
+	delete[] scopeScratch;
+	
+	delete[] filterInvAngles;
+	delete[] filterLosses;
+	
+	delete fastForwardResampler;
+	delete ymresampler;
+	
 	for (mp_uint32 i = 0; i < sizeof(resamplerTable) / sizeof(ResamplerBase*); i++)
 		delete resamplerTable[i];
 }
@@ -754,7 +1127,14 @@ void ChannelMixer::setActiveChannels(mp_uint32 num)
 // Default lo precision calculations
 void ChannelMixer::setChannelFrequency(mp_sint32 c, mp_sint32 f)
 {
-	channel[c].smpadd = ((mp_sint32)(((mp_int64)((mp_int64)f*(mp_int64)rMixFrequency))>>15))<<0; 
+	mp_sint32 smpadd = ((mp_sint32)(((mp_int64)((mp_int64)f*(mp_int64)rMixFrequency))>>15))<<0; 
+	
+	// the player sets the frequency every tick, most of the time it
+	// didn't change and the reciprocal is still valid
+	if (smpadd == channel[c].smpadd)
+		return;
+	
+	channel[c].smpadd = smpadd;
 	
 	if (channel[c].smpadd)
 		channel[c].rsmpadd = 0xFFFFFFFF/channel[c].smpadd;
@@ -762,6 +1142,48 @@ void ChannelMixer::setChannelFrequency(mp_sint32 c, mp_sint32 f)
 		channel[c].rsmpadd = 0;			
 }
 
+// Thanks to DUMB for the filter coefficient computations	
+static inline float calcFilterInvAngle(mp_uint32 mixFrequency, mp_sint32 cutoff)
+{
+	const mp_sint32 IT_ENVELOPE_SHIFT = 8;
+	
+	float sampfreq = float(mixFrequency);
+	return (float)(sampfreq * pow(0.5, 0.25 + cutoff*(1.0/(24<<IT_ENVELOPE_SHIFT))) * (1.0/(2*3.14159265358979323846*110.0)));
+}
+
+static inline float calcFilterLoss(mp_sint32 resonance)
+{
+	const float LOG10 = 2.30258509299f;
+
+	return (float)exp(resonance*(-LOG10*1.2/128.0));
+}
+
+void ChannelMixer::buildFilterTables()
+{
+	if (filterLosses == NULL)
+	{
+		filterLosses = new float[MP_FILTERRESONANCES];
+		for (mp_sint32 i = 0; i < MP_FILTERRESONANCES; i++)
+			filterLosses[i] = calcFilterLoss(i);
+	}
+	
+	if (filterInvAngles == NULL)
+		filterInvAngles = new float[MP_FILTERCUTOFFS];
+	
+	for (mp_sint32 i = 0; i < MP_FILTERCUTOFFS; i++)
+		filterInvAngles[i] = calcFilterInvAngle(mixFrequency, i);
+	
+	filterTableFrequency = mixFrequency;
+}
+
+void ChannelMixer::setAllowFilters(bool allowFilters)
+{
+	if (allowFilters && filterTableFrequency != mixFrequency)
+		buildFilterTables();
+
+	this->allowFilters = allowFilters;
+}
+
 void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint32 resonance)
 {
 	if (!allowFilters ||
@@ -775,16 +1197,15 @@ void ChannelMixer::setFilterAttributes(mp_sint32 chn, mp_sint32 cutoff, mp_sint3
 	if (cutoff == MP_INVALID_VALUE || resonance == MP_INVALID_VALUE)
 		return;
 
-	// Thanks to DUMB for the filter coefficient computations	
-	const float LOG10 = 2.30258509299f;
-	const mp_sint32 IT_ENVELOPE_SHIFT = 8;
-	
+	// the tables are built with the mix frequency or when filters are allowed
+	const bool tables = filterTableFrequency == mixFrequency;
+
 	float a, b, c;
 	{
-		float sampfreq = float(this->mixFrequency);
-	
-		float inv_angle = (float)(sampfreq * pow(0.5, 0.25 + cutoff*(1.0/(24<<IT_ENVELOPE_SHIFT))) * (1.0/(2*3.14159265358979323846*110.0)));
-		float loss = (float)exp(resonance*(-LOG10*1.2/128.0));
+		float inv_angle = (tables && cutoff >= 0 && cutoff < MP_FILTERCUTOFFS) ? 
+			filterInvAngles[cutoff] : calcFilterInvAngle(mixFrequency, cutoff);
+		float loss = (tables && resonance >= 0 && resonance < MP_FILTERRESONANCES) ? 
+			filterLosses[resonance] : calcFilterLoss(resonance);
 		float d, e;
 #if 0
 		loss *= 2; // This is the mistake most players seem to make!
@@ -1026,6 +1447,7 @@ static inline void storeTimeRecordData(mp_sint32 nb, ChannelMixer::TMixerChannel
 
 void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 {
+	const mp_int64 bufferSampleCounter = sampleCounter;
 	updateSampleCounter(bufferSize);
 	
 	if (!isPlaying())
@@ -1075,6 +1497,7 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 	{
 		const mp_sint32 numbeats = /*numBeatPackets*/mixSize / beatLength;
 
+		const mp_int64 firstBeatSampleCounter = bufferSampleCounter + done;
 		done += numbeats * beatLength;
 
 		mp_sint32 nb;
@@ -1118,9 +1541,17 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 				}
 			}
 
+			timerSampleCounter = firstBeatSampleCounter + nb * beatLength;
 			timer(nb);
 
-			if (!disableMixing)
+			// the beat packet buffer is a scratch buffer for full beats,
+			// the YM2149 can't be skipped and still mixes into it
+			if (fastForward)
+			{
+				memset(mixbuffBeatPacket, 0, beatLength*MP_NUMCHANNELS * sizeof(mp_sint32));
+				addChannels(mixerNumActiveChannels, mixbuffBeatPacket, nb, beatLength);
+			}
+			else if (!disableMixing)
 			{
 				// do some in between state recording 
 				// to be able to show smooth updates even if the buffer is large
@@ -1129,6 +1560,13 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 
 				addChannels(mixerNumActiveChannels, buffer + nb * beatLength*MP_NUMCHANNELS, nb, beatLength);
 			}
+			
+			if (scopeBuffer)
+			{
+				if (fastForward || disableMixing)
+					addScopeSilence(beatLength);
+				scopeBuffer->advance(beatLength);
+			}
 		}
 
 		buffer += numbeats * beatLength*MP_NUMCHANNELS;
@@ -1172,9 +1610,14 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 				}
 			}
 
+			timerSampleCounter = bufferSampleCounter + done;
 			timer(numbeats);
 
-			if (!disableMixing)
+			if (fastForward)
+			{
+				addChannels(mixerNumActiveChannels, mixbuffBeatPacket, numbeats, beatLength);
+			}
+			else if (!disableMixing)
 			{
 				// do some in between state recording 
 				// to be able to show smooth updates even if the buffer is large
@@ -1184,6 +1627,13 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 				addChannels(mixerNumActiveChannels, mixbuffBeatPacket, numbeats, beatLength);
 			}
 
+			if (scopeBuffer)
+			{
+				if (fastForward || disableMixing)
+					addScopeSilence(beatLength);
+				scopeBuffer->advance(beatLength);
+			}
+
 			mp_sint32 todo = mixBufferSize - done;
 
 			if (todo)
@@ -1198,6 +1648,10 @@ void ChannelMixer::mix(mp_sint32* mixbuff32, mp_uint32 bufferSize)
 		}
 	}
 	
+	// the rest of the last beat packet is played with the next buffer
+	if (scopeBuffer)
+		scopeBuffer->setTimeStamp(scopeBuffer->getWritePosition() - lastBeatRemainder);
+	
 	/*static FILE* hfile = NULL;
 
 	if (hfile == NULL)
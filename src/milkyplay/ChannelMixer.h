@@ -51,7 +51,7 @@
 
 #define MP_INCREASESMPPOS(intpart, fracpart, fp, fractbits)	\
 	intpart+=((fp)>>(fractbits)); \
-	fracpart+=((fp)&(1<<(fractbits))-1); \
+	fracpart+=((fp)&((1<<(fractbits))-1)); \
 	if (((fracpart)>>(fractbits))==1) \
 	{ \
 		intpart++; \
@@ -80,6 +80,8 @@ class ChannelMixer;
 typedef void (ChannelMixer::*TSetFreq)(mp_sint32 c, mp_sint32 f);
 
 class ResamplerYM;
+class WorkerPool;
+class ScopeBuffer;
 
 struct MixerSettings
 {
@@ -135,7 +137,17 @@ public:
 		MP_SAMPLE_BACKWARD	= 128,
 		
 		MP_INVALID_VALUE	= 0x7FFFFFFF,
-		MP_FILTERPRECISION	= 8		
+		MP_FILTERPRECISION	= 8,
+		
+		// range of the IT filter parameters (cutoff carries 8 bits of envelope precision)
+		MP_FILTERCUTOFFS	= 128 << 8,
+		MP_FILTERRESONANCES	= 128,
+		
+		// levels of the Atari voices: a DMA channel is mixed into its side
+		// at MP_DMAAMPLIFY/256 of the sample (ResamplerBLS), the YM chip 
+		// into both sides at MP_YMAMPLIFY/64 = full level (ResamplerYM)
+		MP_DMAAMPLIFY		= 44,
+		MP_YMAMPLIFY		= 64
 	};
 
 	static inline mp_sint32 fixedmul(mp_sint32 a,mp_sint32 b) { return MP_FP_MUL(a,b); }
@@ -372,6 +384,13 @@ public:
 		virtual bool supportsNoChecking() = 0;
 		// optional: if this resampler is able to perform a full checked walk along the sample
 		virtual bool supportsFullChecking() = 0;
+		// if this resampler keeps all of its state in the channel it can be used
+		// to mix several channels at the same time from different threads
+		virtual bool supportsConcurrentMixing() { return false; }
+		// if the non-checking block add does nothing to the channel but walking 
+		// along the sample (and adding the ramp steps to the final volumes when 
+		// ramping) the channel can be fast forwarded without touching the sample
+		virtual bool supportsFastForward() { return false; }
 		
 		// see above, you will need to implement at least one of the following
 		virtual void addBlockNoCheck(mp_sint32* buffer, TMixerChannel* chn, mp_uint32 count) 
@@ -421,12 +440,55 @@ private:
 	bool			paused;
 	bool			disableMixing;
 	bool			allowFilters;
+	bool			fastForward;
+	
+	class ResamplerFastForward;
+	ResamplerFastForward* fastForwardResampler;
+
+	// optional concurrent mixing, the channels are split into groups
+	// which are mixed into their own beat packet accumulator and summed
+	// up in group order afterwards
+	WorkerPool*		workerPool;
+	mp_sint32*		mixbuffGroups;
+	mp_uint32		numChannelGroups;
+	mp_uint32		numActiveChannelGroups;
+	mp_uint32		lastGroupBeatPacketSize;
+	mp_uint32*		groupChannels;			// channels handed over to the worker pool
+	mp_uint32		numGroupChannels;
+	bool			groupRamping;
+	mp_sint32		groupBeatLength;
+	
+	class ChannelGroupJob;
+	friend class ChannelGroupJob;
+
+	// optional copy of what every channel contributed to the mix, the channels
+	// are mixed into a scratch beat packet first (one for the calling thread 
+	// and one per channel group) and added to the mix from there
+	ScopeBuffer*	scopeBuffer;
+	mp_sint32*		scopeScratch;
+
+	// the cutoff and resonance dependent terms of the filter coefficients,
+	// built for the current mix frequency while filters are allowed
+	float*			filterInvAngles;
+	float*			filterLosses;
+	mp_uint32		filterTableFrequency;
 
 	void			setFrequency(mp_sint32 frequency);
+	void			buildFilterTables();
 	
+	ResamplerBase*	getMixingResampler();
 	void			addChannels(mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);
 	void		    addChannelsNormal(mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
 	void			addChannelsRamping(mp_uint32 numChannels, mp_sint32* buffer32,mp_sint32 beatNum, mp_sint32 beatlength);		
+	void			addChannelNormal(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength);
+	void			addChannelRamping(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength);
+	void			addChannel(ResamplerBase* resampler, mp_uint32 c, mp_sint32* buffer32, mp_sint32 beatlength, bool ramping, mp_sint32* scratch);
+	void			addChannelGroups(mp_sint32* buffer32, mp_sint32 beatlength);
+	void			mixChannelGroup(mp_uint32 group);
+	void			reallocChannelGroups();
+	void			reallocScopeBuffer();
+	void			addScopeSilence(mp_sint32 beatlength);
+	mp_sint32*		getScopeScratch(mp_uint32 slot) const;
 	
 	inline void		timer(mp_uint32 beatIndex)
 	{
@@ -444,9 +506,12 @@ public:
 					ChannelMixer(mp_uint32 numChannels, 
 								 mp_uint32 frequency, 
 								 MixerSettings::ResamplerTypes resampleTypes,
-								 bool mainplayer);				
+								 bool emulateYM);				
 	
 	virtual			~ChannelMixer();
+
+	// the mixer's own YM2149, NULL unless it was created with emulateYM
+	ResamplerYM*	getYMResampler() const { return ymresampler; }
 	
 	static void		addChannelToResampler(ResamplerBase* resampler, TMixerChannel* chn, mp_sint32* buffer32, const mp_sint32 beatlength, const mp_sint32 beatSize);		
 
@@ -463,9 +528,31 @@ public:
 	mp_sint32		resume();
 	
 	void			setDisableMixing(bool disableMixing) { this->disableMixing = disableMixing; }
-	void			setAllowFilters(bool allowFilters) { this->allowFilters = allowFilters; }
+	
+	// unlike disableMixing, which freezes the channels, fast forwarding 
+	// advances all channels exactly like mixing would but leaves the buffer 
+	// alone. The beat packet which is split across two buffers is not mixed 
+	// either, so the last buffer before switching back has to be mixed 
+	// normally to resume sample exactly.
+	void			setFastForward(bool fastForward);
+	bool			isFastForward() const { return fastForward; }
+	
+	// pass a worker pool to mix the channels concurrently (the pool is not owned),
+	// NULL mixes all channels on the calling thread
+	void			setWorkerPool(WorkerPool* workerPool);
+	WorkerPool*		getWorkerPool() const { return workerPool; }
+	void			setAllowFilters(bool allowFilters);
 	bool			getAllowFilters() const { return allowFilters; }
 
+	// keep the output of every channel around for scopes, costs an extra 
+	// pass over each mixed beat packet
+	void			setScopeBufferEnabled(bool enabled);
+	const ScopeBuffer* getScopeBuffer() const { return scopeBuffer; }
+	
+	// copies the count frames of channel c which were mixed before the frame 
+	// at smpPos of the buffer being played, false if there are none
+	bool			grabScopeData(mp_uint32 c, mp_sint32 smpPos, mp_sint32* buffer, mp_uint32 count) const;
+
 	void			resetChannelsFull();
 	void			resetChannelsWithoutMuting();
 	
@@ -506,6 +593,7 @@ protected:
 	bool			startPlay;
 
 	mp_int64		sampleCounter;			// number of samples played (per song)
+	mp_int64		timerSampleCounter;		// sample counter at the start of the beat packet the timer is called for
 
 	void			startMixer() 
 	{
@@ -1363,19 +1363,19 @@ static void IfCopySndSynthYMFile(const SYSCHAR* _filename)
 
 	if (XMFile::exists(path) == false)
 	{
-		const char* ymfilename = ResamplerYM::GetInstance()->GetSndSynFilename();
+		const char* ymfilename = ResamplerYM::GetSndSynFilename();
 
 		if ((ymfilename != nullptr) && (ymfilename[0] != 0))
 		{
 			void* temp = nullptr;
 			size_t size = 0;
 
-			FILE* file = fopen(ResamplerYM::GetInstance()->GetSndSynFilename(), "rb");
+			FILE* file = fopen(ResamplerYM::GetSndSynFilename(), "rb");
 			if (file == nullptr)
 			{
 				char message[512];
 
-				sprintf(message, "Cannot open YM bank %s file for read", ResamplerYM::GetInstance()->GetSndSynFilename());
+				sprintf(message, "Cannot open YM bank %s file for read", ResamplerYM::GetSndSynFilename());
 				throw ErrorInfo(message);
 			}
 
@@ -1406,12 +1406,31 @@ static void IfCopySndSynthYMFile(const SYSCHAR* _filename)
 				fclose(file);
 			}
 
-			ResamplerYM::GetInstance()->SetSndSynFilename(path);
+			ResamplerYM::SetSndSynFilename(path);
 		}
 	}
 }
 
 mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName)
+{
+	{
+	XMFile f(fileName, true);
+	
+	if (!f.isOpenForWriting())
+		return MP_DEVICE_ERROR;
+
+	mp_sint32 res = saveExtendedModule(f);
+	if (res != MP_OK)
+		return res;
+
+	} // close file
+
+	IfCopySndSynthYMFile(fileName);
+
+	return MP_OK;
+}
+
+mp_sint32 XModule::saveExtendedModule(XMFileBase& f)
 {
 	mp_sint32 i,j,k,l;
 	
@@ -1433,11 +1452,6 @@ mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName)
 	
 	{
 	// ------ start ---------------------------------
-	XMFile f(fileName, true);
-	
-	if (!f.isOpenForWriting())
-		return MP_DEVICE_ERROR;
-
 	f.write("Extended Module: ",1,17);
 	
 	char titleBuffer[MP_MAXTEXT+1], titleBufferTemp[MP_MAXTEXT+1];
@@ -1499,21 +1513,24 @@ mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName)
 		
 		mp_sint32 channum = srcPattern->channum >= header.channum ? header.channum : srcPattern->channum;
 		
-		for (mp_sint32 rows = 0; rows < srcPattern->rows; rows++)
-			for (mp_sint32 c = 0;  c < channum; c++)
-			{
+		// empty cells don't change anything here
+		mp_sint32 rows = 0, c = 0;
+		for (; srcPattern->getNextCell(rows, c); c++)
+		{
+			if (c >= channum)
+				continue;
 				
-				mp_ubyte* srcSlot = srcPattern->patternData+(rows*(srcPattern->channum*(srcPattern->effnum*2+2)) + c*(srcPattern->effnum*2+2));
-			
-				if (srcSlot[1])
-					lastIns[c] = srcSlot[1];
-			
-				if (lastIns[c] && srcSlot[0] && srcSlot[0] < XModule::NOTE_OFF)
-				{
-					if (srcSlot[0] > upperNoteBound[lastIns[c]-1]) upperNoteBound[lastIns[c]-1] = srcSlot[0];
-					if (srcSlot[0] < lowerNoteBound[lastIns[c]-1]) lowerNoteBound[lastIns[c]-1] = srcSlot[0];						
-				}
+			mp_ubyte* srcSlot = srcPattern->patternData+(rows*(srcPattern->channum*(srcPattern->effnum*2+2)) + c*(srcPattern->effnum*2+2));
+		
+			if (srcSlot[1])
+				lastIns[c] = srcSlot[1];
+		
+			if (lastIns[c] && srcSlot[0] && srcSlot[0] < XModule::NOTE_OFF)
+			{
+				if (srcSlot[0] > upperNoteBound[lastIns[c]-1]) upperNoteBound[lastIns[c]-1] = srcSlot[0];
+				if (srcSlot[0] < lowerNoteBound[lastIns[c]-1]) lowerNoteBound[lastIns[c]-1] = srcSlot[0];						
 			}
+		}
 				
 	}
 	
@@ -1888,9 +1905,7 @@ mp_sint32 XModule::saveExtendedModule(const SYSCHAR* fileName)
 	
 	}
 
-	} // close file
-
-	IfCopySndSynthYMFile(fileName);
+	}
 
 	return MP_OK;
 }
@@ -2338,6 +2353,8 @@ bool TXMPattern::loadExtendedPattern(const SYSCHAR* fileName)
 	
 	
 	delete[] srcPattern;	
+	
+	setDirty();
 		
 	return true;
 }
@@ -2413,6 +2430,8 @@ bool TXMPattern::loadExtendedTrack(const SYSCHAR* fileName, mp_uint32 channel)
 	}
 	
 	delete[] srcPattern;	
+	
+	setDirty();
 		
 	return true;
 }
@@ -2431,20 +2450,7 @@ mp_sint32 XModule::getNumUsedPatterns()
 		if (pattern->patternData == NULL)
 			continue;
 			
-		mp_sint32 slotSize = pattern->effnum * 2 + 2;
-		
-		mp_sint32 patternSize = slotSize * pattern->channum * pattern->rows;
-		
-		bool empty = true;
-		for (mp_sint32 j = 0; j < patternSize; j++)
-			if (pattern->patternData[j])
-			{
-				empty = false;
-				patNum = i+1;
-				break;
-			}
-		
-		if (empty)
+		if (pattern->isEmpty())
 		{
 			bool found = false;
 			for (mp_sint32 j = 0; j < header.ordnum; j++)
@@ -524,6 +524,11 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 	if (header->smpnum > 256)
 		header->smpnum = 256;
 	
+	// packed samples are decompressed after all headers have been read,
+	// they don't depend on each other and can be done concurrently
+	XModule::TSampleLocation packedSamples[256];
+	mp_uint32 numPackedSamples = 0;
+	
 	// read samples
 	for (i = 0; i < header->smpnum; i++)
 	{
@@ -633,10 +638,11 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 
 				if (itSmp.Flg & 8)
 				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT))
-					{
-						return MP_OUT_OF_MEMORY;
-					}
+					XModule::TSampleLocation& location = packedSamples[numPackedSamples++];
+					location.offset = itSmp.SmpPoint;
+					location.buffer = smp[i].sample;
+					location.size = location.length = smp[i].samplen;
+					location.flags = (itSmp.Cvt & 4) ? XModule::ST_PACKING_IT215 : XModule::ST_PACKING_IT;
 				}
 				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen,smp[i].samplen, (itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED))
 				{
@@ -654,10 +660,11 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 
 				if (itSmp.Flg & 8)
 				{
-					if (!module->loadSample(f, smp[i].sample, smp[i].samplen, smp[i].samplen, (itSmp.Cvt & 4) ? (XModule::ST_PACKING_IT215 | XModule::ST_16BIT) : (XModule::ST_PACKING_IT | XModule::ST_16BIT)))
-					{
-						return MP_OUT_OF_MEMORY;
-					}
+					XModule::TSampleLocation& location = packedSamples[numPackedSamples++];
+					location.offset = itSmp.SmpPoint;
+					location.buffer = smp[i].sample;
+					location.size = location.length = smp[i].samplen;
+					location.flags = (itSmp.Cvt & 4) ? (XModule::ST_PACKING_IT215 | XModule::ST_16BIT) : (XModule::ST_PACKING_IT | XModule::ST_16BIT);
 				}
 				else if (!module->loadSample(f,smp[i].sample,smp[i].samplen<<1,smp[i].samplen, XModule::ST_16BIT | ((itSmp.Cvt & 1) ? XModule::ST_DEFAULT : XModule::ST_UNSIGNED)))
 				{
@@ -667,6 +674,9 @@ mp_sint32 LoaderIT::load(XMFileBase& f, XModule* module)
 		}
 	}
 
+	if (!module->loadSamples(f, packedSamples, numPackedSamples))
+		return MP_OUT_OF_MEMORY;
+
 	if (!(flags & 4))
 		header->insnum = header->smpnum;
 	/*else
@@ -39,6 +39,7 @@
 #include "MilkyPlayCommon.h"
 #include "AudioDriverBase.h"
 #include "AudioDriverManager.h"
+#include "WorkerPool.h"
 
 enum
 {
@@ -54,10 +55,19 @@ MasterMixer::MasterMixer(mp_uint32 sampleRate,
 	bufferSize(bufferSize),
 	buffer(0),
 	sampleShift(0),
+	sampleFormat(SampleFormatInt16),
+	outputSampleFormat(SampleFormatInt16),
 	disableMixing(false),
 	numDevices(numDevices),
 	filterHook(0),
+	workerPool(0),
 	devices(new DeviceDescriptor[numDevices]),
+	activeDevices(new DeviceDescriptor*[numDevices]),
+	numActiveDevices(0),
+	scratchBuffers(0),
+	cyclesStarted(0),
+	cyclesCompleted(0),
+	numWaiting(0),
 	audioDriverManager(0),
 	audioDriver(audioDriver),
 	initialized(false),
@@ -71,6 +81,7 @@ MasterMixer::~MasterMixer()
 	cleanup();
 
 	delete audioDriverManager;
+	delete[] activeDevices;
 	delete[] devices;
 }
 
@@ -100,14 +111,17 @@ mp_sint32 MasterMixer::openAudioDevice()
 		
 	cleanup();
 	
+	outputSampleFormat = (sampleFormat == SampleFormatFloat32 && audioDriver->supportsFloatOutput()) ? 
+		SampleFormatFloat32 : SampleFormatInt16;
+	
 	mp_sint32 res = audioDriver->initDevice(bufferSize*MP_NUMCHANNELS, sampleRate, this);
 	if (res < 0)
 		return res;
 
 	if (res > 0)
 	{
-		// if the result is positive it reflects the number of 16 bit words
-		// in the obtained buffer => divide by MP_NUMCHANNELS is the correct buffer size
+		// if the result is positive it reflects the number of samples (16 bit words
+		// or floats) in the obtained buffer => divide by MP_NUMCHANNELS is the correct buffer size
 		bufferSize = res / MP_NUMCHANNELS;
 		notifyListener(MasterMixerNotificationBufferSizeChanged);		
 	}
@@ -119,6 +133,15 @@ mp_sint32 MasterMixer::openAudioDevice()
 	}
 	
 	buffer = new mp_sint32[bufferSize*MP_NUMCHANNELS];	
+	levelBuffer.resize(MP_NUMCHANNELS, bufferSize*2, bufferSize);
+	
+	// scratch buffers for concurrent device mixing
+	if (workerPool && numDevices > 1)
+	{
+		scratchBuffers = new mp_sint32[bufferSize*MP_NUMCHANNELS*numDevices];
+		for (mp_uint32 i = 0; i < numDevices; i++)
+			devices[i].scratchBuffer = scratchBuffers + i*bufferSize*MP_NUMCHANNELS;
+	}
 	
 	initialized = true;	
 	return 0;
@@ -226,16 +249,49 @@ mp_sint32 MasterMixer::setSampleRate(mp_uint32 sampleRate)
 	return 0;
 }
 
+mp_sint32 MasterMixer::setSampleFormat(SampleFormats sampleFormat)
+{
+	if (sampleFormat != this->sampleFormat)
+	{
+		mp_sint32 res = closeAudioDevice();
+		if (res != 0)
+			return res;
+			
+		this->sampleFormat = sampleFormat;
+	}
+	return 0;
+}
+
+mp_sint32 MasterMixer::setWorkerPool(WorkerPool* workerPool)
+{
+	if (workerPool != this->workerPool)
+	{
+		// scratch buffers are allocated when the device is opened
+		mp_sint32 res = closeAudioDevice();
+		if (res != 0)
+			return res;
+			
+		this->workerPool = workerPool;
+	}
+	return 0;
+}
+
+mp_uint32 MasterMixer::getOutputFrameSize() const
+{
+	return MP_NUMCHANNELS * (outputSampleFormat == SampleFormatFloat32 ? sizeof(float) : sizeof(mp_sword));
+}
+
 bool MasterMixer::addDevice(Mixable* device, bool paused/* = false*/)
 {
 	for (mp_uint32 i = 0; i < numDevices; i++)
 	{
 		if (devices[i].mixable == NULL)
 		{
-			devices[i].mixable = device;
 			devices[i].markedForRemoval = false;
 			devices[i].markedForPause = false;
 			devices[i].paused = paused;
+			// publish the device last, the mixer might pick it up right away
+			devices[i].mixable = device;
 			return true;
 		}
 	}
@@ -243,111 +299,145 @@ bool MasterMixer::addDevice(Mixable* device, bool paused/* = false*/)
 	return false;
 }
 
-bool MasterMixer::removeDevice(Mixable* device, bool blocking/* = true*/)
+mp_sint32 MasterMixer::findDevice(Mixable* device) const
 {
 	for (mp_uint32 i = 0; i < numDevices; i++)
 	{
 		if (devices[i].mixable == device)
-		{
-			if (!started)
-			{
-				devices[i].markedForRemoval = false;
-				devices[i].mixable = 0;
-				return true;				
-			}
+			return i;
+	}
+	
+	return -1;
+}
+
+void MasterMixer::issueRequest(CompletionToken& token)
+{
+	// The request flag has been raised before we read the counter: 
+	// if the mixer thread has already started the current cycle it might 
+	// have missed the flag, but the next cycle is going to see it
+	token.cycle = cyclesStarted + 1;
+	token.pending = true;
+}
+
+bool MasterMixer::isCompleted(const CompletionToken& token) const
+{
+	return !token.pending || (mp_sint32)(cyclesCompleted - token.cycle) >= 0;
+}
+
+bool MasterMixer::waitForCompletion(const CompletionToken& token, mp_uint32 timeOutMillis)
+{
+	if (isCompleted(token))
+		return true;
+
+	// the mixer thread only takes the lock if someone is waiting
+	numWaiting++;
+	
+	bool res;
+	{
+		std::unique_lock<std::mutex> lock(completionMutex);
+		res = completionCondition.wait_for(lock, std::chrono::milliseconds(timeOutMillis), 
+										   [this, &token] { return isCompleted(token); });
+	}
+	
+	numWaiting--;
+	return res;
+}
+
+mp_uint32 MasterMixer::getRequestTimeOut() const
+{
+	// wait for two buffers at most before assuming the audio device has stalled
+	double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
+	if (waitMillis < 1.0)
+		waitMillis = 1.0;
+	if (waitMillis > (double)BlockTimeOut)
+		waitMillis = (double)BlockTimeOut;
 		
-			devices[i].markedForRemoval = true;
-			
-			if (blocking)
-			{
-				// this is going to loop infinitely when the audio device is not running
-				double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
-				if (waitMillis < 1.0)
-					waitMillis = 1.0;
-				if (waitMillis > (double)BlockTimeOut)
-					waitMillis = (double)BlockTimeOut;
-				
-				mp_uint32 time = 0;
-				const mp_uint32 sleepTime = 10;
-				while (devices[i].mixable && time < (mp_uint32)waitMillis)
-				{
-					audioDriver->msleep(sleepTime);
-					time+=sleepTime;
-				}
-				
-				// timeout
-				if (time >= waitMillis && devices[i].mixable)
-				{
-					devices[i].mixable = 0;
-					devices[i].markedForRemoval = false;
-				}
-			}
-			
-			return true;
-		}
+	return (mp_uint32)waitMillis;
+}
+
+bool MasterMixer::removeDevice(Mixable* device, CompletionToken& token)
+{
+	token = CompletionToken();
+
+	mp_sint32 i = findDevice(device);
+	if (i < 0)
+		return false;
+		
+	if (!started)
+	{
+		devices[i].markedForRemoval = false;
+		devices[i].mixable = 0;
+		return true;				
 	}
 
-	return false;
+	devices[i].markedForRemoval = true;
+	issueRequest(token);
+	return true;
 }
 
-bool MasterMixer::isDeviceRemoved(Mixable* device)
+bool MasterMixer::removeDevice(Mixable* device, bool blocking/* = true*/)
 {
-	for (mp_uint32 i = 0; i < numDevices; i++)
+	CompletionToken token;
+	if (!removeDevice(device, token))
+		return false;
+		
+	if (blocking && !waitForCompletion(token, getRequestTimeOut()))
 	{
-		if (devices[i].mixable == device)
+		// timeout
+		mp_sint32 i = findDevice(device);
+		if (i >= 0)
 		{
-			return false;
+			devices[i].mixable = 0;
+			devices[i].markedForRemoval = false;
 		}
 	}
 
 	return true;
 }
 
-bool MasterMixer::pauseDevice(Mixable* device, bool blocking/* = true*/)
+bool MasterMixer::isDeviceRemoved(Mixable* device)
 {
-	for (mp_uint32 i = 0; i < numDevices; i++)
-	{
-		if (devices[i].mixable == device)
-		{
-			if (!started)
-			{
-				devices[i].markedForPause = false;
-				devices[i].paused = true;
-				return true;				
-			}
+	return findDevice(device) < 0;
+}
 
-			devices[i].markedForPause = true;
+bool MasterMixer::pauseDevice(Mixable* device, CompletionToken& token)
+{
+	token = CompletionToken();
 
-			if (blocking)
-			{
-				// this is going to loop infinitely when the audio device is not running
-				double waitMillis = ((double)(bufferSize/2) / (double)sampleRate) * 1000.0 * 2.0;
-				if (waitMillis < 1.0)
-					waitMillis = 1.0;
-				if (waitMillis > (double)BlockTimeOut)
-					waitMillis = (double)BlockTimeOut;
-				
-				mp_uint32 time = 0;
-				const mp_uint32 sleepTime = 10;
-				while (!devices[i].paused && time < (mp_uint32)waitMillis)
-				{
-					audioDriver->msleep(sleepTime);
-					time+=sleepTime;
-				}
-				
-				// timeout
-				if (time >= waitMillis && !devices[i].paused)
-				{
-					devices[i].paused = true;
-					devices[i].markedForPause = false;
-				}
-			}
+	mp_sint32 i = findDevice(device);
+	if (i < 0)
+		return false;
+		
+	if (!started)
+	{
+		devices[i].markedForPause = false;
+		devices[i].paused = true;
+		return true;				
+	}
 
-			return true;
+	devices[i].markedForPause = true;
+	issueRequest(token);
+	return true;
+}
+
+bool MasterMixer::pauseDevice(Mixable* device, bool blocking/* = true*/)
+{
+	CompletionToken token;
+	if (!pauseDevice(device, token))
+		return false;
+		
+	if (blocking && !waitForCompletion(token, getRequestTimeOut()))
+	{
+		// timeout
+		mp_sint32 i = findDevice(device);
+		if (i >= 0 && !devices[i].paused)
+		{
+			devices[i].paused = true;
+			devices[i].markedForPause = false;
 		}
 	}
-	
-	return false;
+
+	return true;
 }
 
 bool MasterMixer::resumeDevice(Mixable* device)
@@ -379,34 +469,130 @@ bool MasterMixer::isDevicePaused(Mixable* device)
 
 void MasterMixer::mixerHandler(mp_sword* buffer)
 {
+	beginCycle();
+
+	if (!disableMixing)
+		prepareBuffer();
+	
+	mixDevices();
+	
+	if (!disableMixing)
+	{
+		swapOutBuffer(buffer);
+		storeLevels();
+	}
+		
+	endCycle();
+}
+
+void MasterMixer::mixerHandler(float* buffer)
+{
+	beginCycle();
+
 	if (!disableMixing)
 		prepareBuffer();
 	
+	mixDevices();
+	
+	if (!disableMixing)
+	{
+		swapOutBuffer(buffer);
+		storeLevels();
+	}
+		
+	endCycle();
+}
+
+inline void MasterMixer::beginCycle()
+{
+	// must be visible before the device flags are looked at
+	cyclesStarted++;
+}
+
+inline void MasterMixer::endCycle()
+{
+	cyclesCompleted++;
+	
+	if (numWaiting)
+	{
+		// taking the lock makes sure a waiting thread is either 
+		// not yet checking or already waiting for the signal
+		std::lock_guard<std::mutex> lock(completionMutex);
+		completionCondition.notify_all();
+	}
+}
+
+class MasterMixer::DeviceMixJob : public WorkerPool::Job
+{
+private:
+	MasterMixer& mixer;
+
+public:
+	DeviceMixJob(MasterMixer& mixer) :
+		mixer(mixer)
+	{
+	}
+
+	virtual void run(mp_uint32 index)
+	{
+		DeviceDescriptor* device = mixer.activeDevices[index];
+		
+		memset(device->scratchBuffer, 0, mixer.bufferSize*MP_NUMCHANNELS*sizeof(mp_sint32));
+		device->mixable.load(std::memory_order_relaxed)->mix(device->scratchBuffer, mixer.bufferSize);
+	}
+};
+
+inline void MasterMixer::mixDevices()
+{
 	const register mp_sint32 numDevices = this->numDevices;
 	const register mp_uint32 bufferSize = this->bufferSize;
 	mp_sint32* mixBuffer = this->buffer;
 	
+	// handle removal/pause requests first, only the devices 
+	// left over are mixed
+	numActiveDevices = 0;
+	
 	DeviceDescriptor* device = this->devices;	
 	for (mp_sint32 i = 0; i < numDevices; i++, device++)
 	{
-		if (device->markedForRemoval && device->mixable)
+		Mixable* mixable = device->mixable;
+	
+		if (device->markedForRemoval && mixable)
 		{
 			device->markedForRemoval = false;
 			device->mixable = 0;
 		}  
-		else if (device->mixable && device->markedForPause)
+		else if (mixable && device->markedForPause)
 		{
 			device->markedForPause = false;
 			device->paused = true;
 		}
-		else if (device->mixable && !device->paused)
+		else if (mixable && !device->paused)
 		{
-			device->mixable->mix(mixBuffer, bufferSize);
+			activeDevices[numActiveDevices++] = device;
 		}
 	}
 	
-	if (!disableMixing)
-		swapOutBuffer(buffer);
+	if (workerPool && scratchBuffers && numActiveDevices > 1 && !disableMixing)
+	{
+		// this is the audio callback, it must not sleep waiting for workers
+		DeviceMixJob job(*this);
+		workerPool->runRealtime(job, numActiveDevices);
+		
+		// sum up in device order
+		const mp_sint32 count = bufferSize*MP_NUMCHANNELS;
+		for (mp_uint32 i = 0; i < numActiveDevices; i++)
+		{
+			const mp_sint32* src = activeDevices[i]->scratchBuffer;
+			for (mp_sint32 j = 0; j < count; j++)
+				mixBuffer[j] += src[j];
+		}
+	}
+	else
+	{
+		for (mp_uint32 i = 0; i < numActiveDevices; i++)
+			activeDevices[i]->mixable.load(std::memory_order_relaxed)->mix(mixBuffer, bufferSize);
+	}
 }
 
 void MasterMixer::notifyListener(MasterMixerNotifications notification)
@@ -428,6 +614,22 @@ void MasterMixer::cleanup()
 		delete[] buffer;	
 		buffer = 0;
 	}
+	
+	if (scratchBuffers)
+	{
+		delete[] scratchBuffers;
+		scratchBuffers = 0;
+		for (mp_uint32 i = 0; i < numDevices; i++)
+			devices[i].scratchBuffer = 0;
+	}
+}
+
+inline void MasterMixer::storeLevels()
+{
+	levelBuffer.write(0, buffer, bufferSize, MP_NUMCHANNELS);
+	levelBuffer.write(1, buffer + 1, bufferSize, MP_NUMCHANNELS);
+	levelBuffer.advance(bufferSize);
+	levelBuffer.setTimeStamp(levelBuffer.getWritePosition());
 }
 
 inline void MasterMixer::prepareBuffer()
@@ -518,6 +720,20 @@ inline void MasterMixer::swapOutBuffer(mp_sword* bufferOut)
 	}*/
 }
 
+inline void MasterMixer::swapOutBuffer(float* bufferOut)
+{
+	if (filterHook)
+		filterHook->mix(buffer, bufferSize);
+
+	// no clipping here, full scale 16 bit maps to 1.0
+	const mp_sint32* bufferIn = buffer;
+	const float scale = 1.0f / (float)(32768 << sampleShift);
+	const mp_sint32 bufferSize = this->bufferSize*MP_NUMCHANNELS;
+	
+	for (mp_sint32 i = 0; i < bufferSize; i++)
+		bufferOut[i] = (float)bufferIn[i] * scale;
+}
+
 const char*	MasterMixer::getCurrentAudioDriverName() const
 {
 	if (audioDriver)
@@ -590,29 +806,25 @@ mp_sint32 MasterMixer::getCurrentSamplePeak(mp_sint32 position, mp_sint32 channe
 	if (audioDriver == 0)
 		return 0;
 
-	const mp_uint32 mixBufferSize = bufferSize;
-	const mp_sint32* mixbuff32 = this->buffer;
-
+	// without a time query the whole buffer handed out last is looked at
+	mp_int64 endFrame = levelBuffer.getTimeStamp();
 	if (audioDriver->supportsTimeQuery())
+		endFrame += position - (mp_sint32)bufferSize;
+
+	mp_sint32 peak = 0;
+	mp_sint32 levels[256];
+	
+	for (mp_uint32 done = 0; done < bufferSize; )
 	{
-		mp_sword peak = 0;
+		mp_uint32 todo = bufferSize - done;
+		if (todo > sizeof(levels)/sizeof(mp_sint32))
+			todo = sizeof(levels)/sizeof(mp_sint32);
 		
-		for (mp_sint32 p = position-mixBufferSize; p <= position; p++)
-		{
-			mp_sword s = getCurrentSample(p, channel);
-			if (s > peak)
-				peak = s;
-			if (-s > peak)
-				peak = -s;				
-		}
-		return peak;
-	}	
-	else
-	{
-		mp_sword peak = 0;
-		for (mp_uint32 pos = 0; pos < mixBufferSize; pos++)
+		levelBuffer.read(channel, endFrame - (bufferSize - done - todo), levels, todo);
+		
+		for (mp_uint32 i = 0; i < todo; i++)
 		{
-			mp_sint32 s = mixbuff32[pos*MP_NUMCHANNELS+channel];
+			mp_sint32 s = levels[i];
 			if (s < -32768)
 				s = -32768;
 			if (s > 32767)
@@ -621,8 +833,10 @@ mp_sint32 MasterMixer::getCurrentSamplePeak(mp_sint32 position, mp_sint32 channe
 				peak = s;
 			if (-s > peak)
 				peak = -s;
-		}	
+		}
 		
-		return peak;
+		done += todo;
 	}
+	
+	return peak;
 }
@@ -39,6 +39,12 @@
 #define __MASTERMIXER_H__
 
 #include "Mixable.h"
+#include "ScopeBuffer.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+class WorkerPool;
 
 class MasterMixer
 {
@@ -49,6 +55,12 @@ public:
 		MasterMixerNotificationSampleRateChanged
 	};
 
+	enum SampleFormats
+	{
+		SampleFormatInt16,
+		SampleFormatFloat32
+	};
+
 	class MasterMixerNotificationListener
 	{
 	public:
@@ -87,15 +99,54 @@ public:
 	mp_sint32 setSampleRate(mp_uint32 sampleRate);
 	mp_uint32 getSampleRate() const { return sampleRate; }
 	
+	// float output is only used when the audio driver supports it,
+	// the samples are neither clipped nor shifted then but scaled 
+	// so that 1.0 corresponds to 16 bit full scale
+	mp_sint32 setSampleFormat(SampleFormats sampleFormat);
+	SampleFormats getSampleFormat() const { return sampleFormat; }
+	
+	// the format the audio driver is fed with, valid after the device is opened
+	SampleFormats getOutputSampleFormat() const { return outputSampleFormat; }
+	// size of one stereo sample frame in bytes
+	mp_uint32 getOutputFrameSize() const;
+	
+	// Removing/pausing a running device is carried out by the mixer thread
+	// at the start of the next mixerHandler call, the request counts as 
+	// completed when that call has returned
+	class CompletionToken
+	{
+	private:
+		mp_uint32 cycle;
+		bool pending;
+		
+		friend class MasterMixer;
+		
+	public:
+		CompletionToken() :
+			cycle(0),
+			pending(false)
+		{
+		}
+	};
+	
 	bool addDevice(Mixable* device, bool paused = false);
 	bool removeDevice(Mixable* device, bool blocking = true); 
+	// non-blocking, returns false if the device is unknown
+	bool removeDevice(Mixable* device, CompletionToken& token); 
 	bool isDeviceRemoved(Mixable* device);
 
 	bool pauseDevice(Mixable* device, bool blocking = true);
+	// non-blocking, returns false if the device is unknown
+	bool pauseDevice(Mixable* device, CompletionToken& token);
 	bool resumeDevice(Mixable* device);
 	bool isDevicePaused(Mixable* device);
+	
+	bool isCompleted(const CompletionToken& token) const;
+	// returns false on time out
+	bool waitForCompletion(const CompletionToken& token, mp_uint32 timeOutMillis);
 		
 	void mixerHandler(mp_sword* buffer);
+	void mixerHandler(float* buffer);
 	
 	// allows to control the loudness of the resulting output stream
 	// by bit-shifting the output *right* (dividing by 2^shift)
@@ -105,6 +156,12 @@ public:
 	// disable mixing... you don't need to understand this
 	void setDisableMixing(bool disableMixing) { this->disableMixing = disableMixing; }
 	
+	// with a worker pool several devices are mixed at the same time into 
+	// their own buffers which are summed up in device order afterwards,
+	// the pool is not owned and the audio device is closed when it changes
+	mp_sint32 setWorkerPool(WorkerPool* workerPool);
+	WorkerPool* getWorkerPool() const { return workerPool; }
+
 	void setFilterHook(Mixable* filterHook) { this->filterHook = filterHook; }
 	Mixable* getFilterHook(Mixable* filterHook) const { return filterHook; }
 	
@@ -117,6 +174,7 @@ public:
 	const class AudioDriverManager* getAudioDriverManager() const;
 	
 	mp_sint32 getCurrentSample(mp_sint32 position, mp_sint32 channel);
+	// peak of the last buffer length played up to position, read from the level buffer
 	mp_sint32 getCurrentSamplePeak(mp_sint32 position, mp_sint32 channel);	
 			
 private:
@@ -125,28 +183,53 @@ private:
 	mp_uint32 bufferSize;
 	mp_sint32* buffer;
 	mp_uint32 sampleShift;
+	SampleFormats sampleFormat;
+	SampleFormats outputSampleFormat;
 	bool disableMixing;
 	mp_uint32 numDevices;
 	Mixable* filterHook;
+	WorkerPool* workerPool;
 
+	// the flags are only ever cleared/set by the mixer thread after
+	// they have been raised by another thread, no locking required
 	struct DeviceDescriptor
 	{
-		Mixable* mixable;
-		bool markedForRemoval;
-		bool markedForPause;
-		bool paused;
+		std::atomic<Mixable*> mixable;
+		std::atomic<bool> markedForRemoval;
+		std::atomic<bool> markedForPause;
+		std::atomic<bool> paused;
+		mp_sint32* scratchBuffer;
 	
 		DeviceDescriptor() :
 			mixable(0),
 			markedForRemoval(false),
 			markedForPause(false),
-			paused(false)
+			paused(false),
+			scratchBuffer(0)
 		{
 		}
 	};
 	
 	DeviceDescriptor* devices;
 	
+	// devices which are mixed in the current mixer call
+	DeviceDescriptor** activeDevices;
+	mp_uint32 numActiveDevices;
+	mp_sint32* scratchBuffers;
+	
+	// copy of the output for level meters, left and right channel
+	ScopeBuffer levelBuffer;
+	
+	class DeviceMixJob;
+	friend class DeviceMixJob;
+	
+	// mixerHandler calls started/finished, used for acknowledging requests
+	std::atomic<mp_uint32> cyclesStarted;
+	std::atomic<mp_uint32> cyclesCompleted;
+	std::atomic<mp_uint32> numWaiting;
+	std::mutex completionMutex;
+	std::condition_variable completionCondition;
+	
 	mutable class AudioDriverManager* audioDriverManager;
 	AudioDriverInterface* audioDriver;
 	
@@ -156,10 +239,19 @@ private:
 	
 	void notifyListener(MasterMixerNotifications notification);
 	
+	mp_sint32 findDevice(Mixable* device) const;
+	void issueRequest(CompletionToken& token);
+	mp_uint32 getRequestTimeOut() const;
+	inline void beginCycle();
+	inline void endCycle();
+	
 	void cleanup();
 	
 	inline void prepareBuffer();
+	inline void mixDevices();
 	inline void swapOutBuffer(mp_sword* bufferOut);
+	inline void swapOutBuffer(float* bufferOut);
+	inline void storeLevels();
 };
 
 #endif
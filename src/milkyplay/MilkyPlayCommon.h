@@ -72,11 +72,14 @@
 	typedef HANDLE FHANDLE;
 #ifdef __GNUWIN32__
 	typedef long long mp_int64;
+	typedef unsigned long long mp_uint64;
 #else
 	typedef __int64 mp_int64;
+	typedef unsigned __int64 mp_uint64;
 #endif
 #else
 	typedef long long mp_int64;
+	typedef unsigned long long mp_uint64;
 	typedef char SYSCHAR;
 	typedef FILE* FHANDLE;
 #endif
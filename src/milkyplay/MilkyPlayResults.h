@@ -46,5 +46,6 @@
 #define MP_UNKNOWN_FORMAT		-9
 #define MP_UNSUPPORTED			-10
 #define MP_LOADER_FAILED		-11
+#define MP_LOADING_CANCELLED	-12
 
 #endif
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  OfflineRenderer.cpp
+ *  MilkyPlay
+ *
+ */
+
+#include "OfflineRenderer.h"
+#include "AudioDriver_WAVWriter.h"
+#include "PlayerSTD.h"
+#include "XModule.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+#include <vector>
+
+// Length of the segments a song is cut into, a round of them per 
+// thread is all that is kept in memory
+enum
+{
+	SegmentSeconds = 5
+};
+
+static mp_uint32 resolveNumThreads(mp_uint32 numThreads)
+{
+	return numThreads ? numThreads : WorkerPool::getNumCores();
+}
+
+OfflineRenderer::Settings::Settings() :
+	sampleRate(44100),
+	blockSize(1024),
+	resamplerType(MixerSettings::MIXER_LERPING_RAMPING),
+	sampleFormat(MasterMixer::SampleFormatInt16),
+	sampleShift(1),
+	mixerThreads(1),
+	segmentThreads(1),
+	startOrder(0),
+	endOrder(-1),
+	maxSeconds(0)
+{
+}
+
+struct OfflineRenderer::Segment
+{
+	mp_uint32	firstBlock;
+	mp_uint32	numBlocks;
+};
+
+// One per thread, renders every n-th segment
+struct OfflineRenderer::SegmentPlayer
+{
+	PlayerSTD*		player;
+	mp_uint32		position;		// next block the player is going to mix
+	const Segment*	segment;		// to be mixed in this round, NULL = none
+	mp_sint32*		buffer;			// numBlocks mixed buffers in a row
+};
+
+class OfflineRenderer::SegmentJob : public WorkerPool::Job
+{
+private:
+	SegmentPlayer*	players;
+	mp_uint32		blockSize;
+
+public:
+	SegmentJob(SegmentPlayer* players, mp_uint32 blockSize) :
+		players(players),
+		blockSize(blockSize)
+	{
+	}
+
+	virtual void run(mp_uint32 index)
+	{
+		SegmentPlayer& segmentPlayer = players[index];
+		if (segmentPlayer.segment == NULL)
+			return;
+			
+		const Segment& segment = *segmentPlayer.segment;
+		PlayerSTD& player = *segmentPlayer.player;
+		const mp_uint32 blockLength = blockSize*MP_NUMCHANNELS;
+		
+		// fast forward over the segments of the other players using the 
+		// buffer as scratch buffer, the last buffer before the segment is 
+		// mixed for real to get the beat packet right which is split 
+		// across the boundary
+		player.setFastForward(true);
+		for (mp_uint32 i = segmentPlayer.position; i < segment.firstBlock; i++)
+		{
+			if (i + 1 == segment.firstBlock)
+			{
+				player.setFastForward(false);
+				memset(segmentPlayer.buffer, 0, blockLength*sizeof(mp_sint32));
+			}
+			player.mix(segmentPlayer.buffer, blockSize);
+		}
+		
+		player.setFastForward(false);
+		
+		mp_sint32* buffer = segmentPlayer.buffer;
+		for (mp_uint32 i = 0; i < segment.numBlocks; i++, buffer+=blockLength)
+		{
+			memset(buffer, 0, blockLength*sizeof(mp_sint32));
+			player.mix(buffer, blockSize);
+		}
+		
+		segmentPlayer.position = segment.firstBlock + segment.numBlocks;
+	}
+};
+
+// Plays the segments of a round back through a master mixer, which does
+// the conversion into the output format just like in a serial render
+class OfflineRenderer::SegmentStream : public Mixable
+{
+private:
+	const SegmentPlayer*	players;
+	mp_uint32				numPlayers;
+	mp_uint32				currentPlayer;
+	mp_uint32				currentBlock;
+
+public:
+	SegmentStream() :
+		players(NULL),
+		numPlayers(0),
+		currentPlayer(0),
+		currentBlock(0)
+	{
+	}
+
+	void setRound(const SegmentPlayer* players, mp_uint32 numPlayers)
+	{
+		this->players = players;
+		this->numPlayers = numPlayers;
+		currentPlayer = 0;
+		currentBlock = 0;
+	}
+
+	virtual void mix(mp_sint32* buffer, mp_uint32 numSamples)
+	{
+		while (currentPlayer < numPlayers && players[currentPlayer].segment == NULL)
+			currentPlayer++;
+	
+		if (currentPlayer >= numPlayers)
+			return;
+	
+		const SegmentPlayer& player = players[currentPlayer];
+		const mp_uint32 blockLength = numSamples*MP_NUMCHANNELS;
+		const mp_sint32* src = player.buffer + currentBlock*blockLength;
+		
+		for (mp_uint32 i = 0; i < blockLength; i++)
+			buffer[i] += src[i];
+		
+		if (++currentBlock >= player.segment->numBlocks)
+		{
+			currentPlayer++;
+			currentBlock = 0;
+		}
+	}
+};
+
+OfflineRenderer::OfflineRenderer(const Settings& settings) :
+	settings(settings),
+	workerPool(NULL)
+{
+	if (this->settings.blockSize == 0)
+		this->settings.blockSize = 1024;
+
+	// the pool is kept alive for the entire batch and shared
+	// between concurrent mixing and concurrent segments
+	mp_uint32 numThreads = resolveNumThreads(settings.mixerThreads);
+	if (resolveNumThreads(settings.segmentThreads) > numThreads)
+		numThreads = resolveNumThreads(settings.segmentThreads);
+		
+	if (numThreads > 1)
+		workerPool = new WorkerPool(numThreads - 1);
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+	delete workerPool;
+}
+
+PlayerSTD* OfflineRenderer::createPlayer(const XModule& module) const
+{
+	// there is no IT replayer in this build, PlayerSTD handles all formats,
+	// every player gets its own YM2149 so renders can run side by side
+	PlayerSTD* player = new PlayerSTD(settings.sampleRate, NULL, true);
+	player->setBufferSize(settings.blockSize);
+	player->setResamplerType(settings.resamplerType);
+
+	// like the tracker, instruments named after a sound of 
+	// the YM bank play that sound on the YM channels
+	std::map<int, int> instrument2YMSoundsIndex;
+	for (mp_uint32 i = 0; i < module.header.insnum; i++)
+	{
+		for (mp_uint32 j = 0; j < ResamplerYM::GetNbSounds(); j++)
+		{
+			if (strncmp(module.instr[i].name, ResamplerYM::GetSoundName(j), MP_MAXTEXT) == 0)
+			{
+				instrument2YMSoundsIndex[i+1] = j;
+				break;
+			}
+		}
+	}
+	player->setInstrumentYMSoundsMapping(instrument2YMSoundsIndex);
+
+	return player;
+}
+
+bool OfflineRenderer::isFinished(const PlayerBase& player, mp_int64 numFrames) const
+{
+	if (player.hasSongHalted())
+		return true;
+		
+	if (settings.endOrder >= 0 && player.getOrder(0) > settings.endOrder)
+		return true;
+	
+	return settings.maxSeconds && numFrames >= (mp_int64)settings.maxSeconds * settings.sampleRate;
+}
+
+// isFinished() is asked after every buffer, the song has halted or the
+// time limit has been hit somewhere in the last one. The output ends 
+// there, so its length doesn't depend on the block size
+mp_int64 OfflineRenderer::getEndFrame(const PlayerBase& player, mp_int64 numFrames) const
+{
+	mp_int64 endFrame = numFrames;
+	
+	if (player.hasSongHalted() && player.getHaltSampleCounter() < endFrame)
+		endFrame = player.getHaltSampleCounter();
+	
+	const mp_int64 maxFrames = (mp_int64)settings.maxSeconds * settings.sampleRate;
+	if (settings.maxSeconds && maxFrames < endFrame)
+		endFrame = maxFrames;
+		
+	return endFrame;
+}
+
+void OfflineRenderer::cutLastBlock(AudioDriver_NULL& driver, mp_int64 endFrame) const
+{
+	const mp_int64 lastBlock = (mp_int64)driver.getNumPlayedSamples() - settings.blockSize;
+	if (endFrame >= lastBlock)
+		driver.truncate((mp_uint32)(endFrame - lastBlock));
+}
+
+mp_sint32 OfflineRenderer::render(XModule& module, AudioDriver_NULL& driver)
+{
+	statistics = Statistics();
+
+	if (!module.isModuleLoaded())
+		return MP_UNSPECIFIED;
+
+	if (settings.startOrder < 0 || settings.startOrder >= module.header.ordnum)
+		return MP_UNSPECIFIED;
+	
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	
+	mp_sint32 res;
+	if (settings.segmentThreads != 1 && workerPool)
+		res = renderSegments(module, driver);
+	else
+		res = renderSerial(module, driver);
+
+	std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+	statistics.numFrames = driver.getNumPlayedSamples();
+	statistics.elapsedSeconds = std::chrono::duration<double>(endTime - startTime).count();
+	
+	return res;
+}
+
+mp_sint32 OfflineRenderer::renderSerial(XModule& module, AudioDriver_NULL& driver)
+{
+	PlayerSTD* player = createPlayer(module);
+	player->setWorkerPool(settings.mixerThreads != 1 ? workerPool : NULL);
+
+	MasterMixer mixer(settings.sampleRate, settings.blockSize, 1, &driver);
+	mixer.setSampleShift(settings.sampleShift);
+	mixer.setSampleFormat(settings.sampleFormat);
+
+	mp_sint32 res = mixer.openAudioDevice();
+	if (res < 0)
+	{
+		delete player;
+		return res;
+	}
+
+	mixer.addDevice(player);
+	
+	res = player->startPlaying(&module, false, settings.startOrder);
+	if (res == MP_OK)
+		res = mixer.start();
+
+	if (res == MP_OK)
+	{
+		while (!isFinished(*player, driver.getNumPlayedSamples()))
+			driver.advance();
+			
+		cutLastBlock(driver, getEndFrame(*player, driver.getNumPlayedSamples()));
+	}
+
+	player->stopPlaying();
+	mixer.stop();
+	mixer.removeDevice(player);
+	
+	mp_sint32 closeRes = mixer.closeAudioDevice();
+
+	delete player;
+	
+	return res != MP_OK ? res : closeRes;
+}
+
+mp_sint32 OfflineRenderer::renderSegments(XModule& module, AudioDriver_NULL& driver)
+{
+	// dry run: find out how many buffers the song lasts and
+	// which order is playing at the start of each of them
+	PlayerSTD* player = createPlayer(module);
+	if (!player->getCurrentResampler()->supportsFastForward())
+	{
+		delete player;
+		return renderSerial(module, driver);
+	}
+	
+	player->setFastForward(true);
+	mp_sint32 res = player->startPlaying(&module, false, settings.startOrder);
+	if (res != MP_OK)
+	{
+		delete player;
+		return res;
+	}
+	
+	const mp_uint32 blockSize = settings.blockSize;
+	const mp_uint32 blockLength = blockSize*MP_NUMCHANNELS;
+	
+	std::vector<mp_sint32> blockOrders;
+	mp_sint32* scratchBuffer = new mp_sint32[blockLength];
+	
+	while (!isFinished(*player, (mp_int64)blockOrders.size()*blockSize))
+	{
+		blockOrders.push_back(player->getOrder(0));
+		player->mix(scratchBuffer, blockSize);
+	}
+	
+	const mp_int64 endFrame = getEndFrame(*player, (mp_int64)blockOrders.size()*blockSize);
+	
+	delete[] scratchBuffer;
+	player->stopPlaying();
+	delete player;
+
+	const mp_uint32 numBlocks = (mp_uint32)blockOrders.size();
+	const mp_uint32 segmentBlocks = (SegmentSeconds*settings.sampleRate) / blockSize + 1;
+	
+	mp_uint32 numSegments = numBlocks / segmentBlocks;
+	mp_uint32 numPlayers = resolveNumThreads(settings.segmentThreads);
+	if (numPlayers > numSegments)
+		numPlayers = numSegments;
+		
+	if (numPlayers < 2)
+		return renderSerial(module, driver);
+
+	// split at order changes close to equally sized segments
+	std::vector<Segment> segments;
+	mp_uint32 firstBlock = 0;
+	for (mp_uint32 i = 1; i <= numSegments; i++)
+	{
+		mp_uint32 block = numBlocks;
+		if (i < numSegments)
+		{
+			const mp_uint32 target = (mp_uint32)(((mp_int64)numBlocks * i) / numSegments);
+			const mp_uint32 limit = (mp_uint32)(((mp_int64)numBlocks * (i+1)) / numSegments);
+		
+			block = target;
+			while (block < limit && blockOrders[block] == blockOrders[block-1])
+				block++;
+		
+			if (block == limit)
+				block = target;
+		}
+		
+		if (block > firstBlock)
+		{
+			Segment segment;
+			segment.firstBlock = firstBlock;
+			segment.numBlocks = block - firstBlock;
+			segments.push_back(segment);
+			firstBlock = block;
+		}
+	}
+	
+	numSegments = (mp_uint32)segments.size();
+	
+	mp_uint32 maxSegmentBlocks = 0;
+	for (mp_uint32 i = 0; i < numSegments; i++)
+		if (segments[i].numBlocks > maxSegmentBlocks)
+			maxSegmentBlocks = segments[i].numBlocks;
+	
+	// players are created here, constructing them concurrently is not safe
+	std::vector<SegmentPlayer> players(numPlayers);
+	for (mp_uint32 i = 0; i < numPlayers; i++)
+	{
+		SegmentPlayer& segmentPlayer = players[i];
+		segmentPlayer.position = 0;
+		segmentPlayer.segment = NULL;
+		segmentPlayer.buffer = new mp_sint32[maxSegmentBlocks*blockLength];
+		segmentPlayer.player = createPlayer(module);
+		segmentPlayer.player->setFastForward(true);
+		
+		if (res == MP_OK)
+			res = segmentPlayer.player->startPlaying(&module, false, settings.startOrder);
+	}
+	
+	if (res == MP_OK)
+	{
+		SegmentStream stream;
+		
+		MasterMixer mixer(settings.sampleRate, blockSize, 1, &driver);
+		mixer.setSampleShift(settings.sampleShift);
+		mixer.setSampleFormat(settings.sampleFormat);
+
+		res = mixer.openAudioDevice();
+		if (res == MP_OK)
+		{
+			mixer.addDevice(&stream);
+			res = mixer.start();
+		
+			// mix a round of segments, one per player, then write it out
+			SegmentJob job(&players[0], blockSize);
+			for (mp_uint32 first = 0; first < numSegments && res == MP_OK; first+=numPlayers)
+			{
+				mp_uint32 roundBlocks = 0;
+				for (mp_uint32 i = 0; i < numPlayers; i++)
+				{
+					players[i].segment = first + i < numSegments ? &segments[first + i] : NULL;
+					if (players[i].segment)
+						roundBlocks += players[i].segment->numBlocks;
+				}
+				
+				workerPool->run(job, numPlayers);
+				
+				stream.setRound(&players[0], numPlayers);
+				for (mp_uint32 i = 0; i < roundBlocks; i++)
+					driver.advance();
+			}
+			
+			if (res == MP_OK)
+				cutLastBlock(driver, endFrame);
+			
+			mixer.stop();
+			mixer.removeDevice(&stream);
+			
+			mp_sint32 closeRes = mixer.closeAudioDevice();
+			if (res == MP_OK)
+				res = closeRes;
+		}
+	}
+	
+	for (mp_uint32 i = 0; i < numPlayers; i++)
+	{
+		players[i].player->stopPlaying();
+		delete players[i].player;
+		delete[] players[i].buffer;
+	}
+	
+	return res;
+}
+
+mp_sint32 OfflineRenderer::renderToWAV(XModule& module, const SYSCHAR* fileName)
+{
+	WAVWriter wavWriter(fileName);
+	if (!wavWriter.isOpen())
+		return MP_DEVICE_ERROR;
+		
+	return render(module, wavWriter);
+}
+
+mp_sint32 OfflineRenderer::renderToWAV(const SYSCHAR* moduleFileName, const SYSCHAR* fileName)
+{
+	XModule module;
+	
+	mp_sint32 res = module.loadModule(moduleFileName);
+	if (res != MP_OK)
+		return res;
+		
+	return renderToWAV(module, fileName);
+}
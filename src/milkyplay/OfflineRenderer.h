@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  OfflineRenderer.h
+ *  MilkyPlay
+ *
+ *  Renders a module as fast as possible without any audio device, 
+ *  either into a WAV file or into any other AudioDriver_NULL 
+ *  derived driver which is pumped through advance().
+ *
+ *  Long songs can be split into order ranges which are rendered at the 
+ *  same time: a dry run with fast forwarding players finds the length 
+ *  of the song and the buffers at which the orders change, the song is
+ *  cut into segments of a few seconds and every thread owns a player
+ *  which takes every n-th segment, fast forwarding over the ones in 
+ *  between. A round of n segments is written out before the next one 
+ *  is mixed, so memory doesn't grow with the song and every player 
+ *  goes through the song once. The segments are cut at buffer 
+ *  boundaries and the players are deterministic, so the result is 
+ *  identical to a serial render, sample by sample.
+ */
+
+#ifndef __OFFLINERENDERER_H__
+#define __OFFLINERENDERER_H__
+
+#include "MilkyPlayCommon.h"
+#include "ChannelMixer.h"
+#include "MasterMixer.h"
+
+class XModule;
+class AudioDriver_NULL;
+class WorkerPool;
+class PlayerBase;
+class PlayerSTD;
+
+class OfflineRenderer
+{
+public:
+	struct Settings
+	{
+		mp_uint32						sampleRate;
+		// number of sample frames mixed per advance() call
+		mp_uint32						blockSize;
+		MixerSettings::ResamplerTypes	resamplerType;
+		MasterMixer::SampleFormats		sampleFormat;
+		mp_uint32						sampleShift;
+		// 1 = mix all channels on the calling thread, 0 = use all cores
+		mp_uint32						mixerThreads;
+		// number of song segments rendered at the same time, 1 = render 
+		// the song in one go, 0 = use all cores
+		mp_uint32						segmentThreads;
+		mp_sint32						startOrder;
+		// last order to render, -1 = until the song ends
+		mp_sint32						endOrder;
+		// safety net for songs which never stop, 0 = no limit
+		mp_uint32						maxSeconds;
+		
+		Settings();
+	};
+	
+	struct Statistics
+	{
+		mp_int64	numFrames;
+		double		elapsedSeconds;
+		
+		Statistics() :
+			numFrames(0),
+			elapsedSeconds(0.0)
+		{
+		}
+		
+		double getFramesPerSecond() const 
+		{ 
+			return elapsedSeconds > 0.0 ? (double)numFrames / elapsedSeconds : 0.0; 
+		}
+	};
+
+private:
+	Settings		settings;
+	WorkerPool*		workerPool;
+	Statistics		statistics;
+	
+	struct Segment;
+	struct SegmentPlayer;
+	class SegmentJob;
+	class SegmentStream;
+	
+	PlayerSTD*		createPlayer(const XModule& module) const;
+	bool			isFinished(const PlayerBase& player, mp_int64 numFrames) const;
+	mp_int64		getEndFrame(const PlayerBase& player, mp_int64 numFrames) const;
+	void			cutLastBlock(AudioDriver_NULL& driver, mp_int64 endFrame) const;
+
+	mp_sint32		renderSerial(XModule& module, AudioDriver_NULL& driver);
+	mp_sint32		renderSegments(XModule& module, AudioDriver_NULL& driver);
+	
+public:
+					OfflineRenderer(const Settings& settings);
+					~OfflineRenderer();
+
+	const Settings&	getSettings() const { return settings; }
+
+	// plays the module through the given driver until the song has ended 
+	// (or endOrder has been passed), the driver is opened and closed here.
+	// The output stops on the tick the song halts on or at maxSeconds, 
+	// whatever the block size, endOrder is only checked per block
+	mp_sint32		render(XModule& module, AudioDriver_NULL& driver);
+
+	mp_sint32		renderToWAV(XModule& module, const SYSCHAR* fileName);
+	// loads the module first, returns the loader error if that fails
+	mp_sint32		renderToWAV(const SYSCHAR* moduleFileName, const SYSCHAR* fileName);
+
+	// statistics of the last render call
+	const Statistics& getStatistics() const { return statistics; }
+};
+
+#endif
@@ -55,6 +55,7 @@ mp_sint32 PlayerBase::kick()
 	paused = false;
 	// playing => song has not stopped yet
 	halted = false;
+	haltSampleCounter = 0;
 	// set idle mode
 	setIdle(idle);
 	
@@ -73,8 +74,8 @@ mp_sint32 PlayerBase::kick()
 	return MP_OK;
 }
 
-PlayerBase::PlayerBase(mp_uint32 frequency, MixerSettings::ResamplerTypes resampleTypes, bool mainplayer) : 
-	ChannelMixer(32, frequency, resampleTypes, mainplayer),
+PlayerBase::PlayerBase(mp_uint32 frequency, MixerSettings::ResamplerTypes resampleTypes, bool emulateYM) : 
+	ChannelMixer(32, frequency, resampleTypes, emulateYM),
 	timeRecord(NULL)
 {
 	module = NULL;
@@ -91,6 +92,7 @@ PlayerBase::PlayerBase(mp_uint32 frequency, MixerSettings::ResamplerTypes resamp
 	startPlay						= false;
 	paused							= false;
 	halted							= false;
+	haltSampleCounter				= 0;
 	idle							= false;
 	resetOnStopFlag					= false;
 	resetMainVolumeOnStartPlayFlag	= true;
@@ -332,6 +334,10 @@ void PlayerBase::setPatternPos(mp_uint32 pos, mp_uint32 row/* = 0*/, bool resetC
 
 void PlayerBase::timerHandler(mp_sint32 currentBeatPacket)
 {
+	// players stop the song from within their tick, after this has been called
+	if (!halted)
+		haltSampleCounter = timerSampleCounter;
+
 	timeRecord[currentBeatPacket] = TimeRecord(poscnt, 
 											   rowcnt, 
 											   bpm, 
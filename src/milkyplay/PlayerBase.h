@@ -157,6 +157,7 @@ protected:
 
 	bool			paused;					// Player is paused
 	bool			halted;					// Playing has been stopped (song is over)
+	mp_int64		haltSampleCounter;		// Sample counter at the start of the tick playing has been stopped on
 	bool			repeat;					// Player will repeat song
 	bool			idle;					// Player is mixing, but not processing song
 	bool			playOneRowOnly;			// Player will only play one row and not advance to the next row (used for milkytracker)
@@ -189,7 +190,7 @@ protected:
 	virtual void clearEffectMemory() { }	
 
 public:
-	PlayerBase(mp_uint32 frequency, MixerSettings::ResamplerTypes resampleTypes, bool mainplayer = false);
+	PlayerBase(mp_uint32 frequency, MixerSettings::ResamplerTypes resampleTypes, bool emulateYM = false);
 
 	virtual ~PlayerBase();
 	
@@ -244,6 +245,8 @@ public:
 	mp_sint32		stopPlaying();
 	
 	bool			hasSongHalted() const { return halted; }
+	// the song ends here, what has been mixed after this is only sound running out
+	mp_int64		getHaltSampleCounter() const { return haltSampleCounter; }
 
 	void			setIdle(bool idle) { this->idle = idle; }
 	bool			isIdle() const { return idle; }
@@ -502,25 +502,34 @@ void PlayerIT::clearEffectMemory()
 
 PlayerIT::TVirtualChannel* PlayerIT::allocateVirtualChannel()
 {
-	const mp_sint32 numVirtualChannels = this->numVirtualChannels;
-	
 	mp_sint32 i;
 
+	// channels above curMaxVirChannels haven't been used since the last reset, 
+	// so they're free and there is no need to look at them
 	TVirtualChannel* vchn = vchninfo;	
-	for (i = 0; i < numVirtualChannels; i++, vchn++)
+	for (i = 0; i < curMaxVirChannels; i++, vchn++)
 	{
 		if (vchn->getBackground())
 		{
 			if (!vchn->getActive())
 			{
-				if (i+1 > curMaxVirChannels)
-					curMaxVirChannels = i+1;
 				vchn->setChannelIndex(i);
 				return vchn;
 			}
 		}
 	}
 	
+	if (curMaxVirChannels < numVirtualChannels)
+	{
+		vchn = vchninfo + curMaxVirChannels;
+		vchn->setChannelIndex(curMaxVirChannels);
+		curMaxVirChannels++;
+		return vchn;
+	}
+	
+	// all of them are in use, steal the quietest background channel
+	// this is still a scan over the used channels, background volumes change
+	// on every tick and there's no hook in TVirtualChannel to keep them sorted
 	mp_sint32 chnIndex = -1;
 	mp_sint32 vol = 0x7FFFFFFF;
 	vchn = vchninfo;	
@@ -159,29 +159,52 @@ const mp_uint32 PlayerSTD::logtab[13*8+1] = {
 		LOGFAC*428 // one more value because of linear interpolation
 };
 
+mp_uint32 PlayerSTD::linfreqtab[PlayerSTD::LINFREQTAB_SIZE];
+mp_uint32 PlayerSTD::logfreqtab[PlayerSTD::LOGFREQTAB_SIZE];
+mp_sint32 PlayerSTD::logperiodtab[PlayerSTD::LOGPERIODTAB_SIZE];
+
+void PlayerSTD::buildFrequencyTables()
+{
+	mp_sint32 i;
+
+	// Linear interpolation between the lintab entries seems to be wrong,
+	// the fractional part of the period is dropped, one entry per period
+	for (i = 0; i < LINFREQTAB_SIZE; i++)
+		linfreqtab[i] = ((lintab[i%768])<<(i/768))>>5;
+
+	logfreqtab[0] = 0;
+	for (i = 1; i < LOGFREQTAB_SIZE; i++)
+		logfreqtab[i] = fixeddiv(14317056, i<<8)>>8;
+
+	for (i = 0; i < LOGPERIODTAB_SIZE; i++)
+	{
+		mp_sint32 note = i>>4;
+		mp_sint32 octave = note/12;
+		mp_sint32 pi = i&15;
+		mp_sint32 n = (note%12)<<3;
+		mp_sint32 v1 = logtab[pi+n];
+		mp_sint32 v2 = logtab[pi+n+1];
+		mp_sint32 t = pi-8;
+		logperiodtab[i] = interpolate(t,0,15,v1,v2)>>octave;
+	}
+}
+
 // This takes the period with 8 bit fractional part
 mp_sint32	PlayerSTD::getlinfreq(mp_sint32 per)
 {
 	if (per<0) per=0;
 	if (per>7680*256) per=7680*256;
 	
-	mp_sint32 t = (7680*256-per)/(768*256);
-	mp_sint32 r = (7680*256-per)%(768*256);
-	
-	// Linear interpolation seems to be wrong here
-	/*mp_sint32 frac = r & 255;
-	
-	mp_sint32 r1 = ((lintab[r>>8])<<t)>>5;
-	mp_sint32 r2 = ((lintab[(r>>8)+1])<<t)>>5;
-
-	return ((255-frac)*r1 + frac*r2) >> 8;*/
-
-	return ((lintab[r>>8])<<t)>>5;
+	return linfreqtab[(7680*256-per)>>8];
 }
 
 // This takes the period with 8 bit fractional part
 mp_sint32	PlayerSTD::getlogfreq(mp_sint32 per) 
 { 
+	// periods coming from the player don't have a fractional part
+	if (!(per & 255) && (per>>8) < LOGFREQTAB_SIZE)
+		return logfreqtab[per>>8];
+
 	return fixeddiv(14317056, per)>>8; 
 }
 
@@ -211,25 +234,21 @@ mp_sint32	PlayerSTD::getlogperiod(mp_sint32 note,mp_sint32 relnote,mp_sint32 fin
 	
 	mp_sint32 ft = finetune;
 	ft+=128;
-	mp_sint32 octave = (note-1)/12;
-	mp_sint32 n = ((note-1)%12)<<3;
-	mp_sint32 pi = (ft>>4)+n;
-	mp_sint32 v1 = logtab[pi];
-	mp_sint32 v2 = logtab[pi+1];
-	mp_sint32 t = (ft>>4)-8;
-	//mp_sint32 t = (ft>>4);
-	return interpolate(t,0,15,v1,v2)>>octave;
+	return logperiodtab[((note-1)<<4)+(ft>>4)];
 }
 
 
 PlayerSTD::PlayerSTD(mp_uint32 frequency,
 					 StatusEventListener* statusEventListener/* = NULL*/,
-					 bool mainplayer) : 
-	PlayerBase(frequency, MixerSettings::MIXER_BLS, mainplayer),
+					 bool emulateYM) : 
+	PlayerBase(frequency, MixerSettings::MIXER_BLS, emulateYM),
 	statusEventListener(statusEventListener),
 	chninfo(NULL),
 	lastNumAllocatedChannels(-1)
 {
+	static const bool tablesBuilt = (buildFrequencyTables(), true);
+	(void)tablesBuilt;
+
 	smpoffs = NULL;
 	attick	= NULL;	
 	
@@ -1119,11 +1138,11 @@ void PlayerSTD::progressRow()
 				chnInf->eff[effcnt] = row[(pp+2)+(effcnt*2)];
 				chnInf->eop[effcnt] = row[(pp+2)+(effcnt*2+1)];
 
-				if (isymchannel)
+				if (isymchannel && ymresampler != NULL)
 				{
 					auto  fx  = chnInf->eff[effcnt];
 					int   val = chnInf->eop[effcnt];
-					auto& ymparam = ResamplerYM::GetInstance()->ymparams[getYMChannel(chn)];
+					auto& ymparam = ymresampler->ymparams[getYMChannel(chn)];
 
 					switch (fx)
 					{
@@ -1182,9 +1201,9 @@ void PlayerSTD::progressRow()
 				}				
 			}
 
-			if (isymchannel)
+			if (isymchannel && ymresampler != NULL)
 			{
-				SetYMparamNote (ResamplerYM::GetInstance()->ymparams[getYMChannel(chn)], note, i);
+				SetYMparamNote (ymresampler->ymparams[getYMChannel(chn)], note, i);
 			}
 			
 			// Check new instrument settings only if valid note or no note at all
@@ -1840,7 +1859,8 @@ void PlayerSTD::playNote(mp_ubyte chn, mp_sint32 note, mp_sint32 i, mp_sint32 vo
 
 	if (isYMChannel(chn))
 	{
-		SetYMparamNote(ymresampler->ymparams[getYMChannel(chn)], note , i); 
+		if (ymresampler != NULL)
+			SetYMparamNote(ymresampler->ymparams[getYMChannel(chn)], note , i); 
 	}
 	else
 	{
@@ -198,6 +198,21 @@ private:
 	static const mp_sint32	vibtab[32];
 	static const mp_uword	lintab[769];
 	static const mp_uint32	logtab[];
+
+	// Lookup tables replacing the divisions of the period/frequency helpers,
+	// they don't depend on the mixing frequency and are built once
+	enum
+	{
+		LINFREQTAB_SIZE = 7680+1,
+		LOGFREQTAB_SIZE = 32768,
+		LOGPERIODTAB_SIZE = XModule::NOTE_LAST*16
+	};
+
+	static mp_uint32	linfreqtab[LINFREQTAB_SIZE];	// indexed by (7680*256-per)>>8
+	static mp_uint32	logfreqtab[LOGFREQTAB_SIZE];	// indexed by period without fractional part
+	static mp_sint32	logperiodtab[LOGPERIODTAB_SIZE];	// indexed by (note-1)*16 + (finetune+128)>>4
+
+	static void			buildFrequencyTables();
 	
 	StatusEventListener* statusEventListener;
 	
@@ -391,7 +406,7 @@ protected:
 public:
 					PlayerSTD(mp_uint32 frequency,
 							  StatusEventListener* statusEventListener = NULL, 
-							  bool mainplayer = false);
+							  bool emulateYM = false);
 					
 	virtual			~PlayerSTD();
 	
@@ -40,22 +40,35 @@
 
 ChannelMixer::ResamplerBase* ResamplerFactory::createResampler(ResamplerTypes type)
 {
+	// NULL if there is no usable vector unit, fall back to the scalar resamplers then
+	const ResamplerSIMD::Kernels* kernels = ResamplerSIMD::getBestKernels();
+
 	switch (type)
 	{
 		case MIXER_NORMAL:
+			if (kernels)
+				return new ResamplerSimpleSIMD(kernels);
 			return new ResamplerSimple();
 			
 		case MIXER_NORMAL_RAMPING:
+			if (kernels)
+				return new ResamplerSimpleRampSIMD(kernels);
 			return new ResamplerSimpleRamp();
 
 		case MIXER_LERPING:
+			if (kernels)
+				return new ResamplerLerpSIMD(kernels);
 			return new ResamplerLerp();
 
 		case MIXER_LERPING_RAMPING:
+			if (kernels)
+				return new ResamplerLerpRampFilterSIMD(kernels);
 			return new ResamplerLerpRampFilter();
 
 		case MIXER_BLS:
 		case MIXER_BLS_RAMPING:
+			if (kernels)
+				return new ResamplerBLSSIMD(kernels);
 			return new ResamplerBLS();
 		
 			/*	There is also ResamplerAmiga<5> which is a generic 22khz LP filter, it still
@@ -42,6 +42,7 @@
 #define __RESAMPLERFAST_H__
 
 #include "ResamplerMacros.h"
+#include "ResamplerSIMD.h"
 
 /*
  * Resampler without interpolation or ramping
@@ -52,6 +53,8 @@ public:
 	virtual bool isRamping() { return false; }
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool supportsConcurrentMixing() { return true; }
+	virtual bool supportsFastForward() { return true; }
 
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -90,6 +93,8 @@ public:
 	virtual bool isRamping() { return true; }
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool supportsConcurrentMixing() { return true; }
+	virtual bool supportsFastForward() { return true; }
 
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -155,6 +160,8 @@ public:
 	virtual bool isRamping() { return false; }
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool supportsConcurrentMixing() { return true; }
+	virtual bool supportsFastForward() { return true; }
 
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -194,6 +201,8 @@ public:
 	virtual bool isRamping() { return true; }
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool supportsConcurrentMixing() { return true; }
+	virtual bool supportsFastForward() { return true; }
 
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -499,6 +508,7 @@ public:
 */
 class ResamplerBLS : public ChannelMixer::ResamplerBase
 {
+protected:
 	static float getSTeBalanceAmp(mp_ubyte _lmcvalue)
 	{
 		const float dbchn  = -2.0f * (float)(20 - (_lmcvalue & 0x3F));   
@@ -513,8 +523,8 @@ class ResamplerBLS : public ChannelMixer::ResamplerBase
 		}
 		else
 		{
-			float fvolL = getSTeBalanceAmp(chn->STebalanceLeft)  * 44.0f;
-			float fvolR = getSTeBalanceAmp(chn->STebalanceRight) * 44.0f;
+			float fvolL = getSTeBalanceAmp(chn->STebalanceLeft)  * (float)ChannelMixer::MP_DMAAMPLIFY;
+			float fvolR = getSTeBalanceAmp(chn->STebalanceRight) * (float)ChannelMixer::MP_DMAAMPLIFY;
 
 			voll = mp_sint32(fvolL);
 			volr = mp_sint32(fvolR);
@@ -525,6 +535,8 @@ public:
 	virtual bool isRamping() { return false; }
 	virtual bool supportsFullChecking() { return true; }
 	virtual bool supportsNoChecking() { return true; }
+	virtual bool supportsConcurrentMixing() { return true; }
+	virtual bool supportsFastForward() { return true; }
 
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 	{
@@ -560,4 +572,191 @@ public:
 };
 
 
+/*
+ * Vectorised variants of the resamplers above, see ResamplerSIMD.h
+ * Only the non-checking block mixers are replaced, the full checking
+ * mixers and the IT filter path (which is a recursion over time) are 
+ * inherited from the scalar versions.
+ */
+class ResamplerSimpleSIMD : public ResamplerSimple
+{
+private:
+	const ResamplerSIMD::Kernels* kernels;
+
+public:
+	ResamplerSimpleSIMD(const ResamplerSIMD::Kernels* kernels) :
+		kernels(kernels)
+	{
+	}
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		const mp_sint32 voll = chn->finalvoll;
+		const mp_sint32 volr = chn->finalvolr;
+
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 posfixed = chn->smpposfrac;
+
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos,chn->smpposfrac,fp,16);
+
+		if ((voll == 0) && (volr == 0)) return;
+
+		if (!(chn->flags&4))
+			kernels->normal8(buffer, chn->sample + basepos, posfixed, smpadd, voll, volr, 0, 0, count);
+		else
+			kernels->normal16(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, voll, volr, 0, 0, count);
+	}
+};
+
+class ResamplerSimpleRampSIMD : public ResamplerSimpleRamp
+{
+private:
+	const ResamplerSIMD::Kernels* kernels;
+
+public:
+	ResamplerSimpleRampSIMD(const ResamplerSIMD::Kernels* kernels) :
+		kernels(kernels)
+	{
+	}
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		const mp_sint32 voll = chn->finalvoll;
+		const mp_sint32 volr = chn->finalvolr;
+
+		const mp_sint32 rampFromVolStepL = chn->rampFromVolStepL;
+		const mp_sint32 rampFromVolStepR = chn->rampFromVolStepR;		
+
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 posfixed = chn->smpposfrac;
+
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos,chn->smpposfrac, fp, 16);
+
+		if ((voll == 0 && rampFromVolStepL == 0) && (volr == 0 && rampFromVolStepR == 0)) return;
+
+		if (!(chn->flags&4))
+			kernels->normal8(buffer, chn->sample + basepos, posfixed, smpadd, voll, volr, rampFromVolStepL, rampFromVolStepR, count);
+		else
+			kernels->normal16(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, voll, volr, rampFromVolStepL, rampFromVolStepR, count);
+		
+		chn->finalvoll = voll + rampFromVolStepL*(mp_sint32)count;
+		chn->finalvolr = volr + rampFromVolStepR*(mp_sint32)count;
+	}
+};
+
+class ResamplerLerpSIMD : public ResamplerLerp
+{
+private:
+	const ResamplerSIMD::Kernels* kernels;
+
+public:
+	ResamplerLerpSIMD(const ResamplerSIMD::Kernels* kernels) :
+		kernels(kernels)
+	{
+	}
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		const mp_sint32 voll = chn->finalvoll;
+		const mp_sint32 volr = chn->finalvolr;
+
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 posfixed = chn->smpposfrac;
+
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+
+		if ((voll == 0) && (volr == 0)) return;
+
+		if (!(chn->flags&4))
+			kernels->lerp8(buffer, chn->sample + basepos, posfixed, smpadd, voll, volr, 0, 0, count);
+		else
+			kernels->lerp16(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, voll, volr, 0, 0, count);
+	}
+};
+
+class ResamplerLerpRampFilterSIMD : public ResamplerLerpRampFilter
+{
+private:
+	const ResamplerSIMD::Kernels* kernels;
+
+public:
+	ResamplerLerpRampFilterSIMD(const ResamplerSIMD::Kernels* kernels) :
+		kernels(kernels)
+	{
+	}
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		// filter in use? the filter is recursive, leave it to the scalar mixer
+		if (chn->cutoff != ChannelMixer::MP_INVALID_VALUE && chn->resonance != ChannelMixer::MP_INVALID_VALUE)
+		{
+			ResamplerLerpRampFilter::addBlockNoCheck(buffer, chn, count);
+			return;
+		}
+	
+		const mp_sint32 voll = chn->finalvoll;
+		const mp_sint32 volr = chn->finalvolr;
+		
+		const mp_sint32 rampFromVolStepL = chn->rampFromVolStepL;
+		const mp_sint32 rampFromVolStepR = chn->rampFromVolStepR;		
+		
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 posfixed = chn->smpposfrac;
+		
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos, chn->smpposfrac, fp, 16);
+		
+		if ((voll == 0 && rampFromVolStepL == 0) && (volr == 0 && rampFromVolStepR == 0)) return;
+		
+		if (!(chn->flags&4))
+			kernels->lerp8(buffer, chn->sample + basepos, posfixed, smpadd, voll, volr, rampFromVolStepL, rampFromVolStepR, count);
+		else
+			kernels->lerp16(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, voll, volr, rampFromVolStepL, rampFromVolStepR, count);
+
+		chn->finalvoll = voll + rampFromVolStepL*(mp_sint32)count;
+		chn->finalvolr = volr + rampFromVolStepR*(mp_sint32)count;
+	}
+};
+
+class ResamplerBLSSIMD : public ResamplerBLS
+{
+private:
+	const ResamplerSIMD::Kernels* kernels;
+
+public:
+	ResamplerBLSSIMD(const ResamplerSIMD::Kernels* kernels) :
+		kernels(kernels)
+	{
+	}
+
+	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+	{
+		mp_sint32 voll = 0;
+		mp_sint32 volr = 0;
+
+		getVolumeLR(chn, voll, volr);
+
+		const mp_sint32 basepos = chn->smppos;
+		const mp_sint32 smpadd = (chn->flags&ChannelMixer::MP_SAMPLE_BACKWARD) ? -chn->smpadd : chn->smpadd;
+		const mp_sint32 posfixed = chn->smpposfrac;
+
+		mp_sint32 fp = smpadd*count;
+		MP_INCREASESMPPOS(chn->smppos,chn->smpposfrac,fp,16);
+
+		if ((voll == 0) && (volr == 0)) return;
+
+		if (!(chn->flags&4))
+			kernels->bls8(buffer, chn->sample + basepos, posfixed, smpadd, voll, volr, chn->bitshift, chn->bitmask, count);
+		else
+			kernels->normal16(buffer, (const mp_sword*)chn->sample + basepos, posfixed, smpadd, voll, volr, 0, 0, count);
+	}
+};
+
 #endif
@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ResamplerSIMD.cpp
+ *  MilkyPlay
+ *
+ *  SSE2, AVX2 and NEON kernels for the non-checking block mixers.
+ *  Every kernel walks the sample positions exactly like PROCESS_BLOCK
+ *  does and only vectorises the arithmetic, the integer expressions
+ *  are the same as in ResamplerMacros.h.
+ */
+
+#include "ResamplerSIMD.h"
+
+#if !defined(MP_NO_SIMD)
+	#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+		#define MP_SIMD_X86
+		#include <emmintrin.h>
+		#include <immintrin.h>
+		#ifdef _MSC_VER
+			#include <intrin.h>
+		#endif
+	#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+		#define MP_SIMD_NEON
+		#include <arm_neon.h>
+	#endif
+#endif
+
+// GCC and clang only emit instructions beyond the target baseline
+// if the function is tagged, MSVC doesn't care
+#if defined(__GNUC__) || defined(__clang__)
+	#define MP_TARGET_SSE2 __attribute__((target("sse2")))
+	#define MP_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+	#define MP_TARGET_SSE2
+	#define MP_TARGET_AVX2
+#endif
+
+static bool simdDisabled = false;
+
+// 8 bit samples are scaled up to 16 bit just like in the mixer macros
+static inline mp_sint32 fetchSample(const mp_sbyte* sample, mp_sint32 index) { return sample[index]<<8; }
+static inline mp_sint32 fetchSample(const mp_sword* sample, mp_sint32 index) { return sample[index]; }
+
+/////////////////////////////////////////////////////////
+//	          SCALAR REFERENCE (AND TAILS)	           //
+/////////////////////////////////////////////////////////
+template<class T>
+static void mixNormalScalar(mp_sint32* buffer, const T* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+							mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	while (count--)
+	{
+		const mp_sint32 sd1 = fetchSample(sample, posfixed>>16);
+		(*buffer++)+=((sd1*(voll>>15))>>15);
+		(*buffer++)+=((sd1*(volr>>15))>>15);
+		voll+=rampL;
+		volr+=rampR;
+		posfixed+=smpadd;
+	}
+}
+
+template<class T>
+static void mixLerpScalar(mp_sint32* buffer, const T* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+						  mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	while (count--)
+	{
+		mp_sint32 sd1 = fetchSample(sample, posfixed>>16);
+		const mp_sint32 sd2 = fetchSample(sample, (posfixed>>16)+1);
+		sd1 = ((sd1<<12)+((posfixed>>4)&0xfff)*(sd2-sd1))>>12;
+		(*buffer++)+=((sd1*(voll>>15))>>15);
+		(*buffer++)+=((sd1*(volr>>15))>>15);
+		voll+=rampL;
+		volr+=rampR;
+		posfixed+=smpadd;
+	}
+}
+
+static inline mp_sint32 fetchSampleBLS(const mp_sbyte* sample, mp_sint32 index, const mp_ubyte bitshift, const mp_ubyte bitmask)
+{
+	return mp_sint32(mp_sbyte((sample[index] >> bitshift) & bitmask)) << 8;
+}
+
+static void mixBLSScalar(mp_sint32* buffer, const mp_sbyte* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+						 const mp_sint32 voll, const mp_sint32 volr, const mp_ubyte bitshift, const mp_ubyte bitmask, mp_uint32 count)
+{
+	while (count--)
+	{
+		const mp_sint32 sd1 = fetchSampleBLS(sample, posfixed>>16, bitshift, bitmask);
+		(*buffer++)+=((sd1*voll)>>8);
+		(*buffer++)+=((sd1*volr)>>8);
+		posfixed+=smpadd;
+	}
+}
+
+/////////////////////////////////////////////////////////
+//	         SAMPLE WALKING FOR THE VECTOR UNITS       //
+/////////////////////////////////////////////////////////
+template<class T, mp_sint32 N>
+static inline void gatherPoints(const T* sample, mp_sint32& posfixed, const mp_sint32 smpadd, mp_sint32* sd)
+{
+	for (mp_sint32 i = 0; i < N; i++)
+	{
+		sd[i] = fetchSample(sample, posfixed>>16);
+		posfixed+=smpadd;
+	}
+}
+
+template<class T, mp_sint32 N>
+static inline void gatherPairs(const T* sample, mp_sint32& posfixed, const mp_sint32 smpadd, mp_sint32* sd1, mp_sint32* sd2, mp_sint32* frac)
+{
+	for (mp_sint32 i = 0; i < N; i++)
+	{
+		sd1[i] = fetchSample(sample, posfixed>>16);
+		sd2[i] = fetchSample(sample, (posfixed>>16)+1);
+		frac[i] = (posfixed>>4)&0xfff;
+		posfixed+=smpadd;
+	}
+}
+
+template<mp_sint32 N>
+static inline void gatherPointsBLS(const mp_sbyte* sample, mp_sint32& posfixed, const mp_sint32 smpadd, const mp_ubyte bitshift, const mp_ubyte bitmask, mp_sint32* sd)
+{
+	for (mp_sint32 i = 0; i < N; i++)
+	{
+		sd[i] = fetchSampleBLS(sample, posfixed>>16, bitshift, bitmask);
+		posfixed+=smpadd;
+	}
+}
+
+#if defined(MP_SIMD_X86)
+
+/////////////////////////////////////////////////////////
+//	                      SSE2	                       //
+/////////////////////////////////////////////////////////
+// SSE2 has no 32x32 bit multiplication, instead pmaddwd is used on
+// values which are known to fit into 16 bits, which is exact as long as
+// the shifted volumes fit into 16 bits as well
+static inline bool volumeFits16(mp_sint32 vol, mp_sint32 ramp, mp_uint32 count, mp_sint32 shift)
+{
+	const mp_int64 first = (mp_int64)vol;
+	const mp_int64 last = (mp_int64)vol + (mp_int64)ramp * (mp_int64)(count ? count - 1 : 0);
+	return (first >> shift) >= -32768 && (first >> shift) <= 32767 && 
+		   (last >> shift) >= -32768 && (last >> shift) <= 32767;
+}
+
+MP_TARGET_SSE2 static inline void mixStereoSSE2(mp_sint32* buffer, const __m128i sd, const __m128i vl, const __m128i vr, const int outShift)
+{
+	// sd and the volumes are sign extended 16 bit values, masking the upper 
+	// half of sd turns pmaddwd into a plain 16x16->32 bit multiplication
+	const __m128i sdlo = _mm_and_si128(sd, _mm_set1_epi32(0xFFFF));
+	const __m128i l = _mm_sra_epi32(_mm_madd_epi16(sdlo, vl), _mm_cvtsi32_si128(outShift));
+	const __m128i r = _mm_sra_epi32(_mm_madd_epi16(sdlo, vr), _mm_cvtsi32_si128(outShift));
+	
+	__m128i* dst = (__m128i*)buffer;
+	_mm_storeu_si128(dst, _mm_add_epi32(_mm_loadu_si128(dst), _mm_unpacklo_epi32(l, r)));
+	_mm_storeu_si128(dst + 1, _mm_add_epi32(_mm_loadu_si128(dst + 1), _mm_unpackhi_epi32(l, r)));
+}
+
+template<class T>
+MP_TARGET_SSE2 static void mixNormalSSE2(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+										 mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+
+	if (!volumeFits16(voll, rampL, count, 15) || !volumeFits16(volr, rampR, count, 15))
+	{
+		mixNormalScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, count);
+		return;
+	}
+
+	__m128i vl = _mm_set_epi32(voll+3*rampL, voll+2*rampL, voll+rampL, voll);
+	__m128i vr = _mm_set_epi32(volr+3*rampR, volr+2*rampR, volr+rampR, volr);
+	const __m128i stepl = _mm_set1_epi32(rampL*4);
+	const __m128i stepr = _mm_set1_epi32(rampR*4);
+
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<2);
+	volr+=rampR*(mp_sint32)(blockCount<<2);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd[4];
+		gatherPoints<T, 4>(sample, posfixed, smpadd, sd);
+		
+		mixStereoSSE2(buffer, _mm_loadu_si128((const __m128i*)sd), _mm_srai_epi32(vl, 15), _mm_srai_epi32(vr, 15), 15);
+
+		vl = _mm_add_epi32(vl, stepl);
+		vr = _mm_add_epi32(vr, stepr);
+		buffer+=4*MP_NUMCHANNELS;
+	}
+	
+	mixNormalScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+template<class T>
+MP_TARGET_SSE2 static void mixLerpSSE2(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+									   mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+
+	if (!volumeFits16(voll, rampL, count, 15) || !volumeFits16(volr, rampR, count, 15))
+	{
+		mixLerpScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, count);
+		return;
+	}
+
+	__m128i vl = _mm_set_epi32(voll+3*rampL, voll+2*rampL, voll+rampL, voll);
+	__m128i vr = _mm_set_epi32(volr+3*rampR, volr+2*rampR, volr+rampR, volr);
+	const __m128i stepl = _mm_set1_epi32(rampL*4);
+	const __m128i stepr = _mm_set1_epi32(rampR*4);
+	const __m128i lo16 = _mm_set1_epi32(0xFFFF);
+	const __m128i one = _mm_set1_epi32(1<<12);
+
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<2);
+	volr+=rampR*(mp_sint32)(blockCount<<2);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd1[4], sd2[4], frac[4];
+		gatherPairs<T, 4>(sample, posfixed, smpadd, sd1, sd2, frac);
+		
+		// (sd1<<12)+frac*(sd2-sd1) == sd1*(4096-frac) + sd2*frac
+		const __m128i f = _mm_loadu_si128((const __m128i*)frac);
+		const __m128i pairs = _mm_or_si128(_mm_and_si128(_mm_loadu_si128((const __m128i*)sd1), lo16), 
+										   _mm_slli_epi32(_mm_loadu_si128((const __m128i*)sd2), 16));
+		const __m128i weights = _mm_or_si128(_mm_sub_epi32(one, f), _mm_slli_epi32(f, 16));
+		const __m128i sd = _mm_srai_epi32(_mm_madd_epi16(pairs, weights), 12);
+		
+		mixStereoSSE2(buffer, sd, _mm_srai_epi32(vl, 15), _mm_srai_epi32(vr, 15), 15);
+
+		vl = _mm_add_epi32(vl, stepl);
+		vr = _mm_add_epi32(vr, stepr);
+		buffer+=4*MP_NUMCHANNELS;
+	}
+	
+	mixLerpScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+MP_TARGET_SSE2 static void mixBLSSSE2(mp_sint32* buffer, const mp_sbyte* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+									  const mp_sint32 voll, const mp_sint32 volr, const mp_ubyte bitshift, const mp_ubyte bitmask, mp_uint32 count)
+{
+	if (!volumeFits16(voll, 0, count, 0) || !volumeFits16(volr, 0, count, 0))
+	{
+		mixBLSScalar(buffer, sample, posfixed, smpadd, voll, volr, bitshift, bitmask, count);
+		return;
+	}
+
+	const __m128i vl = _mm_set1_epi32(voll);
+	const __m128i vr = _mm_set1_epi32(volr);
+	
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+
+	while (blockCount--)
+	{
+		mp_sint32 sd[4];
+		gatherPointsBLS<4>(sample, posfixed, smpadd, bitshift, bitmask, sd);
+		
+		mixStereoSSE2(buffer, _mm_loadu_si128((const __m128i*)sd), vl, vr, 8);
+		
+		buffer+=4*MP_NUMCHANNELS;
+	}
+
+	mixBLSScalar(buffer, sample, posfixed, smpadd, voll, volr, bitshift, bitmask, remainCount);
+}
+
+static const ResamplerSIMD::Kernels kernelsSSE2 =
+{
+	ResamplerSIMD::ISA_SSE2,
+	&mixNormalSSE2<mp_sbyte>,
+	&mixNormalSSE2<mp_sword>,
+	&mixLerpSSE2<mp_sbyte>,
+	&mixLerpSSE2<mp_sword>,
+	&mixBLSSSE2
+};
+
+/////////////////////////////////////////////////////////
+//	                      AVX2	                       //
+/////////////////////////////////////////////////////////
+MP_TARGET_AVX2 static inline void mixStereoAVX2(mp_sint32* buffer, const __m256i l, const __m256i r)
+{
+	// interleave to l0 r0 l1 r1 ... l7 r7
+	const __m256i lo = _mm256_unpacklo_epi32(l, r);
+	const __m256i hi = _mm256_unpackhi_epi32(l, r);
+	
+	__m256i* dst = (__m256i*)buffer;
+	_mm256_storeu_si256(dst, _mm256_add_epi32(_mm256_loadu_si256(dst), _mm256_permute2x128_si256(lo, hi, 0x20)));
+	_mm256_storeu_si256(dst + 1, _mm256_add_epi32(_mm256_loadu_si256(dst + 1), _mm256_permute2x128_si256(lo, hi, 0x31)));
+}
+
+template<class T>
+MP_TARGET_AVX2 static void mixNormalAVX2(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+										 mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+	const __m256i ramp = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	
+	__m256i vl = _mm256_add_epi32(_mm256_set1_epi32(voll), _mm256_mullo_epi32(ramp, _mm256_set1_epi32(rampL)));
+	__m256i vr = _mm256_add_epi32(_mm256_set1_epi32(volr), _mm256_mullo_epi32(ramp, _mm256_set1_epi32(rampR)));
+	const __m256i stepl = _mm256_set1_epi32(rampL*8);
+	const __m256i stepr = _mm256_set1_epi32(rampR*8);
+
+	mp_uint32 blockCount = count >> 3;
+	const mp_uint32 remainCount = count & 7;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<3);
+	volr+=rampR*(mp_sint32)(blockCount<<3);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd[8];
+		gatherPoints<T, 8>(sample, posfixed, smpadd, sd);
+		
+		const __m256i s = _mm256_loadu_si256((const __m256i*)sd);
+		mixStereoAVX2(buffer, 
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(vl, 15)), 15),
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(vr, 15)), 15));
+
+		vl = _mm256_add_epi32(vl, stepl);
+		vr = _mm256_add_epi32(vr, stepr);
+		buffer+=8*MP_NUMCHANNELS;
+	}
+	
+	mixNormalScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+template<class T>
+MP_TARGET_AVX2 static void mixLerpAVX2(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+									   mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+	const __m256i ramp = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	
+	__m256i vl = _mm256_add_epi32(_mm256_set1_epi32(voll), _mm256_mullo_epi32(ramp, _mm256_set1_epi32(rampL)));
+	__m256i vr = _mm256_add_epi32(_mm256_set1_epi32(volr), _mm256_mullo_epi32(ramp, _mm256_set1_epi32(rampR)));
+	const __m256i stepl = _mm256_set1_epi32(rampL*8);
+	const __m256i stepr = _mm256_set1_epi32(rampR*8);
+
+	mp_uint32 blockCount = count >> 3;
+	const mp_uint32 remainCount = count & 7;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<3);
+	volr+=rampR*(mp_sint32)(blockCount<<3);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd1[8], sd2[8], frac[8];
+		gatherPairs<T, 8>(sample, posfixed, smpadd, sd1, sd2, frac);
+		
+		const __m256i s1 = _mm256_loadu_si256((const __m256i*)sd1);
+		const __m256i s2 = _mm256_loadu_si256((const __m256i*)sd2);
+		const __m256i f = _mm256_loadu_si256((const __m256i*)frac);
+		const __m256i s = _mm256_srai_epi32(_mm256_add_epi32(_mm256_slli_epi32(s1, 12), 
+															 _mm256_mullo_epi32(f, _mm256_sub_epi32(s2, s1))), 12);
+		
+		mixStereoAVX2(buffer, 
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(vl, 15)), 15),
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, _mm256_srai_epi32(vr, 15)), 15));
+
+		vl = _mm256_add_epi32(vl, stepl);
+		vr = _mm256_add_epi32(vr, stepr);
+		buffer+=8*MP_NUMCHANNELS;
+	}
+	
+	mixLerpScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+MP_TARGET_AVX2 static void mixBLSAVX2(mp_sint32* buffer, const mp_sbyte* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+									  const mp_sint32 voll, const mp_sint32 volr, const mp_ubyte bitshift, const mp_ubyte bitmask, mp_uint32 count)
+{
+	const __m256i vl = _mm256_set1_epi32(voll);
+	const __m256i vr = _mm256_set1_epi32(volr);
+	
+	mp_uint32 blockCount = count >> 3;
+	const mp_uint32 remainCount = count & 7;
+
+	while (blockCount--)
+	{
+		mp_sint32 sd[8];
+		gatherPointsBLS<8>(sample, posfixed, smpadd, bitshift, bitmask, sd);
+		
+		const __m256i s = _mm256_loadu_si256((const __m256i*)sd);
+		mixStereoAVX2(buffer, 
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, vl), 8),
+					  _mm256_srai_epi32(_mm256_mullo_epi32(s, vr), 8));
+		
+		buffer+=8*MP_NUMCHANNELS;
+	}
+
+	mixBLSScalar(buffer, sample, posfixed, smpadd, voll, volr, bitshift, bitmask, remainCount);
+}
+
+static const ResamplerSIMD::Kernels kernelsAVX2 =
+{
+	ResamplerSIMD::ISA_AVX2,
+	&mixNormalAVX2<mp_sbyte>,
+	&mixNormalAVX2<mp_sword>,
+	&mixLerpAVX2<mp_sbyte>,
+	&mixLerpAVX2<mp_sword>,
+	&mixBLSAVX2
+};
+
+#elif defined(MP_SIMD_NEON)
+
+/////////////////////////////////////////////////////////
+//	                      NEON	                       //
+/////////////////////////////////////////////////////////
+static inline void mixStereoNEON(mp_sint32* buffer, const int32x4_t l, const int32x4_t r)
+{
+	int32x4x2_t dst = vld2q_s32(buffer);
+	dst.val[0] = vaddq_s32(dst.val[0], l);
+	dst.val[1] = vaddq_s32(dst.val[1], r);
+	vst2q_s32(buffer, dst);
+}
+
+static inline int32x4_t rampNEON(const mp_sint32 vol, const mp_sint32 ramp)
+{
+	const mp_sint32 v[4] = { vol, vol+ramp, vol+2*ramp, vol+3*ramp };
+	return vld1q_s32(v);
+}
+
+template<class T>
+static void mixNormalNEON(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+						  mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+
+	int32x4_t vl = rampNEON(voll, rampL);
+	int32x4_t vr = rampNEON(volr, rampR);
+	const int32x4_t stepl = vdupq_n_s32(rampL*4);
+	const int32x4_t stepr = vdupq_n_s32(rampR*4);
+
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<2);
+	volr+=rampR*(mp_sint32)(blockCount<<2);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd[4];
+		gatherPoints<T, 4>(sample, posfixed, smpadd, sd);
+		
+		const int32x4_t s = vld1q_s32(sd);
+		mixStereoNEON(buffer, 
+					  vshrq_n_s32(vmulq_s32(s, vshrq_n_s32(vl, 15)), 15), 
+					  vshrq_n_s32(vmulq_s32(s, vshrq_n_s32(vr, 15)), 15));
+
+		vl = vaddq_s32(vl, stepl);
+		vr = vaddq_s32(vr, stepr);
+		buffer+=4*MP_NUMCHANNELS;
+	}
+	
+	mixNormalScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+template<class T>
+static void mixLerpNEON(mp_sint32* buffer, const void* smp, mp_sint32 posfixed, const mp_sint32 smpadd, 
+						mp_sint32 voll, mp_sint32 volr, const mp_sint32 rampL, const mp_sint32 rampR, mp_uint32 count)
+{
+	const T* sample = (const T*)smp;
+
+	int32x4_t vl = rampNEON(voll, rampL);
+	int32x4_t vr = rampNEON(volr, rampR);
+	const int32x4_t stepl = vdupq_n_s32(rampL*4);
+	const int32x4_t stepr = vdupq_n_s32(rampR*4);
+
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+	
+	voll+=rampL*(mp_sint32)(blockCount<<2);
+	volr+=rampR*(mp_sint32)(blockCount<<2);
+	
+	while (blockCount--)
+	{
+		mp_sint32 sd1[4], sd2[4], frac[4];
+		gatherPairs<T, 4>(sample, posfixed, smpadd, sd1, sd2, frac);
+		
+		const int32x4_t s1 = vld1q_s32(sd1);
+		const int32x4_t s = vshrq_n_s32(vmlaq_s32(vshlq_n_s32(s1, 12), vld1q_s32(frac), vsubq_s32(vld1q_s32(sd2), s1)), 12);
+		
+		mixStereoNEON(buffer, 
+					  vshrq_n_s32(vmulq_s32(s, vshrq_n_s32(vl, 15)), 15), 
+					  vshrq_n_s32(vmulq_s32(s, vshrq_n_s32(vr, 15)), 15));
+
+		vl = vaddq_s32(vl, stepl);
+		vr = vaddq_s32(vr, stepr);
+		buffer+=4*MP_NUMCHANNELS;
+	}
+	
+	mixLerpScalar(buffer, sample, posfixed, smpadd, voll, volr, rampL, rampR, remainCount);
+}
+
+static void mixBLSNEON(mp_sint32* buffer, const mp_sbyte* sample, mp_sint32 posfixed, const mp_sint32 smpadd, 
+					   const mp_sint32 voll, const mp_sint32 volr, const mp_ubyte bitshift, const mp_ubyte bitmask, mp_uint32 count)
+{
+	const int32x4_t vl = vdupq_n_s32(voll);
+	const int32x4_t vr = vdupq_n_s32(volr);
+	
+	mp_uint32 blockCount = count >> 2;
+	const mp_uint32 remainCount = count & 3;
+
+	while (blockCount--)
+	{
+		mp_sint32 sd[4];
+		gatherPointsBLS<4>(sample, posfixed, smpadd, bitshift, bitmask, sd);
+		
+		const int32x4_t s = vld1q_s32(sd);
+		mixStereoNEON(buffer, vshrq_n_s32(vmulq_s32(s, vl), 8), vshrq_n_s32(vmulq_s32(s, vr), 8));
+		
+		buffer+=4*MP_NUMCHANNELS;
+	}
+
+	mixBLSScalar(buffer, sample, posfixed, smpadd, voll, volr, bitshift, bitmask, remainCount);
+}
+
+static const ResamplerSIMD::Kernels kernelsNEON =
+{
+	ResamplerSIMD::ISA_NEON,
+	&mixNormalNEON<mp_sbyte>,
+	&mixNormalNEON<mp_sword>,
+	&mixLerpNEON<mp_sbyte>,
+	&mixLerpNEON<mp_sword>,
+	&mixBLSNEON
+};
+
+#endif
+
+ResamplerSIMD::InstructionSets ResamplerSIMD::detectInstructionSet()
+{
+#if defined(MP_SIMD_X86)
+	#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int maxLeaf = info[0];
+	__cpuid(info, 1);
+	const bool sse2 = (info[3] & (1<<26)) != 0;
+	// AVX2 also needs the OS to save the upper YMM halves
+	const bool osxsave = (info[2] & (1<<27)) != 0;
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1<<5)) != 0;
+	}
+	#else
+	__builtin_cpu_init();
+	const bool sse2 = __builtin_cpu_supports("sse2") != 0;
+	const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+	#endif
+	
+	if (avx2)
+		return ISA_AVX2;
+	if (sse2)
+		return ISA_SSE2;
+	return ISA_NONE;
+#elif defined(MP_SIMD_NEON)
+	return ISA_NEON;
+#else
+	return ISA_NONE;
+#endif
+}
+
+const ResamplerSIMD::Kernels* ResamplerSIMD::getKernels(InstructionSets isa)
+{
+	switch (isa)
+	{
+#if defined(MP_SIMD_X86)
+		case ISA_SSE2:
+			return &kernelsSSE2;
+		case ISA_AVX2:
+			return &kernelsAVX2;
+#elif defined(MP_SIMD_NEON)
+		case ISA_NEON:
+			return &kernelsNEON;
+#endif
+		default:
+			return NULL;
+	}
+}
+
+const ResamplerSIMD::Kernels* ResamplerSIMD::getBestKernels()
+{
+	if (simdDisabled)
+		return NULL;
+
+	static const InstructionSets isa = detectInstructionSet();
+	return getKernels(isa);
+}
+
+void ResamplerSIMD::setDisabled(bool disabled)
+{
+	simdDisabled = disabled;
+}
+
+bool ResamplerSIMD::isDisabled()
+{
+	return simdDisabled;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ResamplerSIMD.h
+ *  MilkyPlay
+ *
+ *  Vector versions of the non-checking block mixers found in
+ *  ResamplerFast.h. The kernels process several output frames per
+ *  iteration but compute exactly the same integer expressions as the
+ *  NOCHECKMIXER_* macros, so the mixed result is bit identical to the
+ *  scalar resamplers. The instruction set is picked at runtime by
+ *  ResamplerFactory::createResampler.
+ */
+
+#ifndef __RESAMPLERSIMD_H__
+#define __RESAMPLERSIMD_H__
+
+#include "ChannelMixer.h"
+
+struct ResamplerSIMD
+{
+	enum InstructionSets
+	{
+		ISA_NONE,
+		ISA_SSE2,
+		ISA_AVX2,
+		ISA_NEON
+	};
+
+	// mixes count frames of a sample into a stereo 32 bit buffer
+	// sample points to the 8 or 16 bit data at the integer base position,
+	// posfixed is the 16.16 walking position relative to that pointer,
+	// voll/volr are stepped by rampL/rampR after every frame (pass 0 for no ramping)
+	typedef void (*TMixKernel)(mp_sint32* buffer, 
+							   const void* sample, 
+							   mp_sint32 posfixed, 
+							   const mp_sint32 smpadd, 
+							   mp_sint32 voll, 
+							   mp_sint32 volr, 
+							   const mp_sint32 rampL, 
+							   const mp_sint32 rampR, 
+							   mp_uint32 count);
+	
+	// BLS variant of the 8 bit non-interpolating mixer
+	typedef void (*TMixKernelBLS)(mp_sint32* buffer, 
+								  const mp_sbyte* sample, 
+								  mp_sint32 posfixed, 
+								  const mp_sint32 smpadd, 
+								  const mp_sint32 voll, 
+								  const mp_sint32 volr, 
+								  const mp_ubyte bitshift, 
+								  const mp_ubyte bitmask, 
+								  mp_uint32 count);
+	
+	struct Kernels
+	{
+		InstructionSets isa;
+		TMixKernel		normal8;
+		TMixKernel		normal16;
+		TMixKernel		lerp8;
+		TMixKernel		lerp16;
+		TMixKernelBLS	bls8;
+	};
+
+	// best instruction set supported by the CPU we're running on
+	static InstructionSets detectInstructionSet();
+	
+	// returns NULL if the instruction set has not been compiled in
+	static const Kernels* getKernels(InstructionSets isa);
+	
+	// returns NULL if there is no vector unit to use
+	static const Kernels* getBestKernels();
+	
+	// allows to switch back to the scalar resamplers (e.g. for comparison)
+	static void setDisabled(bool disabled);
+	static bool isDisabled();
+};
+
+#endif
@@ -36,10 +36,6 @@ extern "C"
 #	include "DEMOSDK/BASTYPES.H"
 #	include "DEMOSDK/SYNTHYM.H"
 
-	bool				g_ymplayerInitialized = false;
-	SNDYMplayer			g_ymplayer;
-	SNDYMsoundSet		g_ymsoundSet;
-
 	// allocator
 	static void* stdAlloc(void* _alloc, u32 _size)
 	{
@@ -66,8 +62,19 @@ extern "C"
 
 const mp_uint32 CACHE_LENGTH	  = 4096;
 
- // Resampler without interpolation or ramping
-ResamplerYM* ResamplerYM::ms_instance = nullptr;
+static void freeSoundSet(SNDYMsoundSet* soundSet)
+{
+	SNDYMfreeSounds(&stdAllocator, soundSet);
+	delete soundSet;
+}
+
+static std::shared_ptr<SNDYMsoundSet> createSoundSet()
+{
+	return std::shared_ptr<SNDYMsoundSet>(new SNDYMsoundSet(), freeSoundSet);
+}
+
+char ResamplerYM::ms_path[512] = "";
+std::shared_ptr<SNDYMsoundSet> ResamplerYM::ms_soundSet = createSoundSet();
 
 void ResamplerYM::YMparam::Init()
 {
@@ -76,53 +83,44 @@ void ResamplerYM::YMparam::Init()
 }
 
 ResamplerYM::ResamplerYM() 
-	: isinitialized(false) 
 {
+	// envelope and volume tables are shared by all chips, build them once
+	static const bool tablesBuilt = (EMULinitYM(), true);
+	(void)tablesBuilt;
+
 	for (auto& i : ymparams)
 	{
 		i.Init();
 	}
 
-	memset(m_bufferCopy, 0, sizeof(m_bufferCopy));
-
 	m_cache = new mp_sint32[CACHE_LENGTH];
-	strcpy(m_path, "");
 
 	m_STebalanceLeft = m_STebalanceRight = 20;
 
-	assert(ms_instance == nullptr);
-	ms_instance = this;
-}
+	m_soundSet = std::atomic_load(&ms_soundSet);
 
-const char* ResamplerYM::GetError()
-{
-	return SNDYMgetError();
+	m_chip = EMULcreateYM();
+	m_player = new SNDYMplayer();
+	m_player->YMregs.chip = m_chip;
+	SNDYMinitPlayer(&stdAllocator, m_player, m_soundSet.get());
 }
 
-mp_sint32* ResamplerYM::getBufferCopy(mp_uint32 _index, mp_uint32 _count)
+ResamplerYM::~ResamplerYM()
 {
-	assert((_index + _count) <= BUFFERCOPY_LENGTH);
-	return &m_bufferCopy[_index];
+	SNDYMfreePlayer(&stdAllocator, m_player);
+	delete m_player;
+	EMULfreeYM(m_chip);
+	delete[] m_cache;
 }
 
-bool ResamplerYM::Init() 
+const char* ResamplerYM::GetError()
 {
-	if (isinitialized == false)
-	{
-		SNDYMsoundSet* soundsSet = NULL;
-
-		memset(&g_ymplayer, 0, sizeof(g_ymplayer));
-		EMULinitYM();
-		isinitialized = true;
-		SNDYMinitPlayer (&stdAllocator, &g_ymplayer, &g_ymsoundSet);
-	}
-
-	return isinitialized;
+	return SNDYMgetError();
 }
 
 void ResamplerYM::Stop()
 {
-	SNDYMstop(&g_ymplayer);
+	SNDYMstop(m_player);
 	memset(ymparams, 0, sizeof(ymparams));
 
 	for (u32 t = 0 ; t < SND_YM_NB_CHANNELS ; t++)
@@ -133,35 +131,37 @@ void ResamplerYM::Stop()
 
 bool ResamplerYM::Reload()
 {
-	Stop();
-
-	SNDYMfreeSounds(&stdAllocator, &g_ymsoundSet);
+	std::shared_ptr<SNDYMsoundSet> soundSet = createSoundSet();
+	bool result = false;
 
-	if (m_path[0] != 0)
+	if (ms_path[0] != 0)
 	{	
-		return SNDYMloadSounds (&stdAllocator, m_path, &g_ymsoundSet);
-	}
-	else
-	{
-		return false;
+		result = SNDYMloadSounds (&stdAllocator, ms_path, soundSet.get());
 	}
+
+	// the previous bank is freed once the last chip playing it lets go
+	std::atomic_store(&ms_soundSet, soundSet);
+
+	return result;
 }
 
 mp_uint32 ResamplerYM::GetNbSounds()
 {
-	return g_ymsoundSet.nbSounds;
+	std::shared_ptr<SNDYMsoundSet> soundSet = std::atomic_load(&ms_soundSet);
+	return soundSet->nbSounds;
 }
 
 const char* ResamplerYM::GetSoundName(mp_uint32 _index)
 {
-	assert (_index < g_ymsoundSet.nbSounds);
-	return g_ymsoundSet.names[_index];
+	std::shared_ptr<SNDYMsoundSet> soundSet = std::atomic_load(&ms_soundSet);
+	assert (_index < soundSet->nbSounds);
+	return soundSet->names[_index];
 }
 
 void ResamplerYM::SetMute(mp_uint32 _index, bool _mute)
 {
 	assert(_index < 3);
-	g_ymplayer.commands[_index].mute = _mute;
+	m_player->commands[_index].mute = _mute;
 
 	if (_mute)
 	{
@@ -171,7 +171,16 @@ void ResamplerYM::SetMute(mp_uint32 _index, bool _mute)
 
 void ResamplerYM::UpdateScore()
 {
-	SNDYMcommand* command = g_ymplayer.commands;
+	// a new bank has been loaded, the running sounds refer to the old one
+	std::shared_ptr<SNDYMsoundSet> soundSet = std::atomic_load(&ms_soundSet);
+	if (soundSet != m_soundSet)
+	{
+		Stop();
+		m_soundSet = soundSet;
+		m_player->soundSet = m_soundSet.get();
+	}
+
+	SNDYMcommand* command = m_player->commands;
 
 
 	for (int i = 0; i < SND_YM_NB_CHANNELS; i++, command++)
@@ -199,24 +208,22 @@ void ResamplerYM::UpdateScore()
 	char temp[128];
 
 	sprintf(temp, "%d %d %d - %d %d %d - %d %d %d\n", 
-		g_ymplayer.commands[0].justpressed, g_ymplayer.commands[0].pressed, g_ymplayer.commands[0].key, 
-		g_ymplayer.commands[1].justpressed, g_ymplayer.commands[1].pressed, g_ymplayer.commands[1].key, 
-		g_ymplayer.commands[2].justpressed, g_ymplayer.commands[2].pressed, g_ymplayer.commands[2].key );
+		m_player->commands[0].justpressed, m_player->commands[0].pressed, m_player->commands[0].key, 
+		m_player->commands[1].justpressed, m_player->commands[1].pressed, m_player->commands[1].key, 
+		m_player->commands[2].justpressed, m_player->commands[2].pressed, m_player->commands[2].key );
 
 	OutputDebugString(temp);
 #	endif
 
-	if (g_ymplayer.soundSet->nbSounds > 0)
+	if (m_player->soundSet->nbSounds > 0)
 	{
-		SNDYMupdate(&g_ymplayer);
+		SNDYMupdate(m_player);
 	}
 }
 
 
-void ResamplerYM::fillBufferCopy (mp_sint32* buffer, mp_uint32 count, mp_sint32 voll, mp_sint32 volr)
+void ResamplerYM::mixCache (mp_sint32* buffer, mp_uint32 count, mp_sint32 voll, mp_sint32 volr)
 {
-	mp_sint32* p = m_cache;
-
 	for (unsigned t = 0 ; t < (count << 1) ; )
 	{
 		buffer [t] += (m_cache[t] * voll) >> 6;
@@ -224,54 +231,36 @@ void ResamplerYM::fillBufferCopy (mp_sint32* buffer, mp_uint32 count, mp_sint32
 		buffer [t] += (m_cache[t] * volr) >> 6;
 		t++;
 	}
+}
+
+void ResamplerYM::addBlock(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
+{
+	mp_sint32 voll = 0;
+	mp_sint32 volr = 0;
 
-	unsigned remain = count << 1;
+	getVolumeLR(chn, voll, volr);
 
-	while (remain > 0)
+	// the chip renders whole blocks, the cache only limits their size
+	while (count > 0)
 	{
-		unsigned max = (BUFFERCOPY_LENGTH - m_bufferCopyIndex);
+		const mp_uint32 todo = std::min(count, CACHE_LENGTH / MP_NUMCHANNELS);
 
-		unsigned lentocopy = std::min(remain, max);
+		EMULplaysound(m_chip, m_cache, todo);
 
-		memcpy(&m_bufferCopy[m_bufferCopyIndex], p, lentocopy * sizeof(*m_bufferCopy));
-		p += lentocopy;
-		
-		m_bufferCopyIndex += lentocopy;
-		if (m_bufferCopyIndex >= BUFFERCOPY_LENGTH)
-		{
-			m_bufferCopyIndex = 0;
-		}
+		mixCache(buffer, todo, voll, volr);
 
-		remain -= lentocopy;
+		buffer += todo*MP_NUMCHANNELS;
+		count -= todo;
 	}
 }
 
 void ResamplerYM::addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 {
-	mp_sint32 voll = 0;
-	mp_sint32 volr = 0;
-
-	getVolumeLR(chn, voll, volr);
-
-	//FULLMIXER_TEMPLATE(FULLMIXER_8BIT_BLS, FULLMIXER_16BIT_NORMAL, 16, 0);
-
-	EMULplaysound(m_cache, count);
-
-	fillBufferCopy(buffer, count, voll, volr);
+	addBlock(buffer, chn, count);
 }
 
 void ResamplerYM::addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count)
 {
-	mp_sint32 voll = 0;
-	mp_sint32 volr = 0;
-
-	getVolumeLR(chn, voll, volr);
-
-	//mp_sint32 sd1, sd2;
-
-	//NOCHECKMIXER_TEMPLATE(NOCHECKMIXER_8BIT_BLS, NOCHECKMIXER_16BIT_NORMAL);
-	EMULplaysound(m_cache, count);
-
-	fillBufferCopy(buffer, count, voll, volr);
+	addBlock(buffer, chn, count);
 }
 
@@ -24,23 +24,25 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SO
 #define __RESAMPLERYM_H__
 
 #include <stdio.h>
+#include <memory>
 
 #include "ResamplerMacros.h"
 
 extern "C"
 {
-	struct SNDsynYMsound_;
+	struct SNDYMplayer_;
+	struct SNDYMsoundSet_;
+	struct YM2149context_;
 }
 
-// Resampler without interpolation or ramping
+// Emulates a YM2149 driven by the synth YM player, every mixer with YM channels
+// owns one so they can all play at the same time. The sound bank is shared.
 
 class ResamplerYM : public ChannelMixer::ResamplerBase
 {
-public:
-	static const mp_uint32 BUFFERCOPY_LENGTH = 2000;
-
 private:
-	char m_path[512];
+	static char ms_path[512];
+	static std::shared_ptr<SNDYMsoundSet_> ms_soundSet;
 
 	mp_ubyte m_STebalanceLeft;
 	mp_ubyte m_STebalanceRight;
@@ -53,44 +55,46 @@ private:
 
 	void getVolumeLR (ChannelMixer::TMixerChannel* chn, mp_sint32& voll, mp_sint32& volr)
 	{
-		float fvolL = getSTeBalanceAmp(m_STebalanceLeft)  * 64.0f;
-		float fvolR = getSTeBalanceAmp(m_STebalanceRight) * 64.0f;
+		float fvolL = getSTeBalanceAmp(m_STebalanceLeft)  * (float)ChannelMixer::MP_YMAMPLIFY;
+		float fvolR = getSTeBalanceAmp(m_STebalanceRight) * (float)ChannelMixer::MP_YMAMPLIFY;
 
 		voll = mp_sint32(fvolL);
 		volr = mp_sint32(fvolR);
 	}
 
-	void fillBufferCopy (mp_sint32* buffer, mp_uint32 count, mp_sint32 voll, mp_sint32 volr);
+	void mixCache (mp_sint32* buffer, mp_uint32 count, mp_sint32 voll, mp_sint32 volr);
+	void addBlock (mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count);
 
-	bool isinitialized;
-
-	mp_sint32* m_cache;
+	YM2149context_* m_chip;
+	SNDYMplayer_* m_player;
 
-	static ResamplerYM* ms_instance;
+	// bank the player is reading from, swapped for ms_soundSet by UpdateScore
+	std::shared_ptr<SNDYMsoundSet_> m_soundSet;
 
-	mp_sint32 m_bufferCopy[BUFFERCOPY_LENGTH];
-	mp_sint32 m_bufferCopyIndex = 0; 
+	mp_sint32* m_cache;
 
 public:
 	ResamplerYM();
+	virtual ~ResamplerYM();
 
-	bool Init();
 	void UpdateScore();
-	const char* GetError();
-
-	mp_sint32* getBufferCopy(mp_uint32 _index, mp_uint32 _count);
 
 	void Stop();
-	bool Reload();
 	void SetMute(mp_uint32 _index, bool _mute);
 
-	const char* GetSndSynFilename() const { return m_path; }
+	// The bank is loaded from the UI thread, playing chips pick it up
+	// on their next score update
+	static bool Reload();
+	static const char* GetError();
 
-	void SetSndSynFilename(const char* _filepath) { strcpy(m_path, _filepath); }
+	static const char* GetSndSynFilename() { return ms_path; }
+
+	static void SetSndSynFilename(const char* _filepath) { strcpy(ms_path, _filepath); }
 
 	void SetSTeBalanceLeft  (mp_ubyte _left) { m_STebalanceLeft = _left; }
 	void SetSTeBalanceRight (mp_ubyte _right) { m_STebalanceRight = _right; }
 
+	// Names stay valid until the next Reload() replaces the bank
 	static mp_uint32 GetNbSounds();
 	static const char* GetSoundName (mp_uint32 _index);
 
@@ -101,8 +105,6 @@ public:
 	virtual void addBlockFull(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count);
 	virtual void addBlockNoCheck(mp_sint32* buffer, ChannelMixer::TMixerChannel* chn, mp_uint32 count);
 
-	static ResamplerYM* GetInstance() { return ms_instance; }
-
 	static const mp_ubyte YM_SET_COMMAND = 0x80;
 
 	struct YMparam
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ScopeBuffer.cpp
+ *  MilkyPlay
+ *
+ */
+
+#include "ScopeBuffer.h"
+#include <string.h>
+
+ScopeBuffer::ScopeBuffer() :
+	data(NULL),
+	numChannels(0),
+	capacity(0),
+	maxBlockSize(0),
+	writePosition(0),
+	published(0),
+	timeStamp(0)
+{
+}
+
+ScopeBuffer::~ScopeBuffer()
+{
+	delete[] data;
+}
+
+void ScopeBuffer::resize(mp_uint32 numChannels, mp_uint32 numFrames, mp_uint32 maxBlockSize)
+{
+	mp_uint32 capacity = 1;
+	while (capacity < numFrames + maxBlockSize)
+		capacity <<= 1;
+
+	if (numChannels*capacity != this->numChannels*this->capacity)
+	{
+		delete[] data;
+		data = numChannels ? new mp_sint32[numChannels*capacity] : NULL;
+	}
+
+	if (data)
+		memset(data, 0, numChannels*capacity*sizeof(mp_sint32));
+	
+	this->numChannels = numChannels;
+	this->capacity = capacity;
+	this->maxBlockSize = maxBlockSize;
+	
+	writePosition = 0;
+	published.store(0, std::memory_order_relaxed);
+	timeStamp.store(0, std::memory_order_relaxed);
+}
+
+void ScopeBuffer::write(mp_uint32 channel, const mp_sint32* buffer, mp_uint32 count, mp_uint32 stride/* = 1*/)
+{
+	mp_sint32* plane = data + channel*capacity;
+	mp_uint32 pos = (mp_uint32)writePosition & (capacity-1);
+	
+	for (mp_uint32 i = 0; i < count; i++, buffer+=stride)
+	{
+		plane[pos] = *buffer;
+		pos = (pos+1) & (capacity-1);
+	}
+}
+
+void ScopeBuffer::writeSilence(mp_uint32 channel, mp_uint32 count)
+{
+	mp_sint32* plane = data + channel*capacity;
+	const mp_uint32 pos = (mp_uint32)writePosition & (capacity-1);
+	const mp_uint32 todo = count < capacity - pos ? count : capacity - pos;
+	
+	memset(plane + pos, 0, todo*sizeof(mp_sint32));
+	memset(plane, 0, (count - todo)*sizeof(mp_sint32));
+}
+
+void ScopeBuffer::advance(mp_uint32 count)
+{
+	writePosition += count;
+	published.store(writePosition, std::memory_order_release);
+}
+
+bool ScopeBuffer::read(mp_uint32 channel, mp_int64 endFrame, mp_sint32* buffer, mp_uint32 count) const
+{
+	const mp_int64 written = published.load(std::memory_order_acquire);
+	const mp_int64 startFrame = endFrame - count;
+
+	// available range
+	mp_int64 first = getOldestSafeFrame(written);
+	if (first < startFrame)
+		first = startFrame;
+	if (first < 0)
+		first = 0;
+	mp_int64 last = endFrame < written ? endFrame : written;
+
+	if (channel >= numChannels || first >= last)
+	{
+		memset(buffer, 0, count*sizeof(mp_sint32));
+		return false;
+	}
+	
+	const mp_sint32* plane = data + channel*capacity;
+	const mp_uint32 head = (mp_uint32)(first - startFrame);
+	const mp_uint32 num = (mp_uint32)(last - first);
+	const mp_uint32 pos = (mp_uint32)first & (capacity-1);
+	const mp_uint32 todo = num < capacity - pos ? num : capacity - pos;
+
+	memset(buffer, 0, head*sizeof(mp_sint32));
+	memcpy(buffer + head, plane + pos, todo*sizeof(mp_sint32));
+	memcpy(buffer + head + todo, plane, (num - todo)*sizeof(mp_sint32));
+	memset(buffer + head + num, 0, (count - head - num)*sizeof(mp_sint32));
+
+	// whatever the writer has started to overwrite while we were copying is garbage
+	std::atomic_thread_fence(std::memory_order_acquire);
+	const mp_int64 oldest = getOldestSafeFrame(published.load(std::memory_order_relaxed));
+	if (oldest > first)
+	{
+		const mp_int64 torn = (oldest < last ? oldest : last) - first;
+		memset(buffer + head, 0, (mp_uint32)torn*sizeof(mp_sint32));
+		if (oldest >= last)
+			return false;
+	}
+	
+	return true;
+}
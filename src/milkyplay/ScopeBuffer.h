@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ScopeBuffer.h
+ *  MilkyPlay
+ *
+ *  Keeps the most recently mixed frames of a number of channels around
+ *  for scopes and level meters. There is a single writer (the mixer) and 
+ *  any number of readers and neither side ever waits for the other: 
+ *  readers copy what they need and check afterwards whether the writer
+ *  has overwritten it in the meantime. Frames are addressed by their 
+ *  running number since the last resize, which is also their time stamp.
+ */
+
+#ifndef __SCOPEBUFFER_H__
+#define __SCOPEBUFFER_H__
+
+#include "MilkyPlayCommon.h"
+#include <atomic>
+
+class ScopeBuffer
+{
+public:
+					ScopeBuffer();
+					~ScopeBuffer();
+
+	// room for at least numFrames frames per channel, maxBlockSize is the 
+	// largest block ever written at once. Not safe against readers, the 
+	// owner resizes while it isn't being mixed.
+	void			resize(mp_uint32 numChannels, mp_uint32 numFrames, mp_uint32 maxBlockSize);
+	
+	mp_uint32		getNumChannels() const { return numChannels; }
+	mp_uint32		getCapacity() const { return capacity; }
+
+	// writer: store the next block of one channel (every stride-th value of
+	// buffer), all channels of a block are written before advance() publishes it.
+	// Different channels of the same block may be written from different threads.
+	void			write(mp_uint32 channel, const mp_sint32* buffer, mp_uint32 count, mp_uint32 stride = 1);
+	void			writeSilence(mp_uint32 channel, mp_uint32 count);
+	void			advance(mp_uint32 count);
+	
+	// writer: number of the frame following the last one handed to the audio device,
+	// blocks may be published ahead of it
+	void			setTimeStamp(mp_int64 frame) { timeStamp.store(frame, std::memory_order_release); }
+
+	// number of published frames
+	mp_int64		getWritePosition() const { return published.load(std::memory_order_acquire); }
+	mp_int64		getTimeStamp() const { return timeStamp.load(std::memory_order_acquire); }
+
+	// copies the count frames of a channel which precede endFrame, frames 
+	// which are not published yet or have been overwritten already read as
+	// silence. Returns false if none of them was available.
+	bool			read(mp_uint32 channel, mp_int64 endFrame, mp_sint32* buffer, mp_uint32 count) const;
+
+private:
+	mp_sint32*		data;					// numChannels planes of capacity frames
+	mp_uint32		numChannels;
+	mp_uint32		capacity;				// power of two
+	mp_uint32		maxBlockSize;
+	mp_int64		writePosition;			// writer only, start of the block being written
+	
+	std::atomic<mp_int64> published;
+	std::atomic<mp_int64> timeStamp;
+	
+	// frames before this one may be overwritten by the block after writePosition
+	mp_int64		getOldestSafeFrame(mp_int64 written) const { return written + maxBlockSize - capacity; }
+};
+
+#endif
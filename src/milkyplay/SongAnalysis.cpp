@@ -0,0 +1,615 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  SongAnalysis.cpp
+ *  MilkyPlay
+ *
+ */
+
+#include "SongAnalysis.h"
+#include "XModule.h"
+#include "XMFile.h"
+#include "ChannelMixer.h"
+
+// pattern loops can make a song run for a long time, but not forever
+static const mp_uint32 MaxRowsPerSong = 1 << 22;
+
+// see PlayerSTD::getbpmrate(), the player ticks whenever this overflows
+// a 32 bit counter and it is added once per beat packet
+static mp_uint32 getBpmRate(mp_uint32 bpm)
+{
+	if (!bpm) bpm++;
+	
+	mp_int64 t = ((mp_int64)bpm)<<(32+2);
+	
+	const mp_uint32 timerBase = (mp_uint32)(5.0f*500.0f*(ChannelMixer::MP_BEATLENGTH*ChannelMixer::MP_TIMERFREQ / (float)ChannelMixer::MP_BASEFREQ));
+	
+	return (mp_uint32)(t/timerBase);
+}
+
+struct TLoopState
+{
+	mp_sint32	loopstart;
+	mp_sint32	loopcounter;
+	bool		execloop;
+	bool		isLooping;
+	mp_sint32	loopingValidPosition;
+};
+
+// see PlayerSTD::setNewPosition()
+static void setNewPosition(const TXMHeader& header, TLoopState* channels, mp_sint32& poscnt, mp_sint32 newPos)
+{
+	if (newPos == poscnt)
+		return;
+	
+	if (newPos >= header.ordnum)
+		newPos = header.restart < header.ordnum ? header.restart : 0;
+	
+	// reset looping flags
+	for (mp_sint32 c = 0; c < 256; c++)
+	{
+		channels[c].loopstart = channels[c].loopcounter = 0;
+		channels[c].execloop = channels[c].isLooping = false;
+		channels[c].loopingValidPosition = poscnt;
+	}
+	
+	poscnt = newPos;
+}
+
+SongAnalysis::SongAnalysis()
+{
+	memset(channelUsage, 0, sizeof(channelUsage));
+}
+
+void SongAnalysis::analyze(const XModule& module)
+{
+	const TXMHeader& header = module.header;
+
+	songs.clear();
+	positionOffsets.clear();
+	rowTimes.clear();
+	memset(channelUsage, 0, sizeof(channelUsage));
+	
+	if (!header.ordnum)
+		return;
+
+	positionOffsets.resize(header.ordnum + 1);
+	mp_uint32 numRows = 0;
+	mp_uint32 pos;
+	for (pos = 0; pos < header.ordnum; pos++)
+	{
+		positionOffsets[pos] = numRows;
+		if (header.ord[pos] < header.patnum)
+			numRows += module.phead[header.ord[pos]].rows;
+	}
+	positionOffsets[pos] = numRows;
+	
+	rowTimes.assign(numRows, (mp_uint32)NotPlayed);
+	
+	// rows played by any of the songs
+	std::vector<mp_ubyte> played(header.ordnum*256, 0);
+	
+	pos = 0;
+	while (songs.size() < 256)
+	{
+		TSong song;
+		song.startPos = pos;
+		playSong(module, song, played);
+		songs.push_back(song);
+		
+		// same as XModule::buildSubSongTable(), the next song starts at 
+		// the first position which hasn't been played and isn't empty
+		for (pos = 0; pos < header.ordnum; pos++)
+		{
+			const mp_ubyte ord = header.ord[pos];
+			if (ord >= header.patnum)
+				continue;
+			
+			const TXMPattern& pattern = module.phead[ord];
+			
+			bool wasPlayed = false;
+			for (mp_uint32 row = 0; row < pattern.rows && !wasPlayed; row++)
+				wasPlayed = played[pos*256+row] != 0;
+			
+			if (wasPlayed)
+				continue;
+			
+			const mp_uint32 slotSize = 2 + 2*pattern.effnum;
+			const mp_uint32 numSlots = pattern.rows*pattern.channum;
+			mp_uint32 i;
+			for (i = 0; i < numSlots; i++)
+				if (pattern.patternData[i*slotSize])
+					break;
+			
+			if (i < numSlots)
+				break;
+		}
+		
+		if (pos >= header.ordnum)
+			break;
+	}
+}
+
+void SongAnalysis::playSong(const XModule& module, TSong& song, std::vector<mp_ubyte>& played)
+{
+	const TXMHeader& header = module.header;
+	const bool playModeFT2 = module.getType() == XModule::ModuleType_XM;
+
+	TLoopState channels[256];
+	memset(channels, 0, sizeof(channels));
+	
+	std::vector<mp_ubyte> visited(header.ordnum*256, 0);
+
+	// header speed and tempo are swapped in PlayerSTD
+	mp_sint32 bpm = header.speed ? header.speed : 125;
+	mp_sint32 tickSpeed = header.tempo ? header.tempo : 6;
+	
+	mp_sint32 poscnt = song.startPos;
+	mp_sint32 rowcnt = 0;
+	mp_sint32 startNextRow = -1;
+	
+	// time is counted in beat packets, like the player does
+	mp_uint32 adder = getBpmRate(bpm);
+	mp_uint32 bpmCounter = 0;
+	mp_int64 time = 0;
+	
+	song.endPos = song.startPos;
+	
+	for (mp_uint32 numRows = 0; numRows < MaxRowsPerSong; numRows++)
+	{
+		const mp_ubyte ord = header.ord[poscnt];
+		
+		// nothing to play, go on with the next position
+		if (ord >= header.patnum || module.phead[ord].rows == 0)
+		{
+			memset(&visited[poscnt*256], 1, 256);
+			setNewPosition(header, channels, poscnt, poscnt+1);
+			rowcnt = 0;
+			if (visited[poscnt*256])
+				break;
+			continue;
+		}
+		
+		const TXMPattern& pattern = module.phead[ord];
+		const mp_uint32 numChannels = pattern.channum <= header.channum ? pattern.channum : header.channum;
+		const mp_uint32 slotSize = 2 + 2*pattern.effnum;
+		
+		mp_sint32 c;
+
+		const mp_sint32 absolutePos = poscnt*256+rowcnt;
+		if (visited[absolutePos])
+		{
+			// pattern loop active?
+			bool looping = false;
+			for (c = 0; c < (mp_sint32)numChannels; c++)
+			{
+				if (channels[c].isLooping && channels[c].loopingValidPosition == poscnt)
+				{
+					looping = true;
+					break;
+				}
+			}
+			
+			if (!looping)
+				break;
+		}
+		else
+		{
+			visited[absolutePos] = 1;
+			played[absolutePos] = 1;
+			
+			mp_uint32& rowTime = rowTimes[positionOffsets[poscnt] + rowcnt];
+			if (rowTime == (mp_uint32)NotPlayed)
+				rowTime = (mp_uint32)(time * 1000 / ChannelMixer::MP_TIMERFREQ);
+		}
+		
+		if ((mp_uint32)poscnt > song.endPos)
+			song.endPos = poscnt;
+		
+		mp_ubyte pbreak = 0, pjump = 0;
+		mp_sint32 pbreakpos = 0, pjumppos = 0, pjumprow = 0;
+		mp_sint32 pbreakPriority = 0, pjumpPriority = 0;
+		bool halt = false;
+		mp_sint32 rowTicks = -1;
+		
+		const mp_ubyte* row = pattern.patternData + rowcnt*pattern.channum*slotSize;
+
+		// empty cells don't do anything, they're skipped
+
+		// speed is set in advance, pattern delays depend on it
+		for (c = pattern.getNextChannel(rowcnt, 0); c < (mp_sint32)numChannels; c = pattern.getNextChannel(rowcnt, c+1))
+			for (mp_sint32 e = 0; e < pattern.effnum; e++)
+				if (row[c*slotSize+2+e*2] == 0x0F && row[c*slotSize+2+e*2+1] && row[c*slotSize+2+e*2+1] < 32)
+					tickSpeed = row[c*slotSize+2+e*2+1];
+
+		for (c = pattern.getNextChannel(rowcnt, 0); c < (mp_sint32)numChannels; c = pattern.getNextChannel(rowcnt, c+1))
+		{
+			TLoopState& chnInf = channels[c];
+			const mp_ubyte* slot = row + c*slotSize;
+			
+			bool used = slot[0] || slot[1];
+			
+			for (mp_sint32 e = 0; e < pattern.effnum; e++)
+			{
+				const mp_ubyte eff = slot[2+e*2];
+				const mp_ubyte eop = slot[2+e*2+1];
+				
+				used |= eff != 0;
+				
+				switch (eff)
+				{
+					case 0x0B:
+						pjump = 1;
+						pjumppos = eop;
+						pjumprow = 0;
+						pjumpPriority = MP_NUMEFFECTS * c + e;
+						break;
+
+					case 0x0D:
+						pbreak = 1;
+						pbreakpos = (eop >> 4) * 10 + (eop & 0xf);
+						if (pbreakpos > 63)
+							pbreakpos = 0;
+						pbreakPriority = MP_NUMEFFECTS * c + e;
+						break;
+						
+					case 0x0F:
+						if (!eop)
+							halt = true;
+						break;
+						
+					case 0x36:
+						if (!eop)
+						{
+							chnInf.execloop = false;
+							chnInf.loopstart = rowcnt;
+							chnInf.loopingValidPosition = poscnt;
+						}
+						else if (chnInf.loopcounter == eop)
+						{
+							if (playModeFT2)
+								startNextRow = chnInf.loopstart;
+							
+							chnInf.loopstart = chnInf.loopcounter = 0;
+							chnInf.execloop = chnInf.isLooping = false;
+							chnInf.loopingValidPosition = poscnt;
+						}
+						else
+						{
+							chnInf.execloop = true;
+							chnInf.loopcounter++;
+						}
+						break;
+						
+					case 0x3E:
+						rowTicks = tickSpeed * ((mp_sint32)eop + 1);
+						break;
+				}
+			}
+			
+			if (used)
+				channelUsage[c>>3] |= 1 << (c&7);
+		}
+		
+		if (rowTicks < 0)
+			rowTicks = tickSpeed;
+		
+		for (mp_sint32 i = 0; i < rowTicks; i++)
+		{
+			mp_uint32 last;
+			do
+			{
+				last = bpmCounter;
+				bpmCounter += adder;
+				time++;
+			} while (bpmCounter > last);
+		}
+		
+		if (halt)
+			break;
+		
+		// same as PlayerSTD::tickhandler() from here
+		mp_sint32 newPos = poscnt;
+		
+		if (pbreak && poscnt < header.ordnum-1)
+		{
+			if (!pjump || pjumpPriority > pbreakPriority)
+				newPos = poscnt+1;
+			rowcnt = pbreakpos-1;
+			startNextRow = -1;
+		}
+		else if (pbreak && poscnt == header.ordnum-1)
+		{
+			if (!pjump || pjumpPriority > pbreakPriority)
+				newPos = header.restart;
+			rowcnt = pbreakpos-1;
+			startNextRow = -1;
+		}
+		
+		if (pjump)
+		{
+			if (!pbreak || pjumpPriority > pbreakPriority)
+				rowcnt = pjumprow-1;
+			newPos = pjumppos;
+			startNextRow = -1;
+		}
+		
+		setNewPosition(header, channels, poscnt, newPos);
+		
+		for (c = 0; c < (mp_sint32)numChannels; c++)
+		{
+			if (channels[c].execloop)
+			{
+				rowcnt = channels[c].loopstart-1;
+				channels[c].execloop = false;
+				channels[c].isLooping = true;
+			}
+		}
+		
+		rowcnt++;
+		
+		// reached end of pattern? 
+		const mp_ubyte nextOrd = header.ord[poscnt];
+		if (nextOrd >= header.patnum || rowcnt >= module.phead[nextOrd].rows)
+		{
+			if (startNextRow != -1)
+			{
+				rowcnt = startNextRow;
+				startNextRow = -1;
+			}
+			else
+			{
+				rowcnt = 0;
+			}
+			
+			setNewPosition(header, channels, poscnt, poscnt+1);
+		}
+	}
+	
+	song.duration = (mp_uint32)(time * 1000 / ChannelMixer::MP_TIMERFREQ);
+}
+
+mp_uint32 SongAnalysis::getTime(mp_uint32 pos, mp_uint32 row) const
+{
+	if (pos + 1 >= positionOffsets.size())
+		return (mp_uint32)NotPlayed;
+	
+	const mp_uint32 index = positionOffsets[pos] + row;
+	if (index >= positionOffsets[pos+1])
+		return (mp_uint32)NotPlayed;
+	
+	return rowTimes[index];
+}
+
+mp_uint32 SongAnalysis::getNumUsedChannels() const
+{
+	mp_uint32 numChannels = 0;
+	for (mp_uint32 i = 0; i < 256; i++)
+		if (isChannelUsed(i))
+			numChannels++;
+	return numChannels;
+}
+
+void SongAnalysis::save(XMFileBase& f) const
+{
+	mp_uint32 i;
+	
+	f.writeDword((mp_uint32)songs.size());
+	for (i = 0; i < songs.size(); i++)
+	{
+		f.writeDword(songs[i].startPos);
+		f.writeDword(songs[i].endPos);
+		f.writeDword(songs[i].duration);
+	}
+	
+	f.writeDword((mp_uint32)positionOffsets.size());
+	for (i = 0; i < positionOffsets.size(); i++)
+		f.writeDword(positionOffsets[i]);
+	
+	for (i = 0; i < rowTimes.size(); i++)
+		f.writeDword(rowTimes[i]);
+	
+	f.write(channelUsage, 1, sizeof(channelUsage));
+}
+
+bool SongAnalysis::load(XMFileBase& f)
+{
+	mp_uint32 i;
+	
+	const mp_uint32 numSongs = f.readDword();
+	if (numSongs > 256)
+		return false;
+	
+	songs.resize(numSongs);
+	for (i = 0; i < numSongs; i++)
+	{
+		songs[i].startPos = f.readDword();
+		songs[i].endPos = f.readDword();
+		songs[i].duration = f.readDword();
+	}
+	
+	// nothing at all for songs without positions
+	const mp_uint32 numOffsets = f.readDword();
+	if (numOffsets == 1 || numOffsets > 257 || (numOffsets == 0 && numSongs))
+		return false;
+	
+	const mp_uint32 numPositions = numOffsets ? numOffsets - 1 : 0;
+	for (i = 0; i < numSongs; i++)
+	{
+		if (songs[i].startPos > songs[i].endPos || songs[i].endPos >= numPositions)
+			return false;
+	}
+	
+	// getTime() relies on the offsets starting at 0 and never going back
+	positionOffsets.resize(numOffsets);
+	for (i = 0; i < numOffsets; i++)
+	{
+		positionOffsets[i] = f.readDword();
+		if (i ? positionOffsets[i] < positionOffsets[i-1] : positionOffsets[i] != 0)
+			return false;
+	}
+
+	const mp_uint32 numRows = numOffsets ? positionOffsets[numOffsets-1] : 0;
+	if (numRows > 256*256)
+		return false;
+
+	rowTimes.resize(numRows);
+	for (i = 0; i < numRows; i++)
+		rowTimes[i] = f.readDword();
+	
+	return f.read(channelUsage, 1, sizeof(channelUsage)) == sizeof(channelUsage);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// The cache file holds a version and all entries, each entry is the	//
+// hash, the size of the analysis and the analysis itself				//
+//////////////////////////////////////////////////////////////////////////
+static const mp_uint32 CacheVersion = 0x41534D02;
+
+SongAnalysisCache::SongAnalysisCache(const SYSCHAR* fileName) :
+	fileName(fileName),
+	changed(false)
+{
+	load();
+}
+
+SongAnalysisCache::~SongAnalysisCache()
+{
+	save();
+}
+
+mp_uint64 SongAnalysisCache::hash(XMFileBase& f)
+{
+	// 64 bit FNV-1a
+	mp_uint64 hash = 0xCBF29CE484222325ULL;
+	
+	const mp_ubyte* buffer = f.getBuffer();
+	if (buffer)
+	{
+		const mp_uint32 size = f.size();
+		for (mp_uint32 i = 0; i < size; i++)
+			hash = (hash ^ buffer[i]) * 0x100000001B3ULL;
+		
+		return hash;
+	}
+	
+	const mp_uint32 pos = f.pos();
+	f.seek(0);
+	
+	mp_ubyte chunk[16384];
+	mp_sint32 len;
+	while ((len = f.read(chunk, 1, sizeof(chunk))) > 0)
+	{
+		for (mp_sint32 i = 0; i < len; i++)
+			hash = (hash ^ chunk[i]) * 0x100000001B3ULL;
+	}
+	
+	f.seek(pos);
+	
+	return hash;
+}
+
+bool SongAnalysisCache::lookup(mp_uint64 hash, SongAnalysis& analysis)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	std::map<mp_uint64, std::vector<mp_ubyte> >::iterator it = entries.find(hash);
+	if (it == entries.end())
+		return false;
+	
+	XMMemoryFile f(it->second.data(), (mp_uint32)it->second.size());
+	if (analysis.load(f))
+		return true;
+	
+	// corrupt, it's analysed and stored again
+	entries.erase(it);
+	changed = true;
+	return false;
+}
+
+void SongAnalysisCache::store(mp_uint64 hash, const SongAnalysis& analysis)
+{
+	XMBufferFile f;
+	analysis.save(f);
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	entries[hash].assign(f.getBuffer(), f.getBuffer() + f.size());
+	changed = true;
+}
+
+void SongAnalysisCache::load()
+{
+	if (!XMFile::exists(fileName.c_str()))
+		return;
+	
+	XMMappedFile f(fileName.c_str());
+	if (!f.isOpen() || f.readDword() != CacheVersion)
+		return;
+	
+	while (f.pos() + 12 <= f.size())
+	{
+		mp_uint64 hash = f.readDword();
+		hash |= (mp_uint64)f.readDword() << 32;
+		
+		const mp_uint32 size = f.readDword();
+		if (size > f.size() - f.pos())
+			break;
+		
+		entries[hash].assign(f.getBuffer() + f.pos(), f.getBuffer() + f.pos() + size);
+		f.seek(size, XMFileBase::SeekOffsetTypeCurrent);
+	}
+}
+
+bool SongAnalysisCache::save()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	if (!changed)
+		return true;
+	
+	XMFile f(fileName.c_str(), true);
+	if (!f.isOpenForWriting())
+		return false;
+	
+	f.writeDword(CacheVersion);
+	
+	for (std::map<mp_uint64, std::vector<mp_ubyte> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		f.writeDword((mp_uint32)it->first);
+		f.writeDword((mp_uint32)(it->first >> 32));
+		f.writeDword((mp_uint32)it->second.size());
+		f.write(it->second.data(), 1, (mp_sint32)it->second.size());
+	}
+	
+	changed = false;
+	
+	return true;
+}
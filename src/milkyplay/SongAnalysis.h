@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ *  SongAnalysis.h
+ *  MilkyPlay
+ *
+ *  Play time, sub songs and channel usage of a module, found by running
+ *  through the patterns row by row without any mixing. Results can be kept
+ *  in a cache on disk which is keyed by a hash of the module contents, so
+ *  the same file doesn't have to be loaded again to show its play time.
+ */
+
+#ifndef __SONGANALYSIS_H__
+#define __SONGANALYSIS_H__
+
+#include "MilkyPlayTypes.h"
+#include "MilkyPlayCommon.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <string>
+
+class XModule;
+class XMFileBase;
+
+class SongAnalysis
+{
+public:
+	struct TSong
+	{
+		mp_uint32	startPos;
+		mp_uint32	endPos;		// highest position played
+		mp_uint32	duration;	// milliseconds
+	};
+	
+	enum
+	{
+		NotPlayed = 0xFFFFFFFF
+	};
+
+	SongAnalysis();
+
+	// Follows speed changes, jumps, breaks, pattern loops and pattern delays
+	// the way PlayerSTD does, until the song ends or would repeat itself.
+	// Positions which haven't been reached start sub songs of their own.
+	void			analyze(const XModule& module);
+
+	// the first song is the one starting at position 0
+	mp_uint32		getDuration() const { return songs.empty() ? 0 : songs[0].duration; }
+	
+	mp_uint32		getNumSongs() const { return (mp_uint32)songs.size(); }
+	const TSong&	getSong(mp_uint32 index) const { return songs[index]; }
+	
+	// milliseconds into its song the row is played first, NotPlayed if it's never played
+	mp_uint32		getTime(mp_uint32 pos, mp_uint32 row) const;
+	
+	bool			isChannelUsed(mp_uint32 channel) const { return channel < 256 && (channelUsage[channel>>3] & (1 << (channel&7))); }
+	mp_uint32		getNumUsedChannels() const;
+
+	void			save(XMFileBase& f) const;
+	bool			load(XMFileBase& f);
+
+private:
+	std::vector<TSong>		songs;
+	// positionOffsets[pos] is the index of the first row of pos in rowTimes,
+	// there's one more offset than positions
+	std::vector<mp_uint32>	positionOffsets;
+	std::vector<mp_uint32>	rowTimes;
+	mp_ubyte				channelUsage[32];
+
+	void			playSong(const XModule& module, TSong& song, std::vector<mp_ubyte>& played);
+};
+
+class SongAnalysisCache
+{
+public:
+	// the cache is read from fileName right away
+					SongAnalysisCache(const SYSCHAR* fileName);
+					~SongAnalysisCache();
+
+	// hash of the whole contents of the file
+	static mp_uint64 hash(XMFileBase& f);
+
+	bool			lookup(mp_uint64 hash, SongAnalysis& analysis);
+	void			store(mp_uint64 hash, const SongAnalysis& analysis);
+	
+	// writes the cache back if anything has been stored
+	bool			save();
+
+private:
+	std::basic_string<SYSCHAR>	fileName;
+	
+	std::mutex		mutex;
+	std::map<mp_uint64, std::vector<mp_ubyte> > entries;
+	bool			changed;
+
+	void			load();
+};
+
+#endif
@@ -0,0 +1,409 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  WorkerPool.cpp
+ *  MilkyPlay
+ *
+ */
+
+#include "WorkerPool.h"
+#include "MilkyPlayCommon.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <vector>
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#define WORKERPOOL_PAUSE() _mm_pause()
+#else
+#define WORKERPOOL_PAUSE()
+#endif
+
+// Jobs are posted in a fixed number of slots so neither posting nor claiming 
+// needs a lock. The lower 32 bits of a slot's ticket are the next index 
+// to hand out, the upper bits count how often the slot has been posted.
+// A claim only succeeds if the ticket didn't change since job and count
+// were read, so nobody ever runs an index of a stale job.
+struct WorkerPool::Slot
+{
+	std::atomic<bool>		inUse;
+	std::atomic<mp_int64>	ticket;
+	std::atomic<Job*>		job;
+	std::atomic<mp_uint32>	count;
+	std::atomic<bool>		blocking;
+	std::atomic<mp_uint32>	done;			// number of finished indices
+	
+	Slot() :
+		inUse(false),
+		ticket(InvalidIndex),
+		job(0),
+		count(0),
+		blocking(false),
+		done(0)
+	{
+	}
+
+	enum
+	{
+		InvalidIndex = 0xFFFFFFFF
+	};
+};
+
+struct WorkerPool::Private
+{
+	enum
+	{
+		// nesting depth times concurrent callers, beyond that jobs run inline
+		NumSlots = 16,
+		// pauses before a waiting realtime caller starts to yield
+		SpinCount = 4096
+	};
+
+	Slot						slots[NumSlots];
+	
+	std::mutex					mutex;
+	std::condition_variable		workAvailable;
+	std::condition_variable		workDone;
+	std::vector<std::thread>	threads;
+	std::atomic<mp_uint32>		generation;		// bumped on every post
+	std::atomic<mp_uint32>		available;		// workers not running a job
+	std::atomic<bool>			shutdown;
+	
+	// scheduling of the first realtime caller, see capturePriority()
+	std::atomic<bool>			priorityCaptured;
+	std::atomic<mp_uint32>		prioritySerial;
+	int							policy;
+	int							priority;
+	
+	Private(mp_uint32 numThreads) :
+		generation(0),
+		available(numThreads),
+		shutdown(false),
+		priorityCaptured(false),
+		prioritySerial(0),
+		policy(0),
+		priority(0)
+	{
+	}
+};
+
+WorkerPool::WorkerPool(mp_uint32 numThreads/* = 0*/) :
+	p(NULL),
+	numThreads(numThreads)
+{
+	if (this->numThreads == 0)
+	{
+		mp_uint32 cores = getNumCores();
+		this->numThreads = cores > 1 ? cores - 1 : 0;
+	}
+
+	p = new Private(this->numThreads);
+
+	for (mp_uint32 i = 0; i < this->numThreads; i++)
+		p->threads.push_back(std::thread(&WorkerPool::workerLoop, this));
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(p->mutex);
+		p->shutdown = true;
+	}
+	p->workAvailable.notify_all();
+
+	for (size_t i = 0; i < p->threads.size(); i++)
+		p->threads[i].join();
+
+	delete p;
+}
+
+mp_uint32 WorkerPool::getNumCores()
+{
+	mp_uint32 cores = std::thread::hardware_concurrency();
+	return cores ? cores : 1;
+}
+
+WorkerPool::Slot* WorkerPool::acquireSlot()
+{
+	for (mp_uint32 i = 0; i < Private::NumSlots; i++)
+	{
+		bool expected = false;
+		if (p->slots[i].inUse.compare_exchange_strong(expected, true))
+			return &p->slots[i];
+	}
+	return NULL;
+}
+
+void WorkerPool::releaseSlot(Slot* slot)
+{
+	slot->inUse.store(false);
+}
+
+void WorkerPool::post(Slot* slot, Job& job, mp_uint32 count, bool blocking, bool realtime)
+{
+	// invalidate first, claims which have read the old job fail from now on
+	const mp_int64 serial = ((slot->ticket.load() >> 32) + 1) & 0x7FFFFFFF;
+	slot->ticket.store((serial << 32) | Slot::InvalidIndex);
+	
+	slot->job.store(&job);
+	slot->count.store(count);
+	slot->blocking.store(blocking);
+	slot->done.store(0);
+	
+	slot->ticket.store(serial << 32);
+
+	// Taking the lock makes sure no worker misses the wake up. The audio 
+	// thread doesn't wait for it, a worker missing this post only means 
+	// the caller does a bit more itself.
+	if (!realtime)
+	{
+		std::lock_guard<std::mutex> lock(p->mutex);
+		p->generation++;
+	}
+	else if (p->mutex.try_lock())
+	{
+		p->generation++;
+		p->mutex.unlock();
+	}
+	else
+	{
+		p->generation++;
+	}
+	p->workAvailable.notify_all();
+}
+
+bool WorkerPool::claim(Slot* slot, Job*& job, mp_uint32& index, mp_uint32& count, bool& blocking)
+{
+	mp_int64 ticket = slot->ticket.load();
+	for (;;)
+	{
+		const mp_uint32 next = (mp_uint32)ticket;
+		job = slot->job.load();
+		count = slot->count.load();
+		blocking = slot->blocking.load();
+		
+		// also true while the slot is being posted
+		if (next >= count)
+			return false;
+			
+		if (slot->ticket.compare_exchange_weak(ticket, ticket + 1))
+		{
+			index = next;
+			return true;
+		}
+	}
+}
+
+// The slot may be posted again as soon as the last index is done, 
+// so nothing in it must be touched after the increment.
+void WorkerPool::complete(Slot* slot, mp_uint32 count, bool blocking)
+{
+	if (slot->done.fetch_add(1) + 1 == count && blocking)
+	{
+		std::lock_guard<std::mutex> lock(p->mutex);
+		p->workDone.notify_all();
+	}
+}
+
+bool WorkerPool::helpOut()
+{
+	bool didSomething = false;
+	
+	for (mp_uint32 i = 0; i < Private::NumSlots; i++)
+	{
+		Slot* slot = &p->slots[i];
+		Job* job = 0;
+		mp_uint32 index = 0, count = 0;
+		bool blocking = false;
+		
+		while (claim(slot, job, index, count, blocking))
+		{
+			p->available--;
+			job->run(index);
+			p->available++;
+			complete(slot, count, blocking);
+			didSomething = true;
+		}
+	}
+	
+	return didSomething;
+}
+
+// The pool is created on the UI thread before there is any audio thread, 
+// so the workers take over the scheduling of whoever first mixes on them. 
+// Otherwise the audio thread would wait for threads which any other normal 
+// priority thread may preempt.
+void WorkerPool::capturePriority()
+{
+	if (p->priorityCaptured.exchange(true))
+		return;
+
+#if defined(WIN32) || defined(_WIN32_WCE)
+	p->priority = GetThreadPriority(GetCurrentThread());
+#else
+	sched_param param;
+	if (pthread_getschedparam(pthread_self(), &p->policy, &param) != 0)
+		return;
+	p->priority = param.sched_priority;
+#endif
+	
+	p->prioritySerial++;
+}
+
+void WorkerPool::adoptPriority(mp_uint32& serial)
+{
+	const mp_uint32 current = p->prioritySerial.load();
+	if (current == serial)
+		return;
+	serial = current;
+	
+#if defined(WIN32) || defined(_WIN32_WCE)
+	SetThreadPriority(GetCurrentThread(), p->priority);
+#else
+	sched_param param;
+	param.sched_priority = p->priority;
+	pthread_setschedparam(pthread_self(), p->policy, &param);
+#endif
+}
+
+void WorkerPool::workerLoop()
+{
+	mp_uint32 prioritySerial = 0;
+	
+	for (;;)
+	{
+		const mp_uint32 generation = p->generation.load();
+		
+		adoptPriority(prioritySerial);
+
+		while (helpOut())
+			;
+		
+		std::unique_lock<std::mutex> lock(p->mutex);
+		while (p->generation.load() == generation && !p->shutdown)
+			p->workAvailable.wait(lock);
+		
+		if (p->shutdown)
+			return;
+	}
+}
+
+void WorkerPool::run(Job& job, mp_uint32 count)
+{
+	if (count == 0)
+		return;
+
+	Slot* slot = numThreads && count > 1 ? acquireSlot() : NULL;
+	if (slot == NULL)
+	{
+		for (mp_uint32 i = 0; i < count; i++)
+			job.run(i);
+		return;
+	}
+
+	post(slot, job, count, true, false);
+
+	// help out until all indices are handed out
+	Job* own = 0;
+	mp_uint32 index = 0, ownCount = 0;
+	bool blocking = false;
+	while (claim(slot, own, index, ownCount, blocking))
+	{
+		own->run(index);
+		complete(slot, count, true);
+	}
+	
+	// wait for the ones still running on other threads
+	{
+		std::unique_lock<std::mutex> lock(p->mutex);
+		while (slot->done.load() != count)
+			p->workDone.wait(lock);
+	}
+	
+	releaseSlot(slot);
+}
+
+void WorkerPool::runRealtime(Job& job, mp_uint32 count)
+{
+	if (count == 0)
+		return;
+
+	if (numThreads)
+		capturePriority();
+
+	// every worker is busy, don't wait for one
+	Slot* slot = numThreads && count > 1 && p->available.load() ? acquireSlot() : NULL;
+	if (slot == NULL)
+	{
+		for (mp_uint32 i = 0; i < count; i++)
+			job.run(i);
+		return;
+	}
+
+	post(slot, job, count, false, true);
+
+	// workers which aren't awake yet simply find nothing left to do
+	Job* own = 0;
+	mp_uint32 index = 0, ownCount = 0;
+	bool blocking = false;
+	while (claim(slot, own, index, ownCount, blocking))
+	{
+		own->run(index);
+		complete(slot, count, false);
+	}
+	
+	// only indices some worker is running right now are left, 
+	// spin for them and give up the time slice once that takes longer
+	mp_uint32 spins = 0;
+	while (slot->done.load() != count)
+	{
+		if (spins < Private::SpinCount)
+		{
+			WORKERPOOL_PAUSE();
+			spins++;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+	
+	releaseSlot(slot);
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2009, The MilkyTracker Team.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ *   this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - Neither the name of the <ORGANIZATION> nor the names of its contributors
+ *   may be used to endorse or promote products derived from this software
+ *   without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  WorkerPool.h
+ *  MilkyPlay
+ *
+ *  A small pool of worker threads executing indexed jobs.
+ *  The calling thread always takes part in processing its own jobs,
+ *  so run() may be called from within a job (or from several threads
+ *  at once) without ever waiting for a free worker.
+ *
+ *  Indices are handed out through an atomic counter, the only thing
+ *  the caller ever waits for are indices another thread has already
+ *  started. runRealtime() does so by spinning and never sleeps, which 
+ *  makes it safe to use from the audio callback.
+ */
+
+#ifndef __WORKERPOOL_H__
+#define __WORKERPOOL_H__
+
+#include "MilkyPlayTypes.h"
+
+class WorkerPool
+{
+public:
+	class Job
+	{
+	public:
+		virtual ~Job()
+		{
+		}
+		
+		// called once for every index in [0, count) passed to run()
+		virtual void run(mp_uint32 index) = 0;
+	};
+
+	// numThreads = 0 means one thread less than there are cores, 
+	// the calling thread makes up for the missing one
+					WorkerPool(mp_uint32 numThreads = 0);
+					~WorkerPool();
+
+	// number of worker threads (without the calling thread)
+	mp_uint32		getNumThreads() const { return numThreads; }
+	
+	// number of jobs which may run at the same time
+	mp_uint32		getConcurrency() const { return numThreads + 1; }
+
+	// executes job.run(0..count-1) and returns when all of them are done,
+	// sleeps while waiting for the other threads
+	void			run(Job& job, mp_uint32 count);
+
+	// same for the audio thread: if no worker is ready the jobs are run 
+	// right here, otherwise the caller spins until the workers are done.
+	// The first call makes the workers adopt the caller's priority
+	void			runRealtime(Job& job, mp_uint32 count);
+
+	static mp_uint32 getNumCores();
+
+private:
+	struct Slot;
+	struct Private;
+	
+	Private*		p;
+	mp_uint32		numThreads;
+
+	Slot*			acquireSlot();
+	void			releaseSlot(Slot* slot);
+	void			post(Slot* slot, Job& job, mp_uint32 count, bool blocking, bool realtime);
+	bool			claim(Slot* slot, Job*& job, mp_uint32& index, mp_uint32& count, bool& blocking);
+	void			complete(Slot* slot, mp_uint32 count, bool blocking);
+	bool			helpOut();
+	void			adoptPriority(mp_uint32& serial);
+	void			capturePriority();
+	void			workerLoop();
+	
+	// not copyable
+					WorkerPool(const WorkerPool&);
+	WorkerPool&		operator=(const WorkerPool&);
+};
+
+#endif
@@ -34,7 +34,10 @@
 #include "XMFile.h"
 
 XMFileBase::XMFileBase() :
-	baseOffset(0)
+	baseOffset(0),
+	viewData(NULL),
+	viewSize(0),
+	viewPos(0)
 {
 }
 
@@ -60,7 +63,7 @@ mp_uint32 XMFileBase::posWithBaseOffset()
 //////////////////////////////////////////////////////////////////////////
 // Reading/writing of little endian stuff								//
 //////////////////////////////////////////////////////////////////////////
-mp_ubyte XMFileBase::readByte()
+mp_ubyte XMFileBase::readByteFromFile()
 {
 	mp_ubyte c;
 	mp_sint32 bytesRead = read(&c,1,1);
@@ -72,7 +75,7 @@ mp_ubyte XMFileBase::readByte()
 	return (mp_ubyte)c;
 }
 
-mp_uword XMFileBase::readWord()
+mp_uword XMFileBase::readWordFromFile()
 {
 	mp_ubyte c[2];
 	mp_sint32 bytesRead = read(&c,1,2);
@@ -84,7 +87,7 @@ mp_uword XMFileBase::readWord()
 	return (mp_uword)((mp_uword)c[0]+((mp_uword)c[1]<<8));
 }
 
-mp_dword XMFileBase::readDword()
+mp_dword XMFileBase::readDwordFromFile()
 {
 	mp_ubyte c[4];
 	mp_sint32 bytesRead = read(&c,1,4);
@@ -160,8 +163,128 @@ void XMFileBase::writeString(const char* string)
 	write(string, 1, static_cast<mp_uint32> (strlen(string)));
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Files in memory														//
+//////////////////////////////////////////////////////////////////////////
+static char* newFileNameASCII(const SYSCHAR* fileName);
+
+static const SYSCHAR emptyFileName[1] = { 0 };
+
+XMMemoryFile::XMMemoryFile(const void* buffer, mp_uint32 size, const SYSCHAR* fileName/* = NULL*/) :
+	XMFileBase(),
+	fileName(fileName ? fileName : emptyFileName),
+	fileNameASCII(NULL)
+{
+	setBuffer(buffer, size);
+}
+
+XMMemoryFile::~XMMemoryFile()
+{
+	delete[] fileNameASCII;
+}
+
+void XMMemoryFile::setBuffer(const void* buffer, mp_uint32 size)
+{
+	viewData = (const mp_ubyte*)buffer;
+	viewSize = buffer ? size : 0;
+	viewPos = 0;
+}
+
+mp_sint32 XMMemoryFile::read(void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (size <= 0 || count <= 0 || viewSize - viewPos == 0)
+		return 0;
+	
+	// whole elements only, like fread
+	mp_uint32 numBytes = (mp_uint32)size*(mp_uint32)count;
+	if (numBytes > viewSize - viewPos)
+		numBytes = ((viewSize - viewPos) / size) * size;
+
+	memcpy(ptr, viewData + viewPos, numBytes);
+	viewPos += numBytes;
+	
+	return (mp_sint32)numBytes;
+}
+
+void XMMemoryFile::seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType/* = SeekOffsetTypeStart*/)
+{
+	if (seekOffsetType == SeekOffsetTypeCurrent)
+		pos += viewPos;
+	else if (seekOffsetType == SeekOffsetTypeEnd)
+		pos += viewSize;
+
+	// never past the end, the bounds checks rely on viewPos <= viewSize
+	viewPos = pos > viewSize ? viewSize : pos;
+}
+
+const char* XMMemoryFile::getFileNameASCII()
+{
+	delete[] fileNameASCII;
+	fileNameASCII = newFileNameASCII(fileName);
+	return fileNameASCII;
+}
+
 #define BUFFERSIZE 16384
 
+XMBufferFile::XMBufferFile(const SYSCHAR* fileName/* = NULL*/) :
+	XMMemoryFile(NULL, 0, fileName),
+	buffer(NULL),
+	capacity(0)
+{
+}
+
+XMBufferFile::~XMBufferFile()
+{
+	delete[] buffer;
+}
+
+mp_sint32 XMBufferFile::write(const void* ptr, mp_sint32 size, mp_sint32 count)
+{
+	if (size <= 0 || count <= 0)
+		return 0;
+
+	mp_uint32 numBytes = (mp_uint32)size*(mp_uint32)count;
+	mp_uint32 end = viewPos + numBytes;
+	
+	if (end < viewPos)
+		return -1;
+	
+	if (end > capacity)
+	{
+		// double the buffer so writing in small pieces stays linear
+		mp_uint32 newCapacity = capacity ? capacity : BUFFERSIZE;
+		while (newCapacity < end && newCapacity < 0x80000000)
+			newCapacity <<= 1;
+		if (newCapacity < end)
+			newCapacity = end;
+			
+		mp_ubyte* newBuffer = new mp_ubyte[newCapacity];
+		if (viewSize)
+			memcpy(newBuffer, buffer, viewSize);
+		delete[] buffer;
+		
+		buffer = newBuffer;
+		capacity = newCapacity;
+		viewData = buffer;
+	}
+	
+	memcpy(buffer + viewPos, ptr, numBytes);
+	viewPos = end;
+	
+	if (end > viewSize)
+		viewSize = end;
+	
+	return (mp_sint32)numBytes;
+}
+
+void XMBufferFile::truncate(mp_uint32 size)
+{
+	if (size < viewSize)
+		viewSize = size;
+	if (viewPos > viewSize)
+		viewPos = viewSize;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // WIN32 implentation													//
 //////////////////////////////////////////////////////////////////////////
@@ -333,7 +456,7 @@ bool XMFile::exists(const SYSCHAR* file)
 	return res;
 }
 
-const char* XMFile::getFileNameASCII()
+static char* newFileNameASCII(const SYSCHAR* fileName)
 {
 	const SYSCHAR* ptr = fileName+_tcslen(fileName);
 	
@@ -342,7 +465,7 @@ const char* XMFile::getFileNameASCII()
 		
 	if (*ptr == '\\') ptr++;
 	
-	fileNameASCII = new char[_tcslen(ptr)+1];
+	char* fileNameASCII = new char[_tcslen(ptr)+1];
 	
 	for (mp_uint32 i = 0; i <= _tcslen(ptr); i++)
 		fileNameASCII[i] = (char)ptr[i];
@@ -352,12 +475,68 @@ const char* XMFile::getFileNameASCII()
 	return fileNameASCII;
 }
 
+const char* XMFile::getFileNameASCII()
+{
+	fileNameASCII = newFileNameASCII(fileName);
+	return fileNameASCII;
+}
+
+XMMappedFile::XMMappedFile(const SYSCHAR* fileName) :
+	XMMemoryFile(NULL, 0, fileName),
+	mappingHandle(NULL)
+{
+	HANDLE handle = CreateFile(fileName,
+							   GENERIC_READ,
+							   FILE_SHARE_READ,
+							   NULL,
+							   OPEN_EXISTING, 
+							   FILE_ATTRIBUTE_NORMAL, 
+							   NULL);
+
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+	
+	DWORD sizeHigh = 0;
+	DWORD size = GetFileSize(handle, &sizeHigh);
+	
+	// the view stays valid after the file has been closed
+	if (size != 0 && size != INVALID_FILE_SIZE && sizeHigh == 0)
+		mappingHandle = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	
+	CloseHandle(handle);
+	
+	if (mappingHandle == NULL)
+		return;
+	
+	const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (view == NULL)
+	{
+		CloseHandle(mappingHandle);
+		mappingHandle = NULL;
+		return;
+	}
+	
+	setBuffer(view, size);
+}
+
+XMMappedFile::~XMMappedFile()
+{
+	if (getBuffer())
+		UnmapViewOfFile(getBuffer());
+	
+	if (mappingHandle)
+		CloseHandle(mappingHandle);
+}
+
 //////////////////////////////////////////////////////////////////////////
 // C compatible implentation											//
 //////////////////////////////////////////////////////////////////////////
 #else
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 XMFile::XMFile(const SYSCHAR*	fileName, bool writeAccess /* = false*/) :
 	XMFileBase(),
@@ -497,7 +676,7 @@ bool XMFile::remove(const SYSCHAR* file)
 	return unlink(file) == 0;
 }
 
-const char* XMFile::getFileNameASCII()
+static char* newFileNameASCII(const SYSCHAR* fileName)
 {
 	const SYSCHAR* ptr = fileName+strlen(fileName);
 	
@@ -506,11 +685,43 @@ const char* XMFile::getFileNameASCII()
 		
 	if (*ptr == '/') ptr++;
 	
-	fileNameASCII = new char[strlen(ptr)+1];
+	char* fileNameASCII = new char[strlen(ptr)+1];
 	
 	strcpy(fileNameASCII, ptr);
 	
 	return fileNameASCII;
 }
 
+const char* XMFile::getFileNameASCII()
+{
+	fileNameASCII = newFileNameASCII(fileName);
+	return fileNameASCII;
+}
+
+XMMappedFile::XMMappedFile(const SYSCHAR* fileName) :
+	XMMemoryFile(NULL, 0, fileName)
+{
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat st;
+	void* view = MAP_FAILED;
+	
+	// the mapping stays valid after the file has been closed
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 && st.st_size <= 0xFFFFFFFF)
+		view = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	
+	close(fd);
+
+	if (view != MAP_FAILED)
+		setBuffer(view, (mp_uint32)st.st_size);
+}
+
+XMMappedFile::~XMMappedFile()
+{
+	if (getBuffer())
+		munmap((void*)getBuffer(), size());
+}
+
 #endif
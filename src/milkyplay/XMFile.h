@@ -43,6 +43,17 @@ class XMFileBase
 {
 private:
 	mp_dword				baseOffset;
+
+	mp_ubyte				readByteFromFile();
+	mp_uword				readWordFromFile();
+	mp_dword				readDwordFromFile();
+
+protected:
+	// files which are held in memory as a whole point these at their 
+	// contents, the small reads below then don't go through read()
+	const mp_ubyte*			viewData;
+	mp_uint32				viewSize;
+	mp_uint32				viewPos;
 	
 public:
 							XMFileBase();
@@ -70,9 +81,44 @@ public:
 	virtual	bool			isOpen() = 0;
 	virtual	bool			isOpenForWriting()  = 0;
 
-	mp_ubyte				readByte();
-	mp_uword				readWord();
-	mp_dword				readDword();
+	// the whole contents of files held in memory, NULL for all others
+	const mp_ubyte*			getBuffer() const { return viewData; }
+
+	mp_ubyte readByte()
+	{
+		if (viewSize - viewPos >= 1)
+			return viewData[viewPos++];
+		
+		return readByteFromFile();
+	}
+	
+	mp_uword readWord()
+	{
+		if (viewSize - viewPos >= 2)
+		{
+			const mp_ubyte* c = viewData + viewPos;
+			viewPos+=2;
+			return (mp_uword)((mp_uword)c[0]+((mp_uword)c[1]<<8));
+		}
+		
+		return readWordFromFile();
+	}
+	
+	mp_dword readDword()
+	{
+		if (viewSize - viewPos >= 4)
+		{
+			const mp_ubyte* c = viewData + viewPos;
+			viewPos+=4;
+			return (mp_dword)((mp_uint32)c[0]+
+							  ((mp_uint32)c[1]<<8)+
+							  ((mp_uint32)c[2]<<16)+
+							  ((mp_uint32)c[3]<<24));
+		}
+		
+		return readDwordFromFile();
+	}
+	
 	void					readWords(mp_uword* buffer,mp_sint32 count);
 	void					readDwords(mp_dword* buffer,mp_sint32 count);
 
@@ -130,4 +176,69 @@ public:
 	static bool				remove(const SYSCHAR* file);
 };
 
+// Read only file over a buffer owned by the caller, 
+// the buffer has to stay around as long as the file
+class XMMemoryFile : public XMFileBase
+{
+private:
+	const SYSCHAR*	fileName;
+	char*			fileNameASCII;
+	
+public:
+							XMMemoryFile(const void* buffer, mp_uint32 size, const SYSCHAR* fileName = NULL);
+	virtual					~XMMemoryFile();
+	
+	virtual mp_sint32		read(void* ptr,mp_sint32 size,mp_sint32 count);
+	virtual mp_sint32		write(const void* ptr,mp_sint32 size,mp_sint32 count) { return -1; }
+	
+	virtual void			seek(mp_uint32 pos, SeekOffsetTypes seekOffsetType = SeekOffsetTypeStart);
+	virtual mp_uint32		pos() { return viewPos; }
+	virtual mp_uint32		size() { return viewSize; }
+	
+	virtual const SYSCHAR*  getFileName() { return fileName; }
+	
+	virtual const char*		getFileNameASCII();
+	
+	virtual bool			isOpen() { return viewData != NULL; }
+	virtual bool			isOpenForWriting() { return false; }
+	
+protected:
+	void					setBuffer(const void* buffer, mp_uint32 size);
+};
+
+// Read/write file held in a buffer owned by the file, the buffer 
+// grows as it's written (e.g. decompressed archives, converted modules)
+class XMBufferFile : public XMMemoryFile
+{
+private:
+	mp_ubyte*				buffer;
+	mp_uint32				capacity;
+	
+public:
+							XMBufferFile(const SYSCHAR* fileName = NULL);
+	virtual					~XMBufferFile();
+	
+	virtual mp_sint32		write(const void* ptr,mp_sint32 size,mp_sint32 count);
+	
+	// drops everything from size on, the position stays inside
+	void					truncate(mp_uint32 size);
+	
+	virtual bool			isOpen() { return true; }
+	virtual bool			isOpenForWriting() { return true; }
+};
+
+// Read only file mapped into memory, isOpen() fails if the
+// file can't be mapped (e.g. it's empty), use XMFile then
+class XMMappedFile : public XMMemoryFile
+{
+private:
+#ifdef WIN32
+	HANDLE					mappingHandle;
+#endif
+
+public:
+							XMMappedFile(const SYSCHAR* fileName);
+	virtual					~XMMappedFile();
+};
+
 #endif
@@ -35,6 +35,8 @@
  */
 #include "XModule.h"
 #include "Loaders.h"
+#include "WorkerPool.h"
+#include <mutex>
 
 #undef VERBOSE
 
@@ -42,6 +44,125 @@
 	#include <stdio.h>
 #endif
 
+// Every block of padded sample memory starts with a small header saying
+// where it came from. It lies in front of the padding, so copying padded 
+// memory around (undo, swapping samples) leaves it alone.
+// Blocks of up to 4k come from 64k slabs and are recycled through one
+// free list per power of two size class, the slabs are kept until exit.
+namespace
+{
+	enum
+	{
+		BlockHeaderSize = 16,
+		MinBlockShift = 6,
+		NumSizeClasses = 7,
+		SlabSize = 65536,
+		HeapBlock = 0xFF
+	};
+
+	struct SampleSlabs
+	{
+		std::mutex	mutex;
+		mp_ubyte*	freeBlocks[NumSizeClasses];
+		mp_ubyte*	slab;
+		mp_uint32	slabUsed;
+		
+		SampleSlabs() :
+			slab(NULL),
+			slabUsed(SlabSize)
+		{
+			memset(freeBlocks, 0, sizeof(freeBlocks));
+		}
+
+		mp_ubyte* alloc(mp_uint32 sizeClass)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			mp_ubyte* block = freeBlocks[sizeClass];
+			if (block)
+			{
+				freeBlocks[sizeClass] = *(mp_ubyte**)block;
+				return block;
+			}
+			
+			const mp_uint32 blockSize = 1 << (sizeClass + MinBlockShift);
+			if (slabUsed + blockSize > SlabSize)
+			{
+				slab = new mp_ubyte[SlabSize];
+				slabUsed = 0;
+			}
+			
+			block = slab + slabUsed;
+			slabUsed += blockSize;
+			return block;
+		}
+		
+		void free(mp_ubyte* block, mp_uint32 sizeClass)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			*(mp_ubyte**)block = freeBlocks[sizeClass];
+			freeBlocks[sizeClass] = block;
+		}
+	};
+	
+	SampleSlabs& getSampleSlabs()
+	{
+		static SampleSlabs slabs;
+		return slabs;
+	}
+}
+
+mp_ubyte* TXMSample::allocPaddedMem(mp_uint32 size)
+{
+	const mp_uint32 blockSize = BlockHeaderSize + getPaddedSize(size);
+	
+	mp_uint32 sizeClass = 0;
+	while (sizeClass < NumSizeClasses && (1U << (sizeClass + MinBlockShift)) < blockSize)
+		sizeClass++;
+	
+	mp_ubyte* block;
+	if (sizeClass < NumSizeClasses)
+	{
+		block = getSampleSlabs().alloc(sizeClass);
+	}
+	else
+	{
+		block = new mp_ubyte[blockSize];
+		sizeClass = HeapBlock;
+	}
+	
+	if (block == NULL)
+		return NULL;
+		
+	block[0] = (mp_ubyte)sizeClass;
+	
+	mp_ubyte* result = block + BlockHeaderSize;
+
+	// clear out padding space
+	memset(result, 0, TXMSample::LeadingPadding);
+	memset(result+size+TXMSample::LeadingPadding, 0, TXMSample::TrailingPadding);
+	
+	TLoopDoubleBuffProps* loopBufferProps = (TLoopDoubleBuffProps*)result;
+	loopBufferProps->samplesize = size;
+	
+	return result + TXMSample::LeadingPadding;
+}
+
+void TXMSample::freePaddedMem(mp_ubyte* mem)
+{
+	// behave safely on NULL
+	if (mem == NULL)
+		return;
+	
+	mp_ubyte* block = getPadStartAddr(mem) - BlockHeaderSize;
+	
+	if (block[0] == HeapBlock)
+		delete[] block;
+	else
+		getSampleSlabs().free(block, block[0]);
+}
+
 // heavy processing removes some of the nasty clicks found
 // in 669 and PLM songs (found in 8 bit samples only)
 void TXMSample::smoothLooping()
@@ -1031,6 +1152,146 @@ public:
 	}
 };
 
+void TXMPattern::buildIndex() const
+{
+	memset(rowIndex, 0, sizeof(rowIndex));
+	memset(channelIndex, 0, sizeof(channelIndex));
+	
+	if (patternData)
+	{
+		const mp_sint32 slotSize = effnum*2+2;
+		const mp_ubyte* slot = patternData;
+		
+		for (mp_sint32 r = 0; r < rows; r++)
+		{
+			for (mp_sint32 c = 0; c < channum; c++, slot+=slotSize)
+			{
+				mp_sint32 i = 0;
+				while (i < slotSize && !slot[i])
+					i++;
+					
+				if (i == slotSize)
+					continue;
+					
+				if (r < 256)
+					rowIndex[r>>5] |= 1U << (r&31);
+				channelIndex[c>>5] |= 1U << (c&31);
+			}
+		}
+	}
+	
+	indexValid = true;
+}
+
+bool TXMPattern::isEmpty() const
+{
+	if (!indexValid)
+		buildIndex();
+	
+	for (mp_uint32 i = 0; i < sizeof(channelIndex)/sizeof(channelIndex[0]); i++)
+		if (channelIndex[i])
+			return false;
+			
+	return true;
+}
+
+bool TXMPattern::isRowEmpty(mp_sint32 row) const
+{
+	// only the first 256 rows are indexed
+	if (row >= 256)
+		return getNextChannel(row, 0) >= channum;
+		
+	if (!indexValid)
+		buildIndex();
+
+	return !(rowIndex[row>>5] & (1U << (row&31)));
+}
+
+bool TXMPattern::isChannelEmpty(mp_sint32 channel) const
+{
+	if (!indexValid)
+		buildIndex();
+
+	return !(channelIndex[channel>>5] & (1U << (channel&31)));
+}
+
+bool TXMPattern::isCellEmpty(mp_sint32 row, mp_sint32 channel) const
+{
+	const mp_sint32 slotSize = effnum*2+2;
+	const mp_ubyte* slot = patternData + (row*channum + channel)*slotSize;
+	
+	for (mp_sint32 i = 0; i < slotSize; i++)
+		if (slot[i])
+			return false;
+			
+	return true;
+}
+
+mp_sint32 TXMPattern::getNextRow(mp_sint32 row) const
+{
+	if (!indexValid)
+		buildIndex();
+	
+	while (row < rows && row < 256)
+	{
+		mp_uint32 bits = rowIndex[row>>5] >> (row&31);
+		if (bits)
+		{
+			while (!(bits & 1))
+			{
+				bits>>=1;
+				row++;
+			}
+			return row < rows ? row : rows;
+		}
+		
+		// nothing left in this word
+		row = (row | 31) + 1;
+	}
+	
+	while (row < rows && isRowEmpty(row))
+		row++;
+	
+	return row < rows ? row : rows;
+}
+
+mp_sint32 TXMPattern::getNextChannel(mp_sint32 row, mp_sint32 channel) const
+{
+	if (patternData == NULL)
+		return channum;
+	
+	for (; channel < channum; channel++)
+	{
+		if (!isChannelEmpty(channel) && !isCellEmpty(row, channel))
+			return channel;
+	}
+	
+	return channum;
+}
+
+bool TXMPattern::getNextCell(mp_sint32& row, mp_sint32& channel) const
+{
+	mp_sint32 nextRow;
+	while ((nextRow = getNextRow(row)) < rows)
+	{
+		if (nextRow != row)
+		{
+			row = nextRow;
+			channel = 0;
+		}
+	
+		channel = getNextChannel(row, channel);
+		if (channel < channum)
+			return true;
+			
+		row++;
+		channel = 0;
+	}
+	
+	row = rows;
+	return false;
+}
+
 mp_sint32 TXMPattern::compress(mp_ubyte* dest) const
 {
 	mp_sint32 patternSize = rows*channum*(2+effnum*2);
@@ -1132,6 +1393,8 @@ mp_sint32 TXMPattern::decompress(mp_ubyte* src, mp_sint32 len)
 
 	mp_ubyte* srcPtr = src;
 	mp_ubyte* dstPtr = patternData;
+	
+	setDirty();
 
 	mp_sint32 i = 0;
 	mp_sint32 j = 0;
@@ -1186,6 +1449,8 @@ const TXMPattern& TXMPattern::operator=(const TXMPattern& src)
 		patdata = src.patdata;
 		ptype = src.ptype;
 		rows = src.rows;
+		
+		setDirty();
 	}
 	
 	return *this;
@@ -1495,13 +1760,17 @@ bool XModule::loadSample(XMFileBase& f,void* buffer,mp_uint32 size,mp_uint32 len
 				srcPtr[i] = b1+=srcPtr[i];
 		}
 
+		// little endian data is already in place on little endian machines
+		const mp_uword endianProbe = 1;
+		const bool littleEndianHost = *(const mp_ubyte*)&endianProbe == 1;
+
 		mp_uint32 i;
 		if (flags & ST_BIGENDIAN)
 		{
 			for (i = 0; i < length; i++)
 				dstPtr[i] = BigEndian::GET_WORD(srcPtr+i*2);
 		}
-		else
+		else if (!littleEndianHost)
 		{
 			for (i = 0; i < length; i++)
 				dstPtr[i] = LittleEndian::GET_WORD(srcPtr+i*2);
@@ -1605,6 +1874,66 @@ mp_sint32 XModule::loadModuleSamples(XMFileBase& f, mp_sint32 flags8/* = ST_DEFA
 	return MP_OK;
 }
 
+class SampleLocationJob : public WorkerPool::Job
+{
+private:
+	XMFileBase& f;
+	const XModule::TSampleLocation* samples;
+	bool* results;
+
+public:
+	SampleLocationJob(XMFileBase& f, const XModule::TSampleLocation* samples, bool* results) :
+		f(f),
+		samples(samples),
+		results(results)
+	{
+	}
+
+	virtual void run(mp_uint32 index)
+	{
+		const XModule::TSampleLocation& sample = samples[index];
+
+		// every job reads through a view of its own
+		XMMemoryFile file(f.getBuffer(), f.size());
+		file.setBaseOffset(f.getBaseOffset());
+		file.seekWithBaseOffset(sample.offset);
+		
+		results[index] = XModule::loadSample(file, sample.buffer, sample.size, sample.length, sample.flags);
+	}
+};
+
+bool XModule::loadSamples(XMFileBase& f, const TSampleLocation* samples, mp_uint32 count)
+{
+	mp_uint32 i;
+	
+	const mp_uint32 numCores = WorkerPool::getNumCores();
+	
+	if (f.getBuffer() == NULL || count < 2 || numCores < 2)
+	{
+		for (i = 0; i < count; i++)
+		{
+			f.seekWithBaseOffset(samples[i].offset);
+			if (!loadSample(f, samples[i].buffer, samples[i].size, samples[i].length, samples[i].flags))
+				return false;
+		}
+		return true;
+	}
+	
+	bool* results = new bool[count];
+	
+	WorkerPool workerPool((count < numCores ? count : numCores) - 1);
+	SampleLocationJob job(f, samples, results);
+	workerPool.run(job, count);
+	
+	bool res = true;
+	for (i = 0; i < count; i++)
+		res &= results[i];
+	
+	delete[] results;
+	
+	return res;
+}
+
 ////////////////////////////////////////////
 // Before using the sample postprocessing //
 // please make sure that the memory       //
@@ -1648,39 +1977,104 @@ void XModule::setDefaultPanning()
 	}
 }
 
-mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+// Fibonacci hashing, the upper half of the product depends on all address bits
+static inline mp_uint32 hashSamplePtr(const mp_ubyte* mem)
+{
+	return (mp_uint32)(((unsigned long long)(size_t)mem * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+// returns the hash entry of mem or the empty one where it would go
+mp_uint32 XModule::findSampleHash(const mp_ubyte* mem) const
+{
+	mp_uint32 index = hashSamplePtr(mem) & (SampleHashSize-1);
+	while (sampleHash[index] && samplePool[sampleHash[index]-1] != mem)
+		index = (index+1) & (SampleHashSize-1);
+	
+	return index;
+}
+
+void XModule::addSamplePtr(mp_ubyte* mem)
+{
+	const mp_uint32 slot = numFreeSampleSlots ? freeSampleSlots[--numFreeSampleSlots] : samplePointerIndex++;
+	
+	samplePool[slot] = mem;
+	sampleHash[findSampleHash(mem)] = slot+1;
+}
+
+mp_ubyte* XModule::removeSampleHash(mp_uint32 hashIndex)
 {
-	// sample is always padded at start and end with 16 bytes
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	const mp_uint32 slot = sampleHash[hashIndex]-1;
+	mp_ubyte* mem = samplePool[slot];
+	
+	samplePool[slot] = NULL;
+	freeSampleSlots[numFreeSampleSlots++] = slot;
+
+	// close the gap: move back every following entry of the probe 
+	// sequence whose home position isn't between the gap and itself
+	mp_uint32 gap = hashIndex;
+	mp_uint32 index = (hashIndex+1) & (SampleHashSize-1);
+	while (sampleHash[index])
 	{
-		if (samplePool[i] == NULL)
+		const mp_uint32 home = hashSamplePtr(samplePool[sampleHash[index]-1]) & (SampleHashSize-1);
+		if (((index - home) & (SampleHashSize-1)) >= ((index - gap) & (SampleHashSize-1)))
 		{
-			samplePool[i] = TXMSample::allocPaddedMem(size);
-			return samplePool[i];
+			sampleHash[gap] = sampleHash[index];
+			gap = index;
 		}
+		index = (index+1) & (SampleHashSize-1);
 	}
-
-	samplePool[samplePointerIndex] = TXMSample::allocPaddedMem(size);
-	return samplePool[samplePointerIndex++];
+	sampleHash[gap] = 0;
+	
+	return mem;
 }
 
-void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
+void XModule::freeSamplePool()
 {
-	bool found = false;
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
+	if (samplePointerIndex == 0)
+		return;
+		
+	for (mp_uint32 i = 0; i < samplePointerIndex; i++)
 	{
-		if (samplePool[i] == mem)
+		if (samplePool[i]) 
 		{
-			found = true;
 			TXMSample::freePaddedMem(samplePool[i]);
 			samplePool[i] = NULL;
-			if (i == (signed)samplePointerIndex - 1)
-			{
-				samplePointerIndex--;
-				break;
-			}
 		}
 	}
+
+	memset(sampleHash, 0, sizeof(sampleHash));
+	samplePointerIndex = 0;
+	numFreeSampleSlots = 0;
+}
+
+mp_ubyte* XModule::allocSampleMem(mp_uint32 size)
+{
+	if (numFreeSampleSlots == 0 && samplePointerIndex >= MP_MAXSAMPLES)
+		return NULL;
+
+	// every loader allocates a sample before loading it and
+	// gives up when it can't, that's where loading is cancelled
+	if (loadingObserver && !loadingObserver->continueLoading())
+	{
+		loadingCancelled = true;
+		return NULL;
+	}
+
+	// sample is always padded at start and end
+	mp_ubyte* mem = TXMSample::allocPaddedMem(size);
+	if (mem)
+		addSamplePtr(mem);
+
+	return mem;
+}
+
+void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
+{
+	const mp_uint32 hashIndex = findSampleHash(mem);
+	const bool found = sampleHash[hashIndex] != 0;
+	
+	if (found)
+		TXMSample::freePaddedMem(removeSampleHash(hashIndex));
 	
 	if (assertCheck)
 	{
@@ -1691,26 +2085,18 @@ void XModule::freeSampleMem(mp_ubyte* mem, bool assertCheck/* = true*/)
 #ifdef MILKYTRACKER
 void XModule::insertSamplePtr(mp_ubyte* ptr)
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == NULL)
-		{
-			samplePool[i] = ptr;
-			return;
-		}
-	}
+	if (ptr == NULL || 
+		sampleHash[findSampleHash(ptr)] ||
+		(numFreeSampleSlots == 0 && samplePointerIndex >= MP_MAXSAMPLES))
+		return;
 
-	samplePool[samplePointerIndex++] = ptr;
+	addSamplePtr(ptr);
 }
 void XModule::removeSamplePtr(mp_ubyte* ptr)
 {
-	for (mp_sint32 i = 0; i < (signed)samplePointerIndex; i++)
-	{
-		if (samplePool[i] == ptr)
-		{
-			samplePool[i] = NULL;
-		}
-	}
+	const mp_uint32 hashIndex = findSampleHash(ptr);
+	if (sampleHash[hashIndex])
+		removeSampleHash(hashIndex);
 }
 #endif
 
@@ -1838,15 +2224,7 @@ bool XModule::cleanUp()
 	}
 
 	// release sample-memory
-	for (i = 0; i < samplePointerIndex; i++)
-	{
-		if (samplePool[i]) 
-		{
-			TXMSample::freePaddedMem(samplePool[i]);
-			samplePool[i] = NULL;
-		}
-	}
-	samplePointerIndex = 0;
+	freeSamplePool();
 	
 	memset(&header,0,sizeof(TXMHeader));
 	
@@ -1880,10 +2258,15 @@ XModule::XModule()
 	// no module loaded (empty song)
 	moduleLoaded = false;
 
+	loadingObserver = NULL;
+	loadingCancelled = false;
+
 	// initialise all sample pointers to NULL
 	memset(samplePool,0,sizeof(samplePool));
+	memset(sampleHash,0,sizeof(sampleHash));
 	// reset current sample index
 	samplePointerIndex = 0;
+	numFreeSampleSlots = 0;
 
 	memset(&header,0,sizeof(TXMHeader));
 
@@ -1950,6 +2333,11 @@ const char* XModule::identifyModule(const mp_ubyte* buffer)
 
 mp_sint32 XModule::loadModule(const SYSCHAR* fileName, bool scanForSubSongs/* = false*/)
 {
+	// the loaders read lots of small values, mapped they're just memory reads
+	XMMappedFile mappedFile(fileName);
+	if (mappedFile.isOpen())
+		return loadModule(mappedFile, scanForSubSongs);
+
 	XMFile f(fileName);
 	return f.isOpen() ? loadModule(f, scanForSubSongs) : -8; 
 }
@@ -1962,6 +2350,8 @@ mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
 	f.setBaseOffset(f.pos());
 	f.read(buffer, 1, sizeof(buffer));
 
+	loadingCancelled = false;
+
 	// browse through all available loaders and find suitable
 	LoaderManager loaderManager;
 	TLoaderInfo* loaderInfo;
@@ -1974,6 +2364,12 @@ mp_sint32 XModule::loadModule(XMFileBase& f, bool scanForSubSongs/* = false*/)
 			// try to load module
 			f.seekWithBaseOffset(0);
 			mp_sint32 err = loaderInfo->loader->load(f, this);
+			if (loadingCancelled)
+			{
+				cleanUp();
+				return MP_LOADING_CANCELLED;
+			}
+			
 			if (err == MP_OK)
 			{
 				moduleLoaded = true;
@@ -2307,7 +2703,8 @@ void XModule::buildSubSongTable()
 					
 					pbreak = pbreakpos = pjump = pjumppos = pjumprow = 0;
 					
-					for (mp_sint32 c = 0; c < phead[ord].channum; c++)
+					// only cells with something in them can have effects
+					for (mp_sint32 c = phead[ord].getNextChannel(r, 0); c < phead[ord].channum; c = phead[ord].getNextChannel(r, c+1))
 					{
 						
 						mp_sint32 slotSize = 2 + 2*phead[ord].effnum;
@@ -2671,16 +3068,7 @@ void XModule::createEmptySong(bool clearPatterns/* = true*/, bool clearInstrumen
 		}
 		
 		// release sample-memory
-		for (i = 0; i < samplePointerIndex; i++)
-		{
-			if (samplePool[i]) 
-			{
-				TXMSample::freePaddedMem(samplePool[i]);
-				samplePool[i] = NULL;
-			}
-		}
-
-		samplePointerIndex = 0;
+		freeSamplePool();
 		
 		if (instr)
 			memset(instr,0,sizeof(TXMInstrument)*256);
@@ -2802,6 +3190,8 @@ void XModule::removeOrderSkips()
 					}
 				}
 			}
+			
+			phead[i].setDirty();
 		}
 	}
 	
@@ -189,31 +189,10 @@ public:
 		return mem-TXMSample::LeadingPadding;
 	}
 
-	static mp_ubyte* allocPaddedMem(mp_uint32 size)
-	{
-		mp_ubyte* result = new mp_ubyte[getPaddedSize(size)];
-		
-		if (result == NULL)
-			return NULL;
-		
-		// clear out padding space
-		memset(result, 0, TXMSample::LeadingPadding);
-		memset(result+size+TXMSample::LeadingPadding, 0, TXMSample::TrailingPadding);
-		
-		TLoopDoubleBuffProps* loopBufferProps = (TLoopDoubleBuffProps*)result;
-		loopBufferProps->samplesize = size;
-		
-		return result + TXMSample::LeadingPadding;
-	}
-	
-	static void freePaddedMem(mp_ubyte* mem)
-	{
-		// behave safely on NULL
-		if (mem == NULL)
-			return;
-			
-		delete[] getPadStartAddr(mem);
-	}
+	// small samples are carved out of shared slabs, everything else
+	// comes from the heap. Both sides have to go through these two.
+	static mp_ubyte* allocPaddedMem(mp_uint32 size);
+	static void freePaddedMem(mp_ubyte* mem);
 
 	static void copyPaddedMem(void* dst, const void* src, mp_uint32 size)
 	{
@@ -277,6 +256,29 @@ struct TXMPattern
 	mp_uword	patdata;
 	mp_ubyte*   patternData;
 	
+	// Rows and channels which contain anything, so the empty cells can be 
+	// skipped without looking at them. The index is built when it's needed,
+	// everyone who changes patternData afterwards has to call setDirty().
+	// It's not meant for the player, two threads can't build it at once
+	mutable mp_uint32	rowIndex[256/32];
+	mutable mp_uint32	channelIndex[256/32];
+	mutable bool		indexValid;
+	
+	void setDirty() { indexValid = false; }
+	
+	bool isEmpty() const;
+	bool isRowEmpty(mp_sint32 row) const;
+	bool isChannelEmpty(mp_sint32 channel) const;
+	bool isCellEmpty(mp_sint32 row, mp_sint32 channel) const;
+	
+	// first row from row on which isn't empty, rows if there's none
+	mp_sint32 getNextRow(mp_sint32 row) const;
+	// first channel from channel on with a cell in row that isn't empty, 
+	// channum if there's none
+	mp_sint32 getNextChannel(mp_sint32 row, mp_sint32 channel) const;
+	// moves to the next cell which isn't empty, starting with the given one
+	bool getNextCell(mp_sint32& row, mp_sint32& channel) const;
+	
 	mp_sint32 compress(mp_ubyte* dest) const;
 	mp_sint32 decompress(mp_ubyte* src, mp_sint32 len);
 #ifdef MILKYTRACKER
@@ -288,6 +290,9 @@ struct TXMPattern
 	
 	const TXMPattern& operator=(const TXMPattern& src);
 #endif
+
+private:
+	void buildIndex() const;
 };
 
 //////////////////////////////////////////////////////////////////////////
@@ -317,6 +322,17 @@ public:
 		virtual mp_sint32   load(XMFileBase& f, XModule* module)			= 0;
 	};
 
+	///////////////////////////////////////////////////////
+	// asked before each sample of a module is loaded,   //
+	// loadModule() gives up when it returns false		 //
+	///////////////////////////////////////////////////////
+	class LoadingObserver
+	{
+	public:
+		virtual ~LoadingObserver() { }
+		virtual bool continueLoading() = 0;
+	};
+
 	enum ModuleTypes
 	{
 		ModuleType_UNKNOWN,
@@ -432,6 +448,23 @@ public:
 	
 	mp_sint32			loadModuleSamples(XMFileBase& f, 
 										  mp_sint32 flags8 = ST_DEFAULT, mp_sint32 flags16 = ST_16BIT);
+
+	///////////////////////////////////////////////////////
+	// load samples stored at known offsets (relative to //
+	// the base offset), concurrently if the file is held//
+	// in memory. Meant for packed samples, which take   //
+	// much longer to decode than to read.               //
+	///////////////////////////////////////////////////////
+	struct TSampleLocation
+	{
+		mp_uint32	offset;
+		void*		buffer;
+		mp_uint32	size;
+		mp_uint32	length;
+		mp_sint32	flags;
+	};
+	
+	static bool			loadSamples(XMFileBase& f, const TSampleLocation* samples, mp_uint32 count);
 	
 	static void			convertXMVolumeEffects(mp_ubyte volume, mp_ubyte& eff, mp_ubyte& op);
 	
@@ -475,10 +508,26 @@ private:
 	// Indicates whether a file is loaded or if it's just an empty song 
 	bool			moduleLoaded;
 
+	LoadingObserver* loadingObserver;
+	bool			loadingCancelled;
+
 	// each module comes with it's own sample-memory management (MILKYPLAY_MAXSAMPLES samples max.)
 	mp_ubyte*		samplePool[MP_MAXSAMPLES];
 	mp_uint32		samplePointerIndex;
 
+	// empty entries below samplePointerIndex
+	mp_uint32		freeSampleSlots[MP_MAXSAMPLES];
+	mp_uint32		numFreeSampleSlots;
+
+	// pool entries hashed by address (entry+1, 0 is empty), linear probing
+	enum { SampleHashSize = MP_MAXSAMPLES*2 };
+	mp_uint32		sampleHash[SampleHashSize];
+	
+	mp_uint32		findSampleHash(const mp_ubyte* mem) const;
+	void			addSamplePtr(mp_ubyte* mem);
+	mp_ubyte*		removeSampleHash(mp_uint32 hashIndex);
+	void			freeSamplePool();
+
 	// song message retrieving
 	char*			messagePtr;
 
@@ -635,10 +684,14 @@ public:
 	mp_sint32		loadModule(XMFileBase& f, bool scanForSubSongs = false);
 	mp_sint32		loadModule(const SYSCHAR* fileName, bool scanForSubSongs = false);	 
 
+	// loading can be watched (and cancelled) from another thread through this
+	void			setLoadingObserver(LoadingObserver* observer) { loadingObserver = observer; }
+
 	///////////////////////////////////////////////////
 	// Module exporters								 //
 	///////////////////////////////////////////////////
 	mp_sint32		saveExtendedModule(const SYSCHAR* fileName);	// FT2 (.XM)
+	mp_sint32		saveExtendedModule(XMFileBase& f);
 	mp_sint32		saveProtrackerModule(const SYSCHAR* fileName);  // Protracker compatible (.MOD)
 
 	///////////////////////////////////////////////////
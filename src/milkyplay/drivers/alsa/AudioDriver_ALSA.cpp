@@ -107,7 +107,7 @@ void AudioDriver_ALSA::async_direct_callback(snd_async_handler_t *ahandler)
 			// PPS - The downside is that if the user has the wrong mixer rate, they will get an error
 			//       dialog - hopefully they'll read the message on stderr...
 		else
-			audioDriver->fillAudioWithCompensation(static_cast<char*> (my_areas->addr) + offset*4, frames * 2);
+			audioDriver->fillAudioWithCompensation(static_cast<char*> (my_areas->addr) + offset*audioDriver->frameSize, frames * audioDriver->frameSize);
 
 		commitres = snd_pcm_mmap_commit(handle, offset, frames);
 		if (commitres < 0 || (snd_pcm_uframes_t)commitres != frames) {
@@ -122,7 +122,8 @@ void AudioDriver_ALSA::async_direct_callback(snd_async_handler_t *ahandler)
 }
 
 AudioDriver_ALSA::AudioDriver_ALSA() :
-	AudioDriver_COMPENSATE()
+	AudioDriver_COMPENSATE(),
+	frameSize(4)
 {
 }
 
@@ -146,8 +147,11 @@ mp_sint32 AudioDriver_ALSA::initDevice(mp_sint32 periodSizeAsSamples, const mp_u
 		return -1;
 	}
 
+	const bool floatOutput = mixer->getOutputSampleFormat() == MasterMixer::SampleFormatFloat32;
+	frameSize = mixer->getOutputFrameSize();
+
 	if ((err = snd_pcm_set_params(pcm,
-		SND_PCM_FORMAT_S16,
+		floatOutput ? SND_PCM_FORMAT_FLOAT : SND_PCM_FORMAT_S16,
 		SND_PCM_ACCESS_MMAP_INTERLEAVED,
 		2, // channels
 		mixFrequency,
@@ -214,10 +218,10 @@ mp_sint32 AudioDriver_ALSA::start()
 				}
 			}
 			// Sanity check
-			if (my_areas->step != 32 && my_areas->first != 0)
+			if (my_areas->step != frameSize*8 && my_areas->first != 0)
 				fprintf(stderr, "ALSA: Unsupported audio format.\n");
 
-			memset(static_cast<char*> (my_areas->addr) + offset*4, 0, frames * 4);
+			memset(static_cast<char*> (my_areas->addr) + offset*frameSize, 0, frames * frameSize);
 			int commitres = snd_pcm_mmap_commit(pcm, offset, frames);
 			if (err < 0 || (snd_pcm_uframes_t)commitres != frames) {
 				if ((err = snd_pcm_recover(pcm, commitres >= 0 ? -EPIPE : commitres, 0)) < 0) {
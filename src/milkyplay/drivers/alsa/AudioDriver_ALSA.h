@@ -46,6 +46,7 @@ private:
 	snd_pcm_t *pcm;
 	char *stream;
 	snd_pcm_uframes_t period_size;
+	mp_uint32 frameSize;
 
 	static void async_direct_callback(snd_async_handler_t *ahandler);
 
@@ -63,6 +64,8 @@ public:
 	virtual     mp_sint32   pause();
 	virtual     mp_sint32   resume();
 	
+	virtual		bool		supportsFloatOutput() const { return true; }
+
 	virtual		const char* getDriverID() { return "ALSA"; }
 	virtual		mp_sint32	getPreferredBufferSize() const { return 2048; }
 };
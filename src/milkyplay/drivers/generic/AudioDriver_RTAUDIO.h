@@ -73,6 +73,7 @@ public:
 	virtual		mp_uint32	getNumPlayedSamples() const;
 	virtual		mp_uint32	getBufferPos() const;
 	virtual		bool		supportsTimeQuery() const;
+	virtual		bool		supportsFloatOutput() const;
 	virtual		const char* getDriverID();
 	virtual		void		advance();
 	virtual		mp_sint32	getPreferredSampleRate() const;
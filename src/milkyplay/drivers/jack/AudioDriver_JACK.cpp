@@ -63,6 +63,19 @@ int AudioDriver_JACK::jackProcess(jack_nframes_t nframes, void *arg)
 	leftBuffer = (jack_default_audio_sample_t*) audioDriver->jack_port_get_buffer(audioDriver->leftPort, nframes);
 	rightBuffer = (jack_default_audio_sample_t*) audioDriver->jack_port_get_buffer(audioDriver->rightPort, nframes);
 
+	if (audioDriver->rawStreamFloat)
+	{
+		audioDriver->fillAudioWithCompensation((char*)audioDriver->rawStreamFloat, nframes * 8);
+
+		// JACK uses non-interleaved floating-point samples, we only need to split them
+		for(int out = 0, in = 0; in < nframes; in++)
+		{
+			leftBuffer[in] = audioDriver->rawStreamFloat[out++];
+			rightBuffer[in] = audioDriver->rawStreamFloat[out++];
+		}
+		return 0;
+	}
+
 	audioDriver->fillAudioWithCompensation((char*)audioDriver->rawStream, nframes * 4);
 
 	// JACK uses non-interleaved floating-point samples, we need to convert
@@ -77,13 +90,15 @@ int AudioDriver_JACK::jackProcess(jack_nframes_t nframes, void *arg)
 AudioDriver_JACK::AudioDriver_JACK() :
 	AudioDriver_COMPENSATE(),
 	paused(false),
-	rawStream(NULL)
+	rawStream(NULL),
+	rawStreamFloat(NULL)
 {
 }
 
 AudioDriver_JACK::~AudioDriver_JACK()
 {
 	if(rawStream) delete[] rawStream;
+	if(rawStreamFloat) delete[] rawStreamFloat;
 }
 
 // On error return a negative value
@@ -159,8 +174,11 @@ mp_sint32 AudioDriver_JACK::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mi
 	this->mixFrequency = jack_get_sample_rate(hJack);
 	printf("JACK: Mixer frequency: %i\n", this->mixFrequency);
 	//delete[] rawStream; // pailes: make sure this isn't allocated yet
-	assert(!rawStream);		// If it is allocated, something went wrong and we need to know about it
-	rawStream = new mp_sword[bufferSize];
+	assert(!rawStream && !rawStreamFloat);		// If it is allocated, something went wrong and we need to know about it
+	if (mixer->getOutputSampleFormat() == MasterMixer::SampleFormatFloat32)
+		rawStreamFloat = new float[bufferSize];
+	else
+		rawStream = new mp_sword[bufferSize];
 	printf("JACK: Latency = %i frames\n", jackFrames);
 	return bufferSize;
 }
@@ -178,6 +196,8 @@ mp_sint32 AudioDriver_JACK::closeDevice()
 	jack_client_close(hJack);
 	if(rawStream) delete[] rawStream;
 	rawStream = NULL;
+	if(rawStreamFloat) delete[] rawStreamFloat;
+	rawStreamFloat = NULL;
 	dlclose(libJack);
 	libJack = NULL;
 	return 0;
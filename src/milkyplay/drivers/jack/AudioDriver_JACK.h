@@ -47,6 +47,7 @@ private:
 	jack_client_t *hJack;
 	jack_port_t *leftPort, *rightPort;
 	mp_sword *rawStream;
+	float *rawStreamFloat;
 	int jackFrames;
 	bool paused;
 	void *libJack;
@@ -94,6 +95,7 @@ public:
 	virtual     mp_sint32   resume();
 	
 	virtual		bool		supportsPowerOfTwoCompensation() { return true; }
+	virtual		bool		supportsFloatOutput() const { return true; }
 
 	virtual		const char* getDriverID() { return "JACK"; }
 	virtual		mp_sint32	getPreferredBufferSize() const { return 2048; }
@@ -45,9 +45,9 @@ void SDLCALL AudioDriver_SDL::fill_audio(void *udata, Uint8 *stream, int length)
 {
 	AudioDriver_SDL* audioDriver = (AudioDriver_SDL*)udata;
 
-	if(length>>2 != audioDriver->periodSize)
+	if(length / audioDriver->frameSize != audioDriver->periodSize)
 	{
-		fprintf(stderr, "SDL: Invalid buffer size: %i (should be %i), skipping..\n", length >> 2, audioDriver->periodSize);
+		fprintf(stderr, "SDL: Invalid buffer size: %i (should be %i), skipping..\n", length / audioDriver->frameSize, audioDriver->periodSize);
 	}
 	// See comment in AudioDriver_ALSA.cpp
 	else
@@ -57,7 +57,9 @@ void SDLCALL AudioDriver_SDL::fill_audio(void *udata, Uint8 *stream, int length)
 }
 
 AudioDriver_SDL::AudioDriver_SDL() :
-	AudioDriver_COMPENSATE()
+	AudioDriver_COMPENSATE(),
+	periodSize(0),
+	frameSize(4)
 {
 }
 
@@ -79,7 +81,9 @@ mp_sint32 AudioDriver_SDL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mix
 	}
 
 	wanted.freq = mixFrequency;
-	wanted.format = AUDIO_S16SYS;
+	const bool floatOutput = mixer->getOutputSampleFormat() == MasterMixer::SampleFormatFloat32;
+
+	wanted.format = floatOutput ? AUDIO_F32SYS : AUDIO_S16SYS;
 	wanted.channels = 2; /* 1 = mono, 2 = stereo */
 	wanted.samples = bufferSizeInWords / wanted.channels; /* Good low-latency value for callback */
 
@@ -94,7 +98,7 @@ mp_sint32 AudioDriver_SDL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mix
 	if(SDL_OpenAudio(&wanted, &obtained) < 0)
 	{
 		memcpy(&wanted, &saved, sizeof(wanted));
-		fprintf(stderr, "SDL: Failed to open audio device! (buffer = %d bytes)..\n", saved.samples*4);
+		fprintf(stderr, "SDL: Failed to open audio device! (buffer = %d bytes)..\n", saved.samples*mixer->getOutputFrameSize());
 		fprintf(stderr, "SDL: Try setting \"Force 2^n sizes\" in the config menu and restarting.\n");
 		return MP_DEVICE_ERROR;
 	}
@@ -103,7 +107,7 @@ mp_sint32 AudioDriver_SDL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mix
 
 	if(wanted.format != obtained.format)
 	{
-		fprintf(stderr, "SDL: Audio driver doesn't support 16-bit signed samples!\n");
+		fprintf(stderr, floatOutput ? "SDL: Audio driver doesn't support 32-bit float samples!\n" : "SDL: Audio driver doesn't support 16-bit signed samples!\n");
 		return MP_DEVICE_ERROR;
 	}
 
@@ -123,6 +127,7 @@ mp_sint32 AudioDriver_SDL::initDevice(mp_sint32 bufferSizeInWords, mp_uint32 mix
 	printf("SDL: Buffer size = %i samples (requested %i)\n", obtained.samples, finalWantedSize / wanted.channels);
 
 	periodSize = obtained.samples;
+	frameSize = mixer->getOutputFrameSize();
 	// If we got what we requested, return MP_OK,
 	// otherwise return the actual number of samples * number of channels
 	return (bufferSizeInWords / wanted.channels == obtained.samples) ? MP_OK : obtained.samples * obtained.channels;
@@ -46,6 +46,7 @@ class AudioDriver_SDL : public AudioDriver_COMPENSATE
 {
 private:
 	mp_uint32	periodSize;
+	mp_uint32	frameSize;
 	
 	static void SDLCALL fill_audio(void *udata, Uint8 *stream, int len); 
 									 
@@ -63,6 +64,8 @@ public:
 	virtual		mp_sint32	pause();
 	virtual		mp_sint32	resume();
 	
+	virtual		bool		supportsFloatOutput() const { return true; }
+
 	virtual		const char*	getDriverID() { return "SDLAudio"; }
 	virtual		mp_sint32	getPreferredBufferSize() const { return 2048; }	
 };
@@ -68,6 +68,7 @@
 #include "DEMOSDK/BASTYPES.H"
 
 #include <math.h>
+#include <string.h>
 
 #include "sound.h"
 
@@ -102,6 +103,7 @@ static const int YmEnvDef[ 16 ][ 3 ] = {
 
 
 /* Buffer to store the 16 envelopes built from YmEnvDef */
+/* (shared by all the emulated chips, read only once built) */
 static ymu16	YmEnvWaves[ 16 ][ 32 * 3 ];		/* 16 envelopes with 3 blocks of 32 volumes */
 
 
@@ -132,6 +134,7 @@ static ymu16 volumetable_original[16][16][16] =
 #include "ym2149_fixed_vol.h"
 
 /* Corresponding table interpolated to 5 bit D/A output level (16 bits unsigned) */
+/* (shared by all the emulated chips, read only once built) */
 static ymu16 ymout5_u16[32][32][32];
 
 /* Same table, after conversion to signed results (same pointer, with different type) */
@@ -168,47 +171,12 @@ static yms16 *ymout5 = (yms16 *)ymout5_u16;
 
 
 /*--------------------------------------------------------------*/
-/* Variables for the YM2149 emulator (need to be saved and	*/
-/* restored in memory snapshots)				*/
+/* The variables of each YM2149 emulator are in YM2149context	*/
+/* (see sound.h), only the mixing method is global.		*/
 /*--------------------------------------------------------------*/
 
-static ymu32	stepA , stepB , stepC;
-static ymu32	posA , posB , posC;
-static ymu32	mixerTA , mixerTB , mixerTC;
-static ymu32	mixerNA , mixerNB , mixerNC;
-
-static ymu32	noiseStep;
-static ymu32	noisePos;
-static ymu32	currentNoise;
-static ymu32	RndRack;				/* current random seed */
-
-static ymu32	envStep;
-static ymu32	envPos;
-static int	envShape;
-
-static ymu16	EnvMask3Voices = 0;			/* mask is 0x1f for voices having an active envelope */
-static ymu16	Vol3Voices = 0;				/* volume 0-0x1f for voices having a constant volume */
-							/* volume is set to 0 if voice has an envelope in EnvMask3Voices */
-
-
-/* Global variables that can be changed/read from other parts of Hatari */
-u8		SoundRegs[ 14 ];
-
 int		YmVolumeMixing = YM_TABLE_MIXING;
 
-bool		bEnvelopeFreqFlag;			/* Cleared each frame for YM saving */
-
-//s16		MixBuffer[MIXBUFFER_SIZE][2];
-int		nGeneratedSamples;			/* Generated samples since audio buffer update */
-static int	ActiveSndBufIdx;			/* Current working index into above mix buffer */
-static int	ActiveSndBufIdxAvi;			/* Current working index to save an AVI audio frame */
-
-static yms64	SamplesPerFrame_unrounded = 0;		/* Number of samples for the current VBL, with simulated fractional part */
-static int 	SamplesPerFrame;			/* Number of samples to generate for the current VBL */
-static int	CurrentSamplesNb = 0;			/* Number of samples already generated for the current VBL */
-
-bool		Sound_BufferIndexNeedReset = false;
-
 
 /*--------------------------------------------------------------*/
 /* Local functions prototypes					*/
@@ -227,18 +195,19 @@ bool		Sound_BufferIndexNeedReset = false;
  * I disclose this information into the public domain so that it
  * cannot be patented. May 23 2012 David Savinkoff.
  */
-static ymsample	PWMaliasFilter(ymsample x0)
+static ymsample	PWMaliasFilter(YM2149context *ym, ymsample x0)
 {
-	static	yms32 y0 = 0, x1 = 0;
+	yms32	y0 = ym->filterY0;
 
 	if (x0 >= y0)
 	/* YM Pull up   */
 		y0 = x0;
 	else
 	/* R8 Pull down */
-		y0 = (3*(x0 + x1) + (y0<<1)) >> 3;
+		y0 = (3*(x0 + ym->filterX1) + (y0<<1)) >> 3;
 
-	x1 = x0;
+	ym->filterY0 = y0;
+	ym->filterX1 = x0;
 	return (ymsample) y0;
 }
 
@@ -541,43 +510,43 @@ static void	Ym2149_BuildVolumeTable(void)
  * Reset all ym registers as well as the internal variables
  */
 
-static void	Ym2149_Reset(void)
+static void	Ym2149_Reset(YM2149context *ym)
 {
 	int	i;
 
+	memset ( ym , 0 , sizeof(*ym) );
+
 	for ( i=0 ; i<14 ; i++ )
-		Sound_WriteReg ( i , 0 );
+		Sound_WriteReg ( ym , i , 0 );
 
-	Sound_WriteReg ( 7 , 0xff );
+	Sound_WriteReg ( ym , 7 , 0xff );
 
-	posA = 0;
-	posB = 0;
-	posC = 0;
+	ym->posA = 0;
+	ym->posB = 0;
+	ym->posC = 0;
 
-	currentNoise = 0xffff;
+	ym->currentNoise = 0xffff;
 
-	RndRack = 1;
+	ym->RndRack = 1;
 
-	envShape = 0;
-	envPos = 0;
+	ym->envShape = 0;
+	ym->envPos = 0;
 }
 
 /*-----------------------------------------------------------------------*/
 /**
-* Init some internal tables for faster results (env, volume)
-* and reset the internal states.
+* Init some internal tables for faster results (env, volume).
+* The tables are shared by all the emulated chips, build them
+* once before the first chip is reset with Ym2149_Reset.
 */
 
-static void	Ym2149_Init(void)
+static void	Ym2149_BuildTables(void)
 {
 	/* Build the 16 envelope shapes */
 	YM2149_EnvBuild();
 
 	/* Build the volume conversion table */
 	Ym2149_BuildVolumeTable();
-
-	/* Reset YM2149 internal states */
-	Ym2149_Reset();
 }
 
 
@@ -588,16 +557,16 @@ static void	Ym2149_Init(void)
  * 2 taps (17,14)
  */
 
-static ymu32	YM2149_RndCompute(void)
+static ymu32	YM2149_RndCompute(YM2149context *ym)
 {
 	/*  17 stage, 2 taps (17, 14) LFSR */
-	if (RndRack & 1)
+	if (ym->RndRack & 1)
 	{
-		RndRack = RndRack>>1 ^ 0x12000;		/* bits 17 and 14 are ones */
+		ym->RndRack = ym->RndRack>>1 ^ 0x12000;		/* bits 17 and 14 are ones */
 		return 0xffff;
 	}
 	else
-	{	RndRack >>= 1;
+	{	ym->RndRack >>= 1;
 		return 0;
 	}
 }
@@ -708,9 +677,8 @@ static ymu32	Ym2149_EnvStepCompute(ymu8 rHigh , ymu8 rLow)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Main function : compute the value of the next sample.
- * Mixes all 3 voices with tone+noise+env and apply low pass
- * filter if needed.
+ * Compute the value of the current sample, before the low pass filter.
+ * Mixes all 3 voices with tone+noise+env.
  * All operations are done with integer math, using <<24 to simulate
  * floating point precision : upper 8 bits are the integer part, lower 24
  * are the fractional part.
@@ -720,7 +688,7 @@ static ymu32	Ym2149_EnvStepCompute(ymu8 rHigh , ymu8 rLow)
  * to all 0 bits or all 1 bits using a '-'
  */
 
-static ymsample	YM2149_NextSample(void)
+static ymsample	YM2149_CurrentSample(YM2149context *ym)
 {
 	ymsample	sample;
 	ymu32		bt;
@@ -730,59 +698,176 @@ static ymsample	YM2149_NextSample(void)
 
 
 	/* Noise value : 0 or 0xffff */
-	if ( noisePos&0xff000000 )			/* integer part > 0 */
+	if ( ym->noisePos&0xff000000 )			/* integer part > 0 */
 	{
-		currentNoise = YM2149_RndCompute();
-		noisePos &= 0xffffff;			/* keep fractional part of noisePos */
+		ym->currentNoise = YM2149_RndCompute(ym);
+		ym->noisePos &= 0xffffff;			/* keep fractional part of noisePos */
 	}
-	bn = currentNoise;				/* 0 or 0xffff */
+	bn = ym->currentNoise;				/* 0 or 0xffff */
 
 	/* Get the 5 bits volume corresponding to the current envelope's position */
-	Env3Voices = YmEnvWaves[ envShape ][ envPos>>24 ];	/* integer part of envPos is in bits 24-31 */
-	Env3Voices &= EnvMask3Voices;			/* only keep volumes for voices using envelope */
+	Env3Voices = YmEnvWaves[ ym->envShape ][ ym->envPos>>24 ];	/* integer part of envPos is in bits 24-31 */
+	Env3Voices &= ym->EnvMask3Voices;			/* only keep volumes for voices using envelope */
 
 //fprintf ( stderr , "env %x %x %x\n" , Env3Voices , envStep , envPos );
 
 	/* Tone3Voices will contain the output state of each voice : 0 or 0x1f */
-	bt = -( (posA>>24) & 1);			/* 0 if bit24=0 or 0xffffffff if bit24=1 */
-	bt = (bt | mixerTA) & (bn | mixerNA);		/* 0 or 0xffff */
+	bt = -( (ym->posA>>24) & 1);			/* 0 if bit24=0 or 0xffffffff if bit24=1 */
+	bt = (bt | ym->mixerTA) & (bn | ym->mixerNA);		/* 0 or 0xffff */
 	Tone3Voices = bt & YM_MASK_1VOICE;		/* 0 or 0x1f */
-	bt = -( (posB>>24) & 1);
-	bt = (bt | mixerTB) & (bn | mixerNB);
+	bt = -( (ym->posB>>24) & 1);
+	bt = (bt | ym->mixerTB) & (bn | ym->mixerNB);
 	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 5;
-	bt = -( (posC>>24) & 1);
-	bt = (bt | mixerTC) & (bn | mixerNC);
+	bt = -( (ym->posC>>24) & 1);
+	bt = (bt | ym->mixerTC) & (bn | ym->mixerNC);
 	Tone3Voices |= ( bt & YM_MASK_1VOICE ) << 10;
 
 	/* Combine fixed volumes and envelope volumes and keep the resulting */
 	/* volumes depending on the output state of each voice (0 or 0x1f) */
-	Tone3Voices &= ( Env3Voices | Vol3Voices );
+	Tone3Voices &= ( Env3Voices | ym->Vol3Voices );
 
 	/* D/A conversion of the 3 volumes into a sample using a precomputed conversion table */
 
-	if (stepA == 0  &&  (Tone3Voices & YM_MASK_A) > 1)
+	if (ym->stepA == 0  &&  (Tone3Voices & YM_MASK_A) > 1)
 		Tone3Voices -= 1;     /* Voice A AC component removed; Transient DC component remains */
 
-	if (stepB == 0  &&  (Tone3Voices & YM_MASK_B) > 1<<5)
+	if (ym->stepB == 0  &&  (Tone3Voices & YM_MASK_B) > 1<<5)
 		Tone3Voices -= 1<<5;  /* Voice B AC component removed; Transient DC component remains */
 
-	if (stepC == 0  &&  (Tone3Voices & YM_MASK_C) > 1<<10)
+	if (ym->stepC == 0  &&  (Tone3Voices & YM_MASK_C) > 1<<10)
 		Tone3Voices -= 1<<10; /* Voice C AC component removed; Transient DC component remains */
 
 	sample = ymout5[ Tone3Voices ];			/* 16 bits signed value */
 
+	return sample;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Number of samples (at most 'max') before the integer part of a
+ * position advancing by 'step' changes. Until then the tone, noise
+ * or envelope driven by this position keeps the same state.
+ */
+
+static ymu32	YM2149_SamplesToEdge(ymu32 pos , ymu32 step , ymu32 max)
+{
+	ymu32	dist;
+	ymu32	n;
+
+	if ( step == 0 )
+		return max;
+
+	dist = (1u<<24) - (pos & 0xffffff);		/* 1 to 1<<24 */
+	n = (dist + step - 1) / step;
+
+	return n < max ? n : max;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Advance the noise generator by 'n' samples, the random value for
+ * the first one has already been taken by YM2149_CurrentSample.
+ * The random generator has to step at the same samples as it would
+ * one sample at a time, even when no voice is listening to it.
+ */
+
+static void	YM2149_NoiseAdvance(YM2149context *ym , ymu32 n)
+{
+	ymu32	k;
+
+	ym->noisePos += ym->noiseStep;
+
+	for ( n-- ; n > 0 ; n -= k )
+	{
+		if ( ym->noisePos&0xff000000 )			/* integer part > 0 */
+		{
+			ym->currentNoise = YM2149_RndCompute(ym);
+			ym->noisePos &= 0xffffff;
+		}
 
-	/* Increment positions */
-	posA += stepA;
-	posB += stepB;
-	posC += stepC;
-	noisePos += noiseStep;
+		k = YM2149_SamplesToEdge ( ym->noisePos , ym->noiseStep , n );
+		ym->noisePos += k * ym->noiseStep;
+	}
+}
 
-	envPos += envStep;
-	if ( envPos >= (3*32) << 24 )			/* blocks 0, 1 and 2 were used (envPos 0 to 95) */
-		envPos -= (2*32) << 24;			/* replay/loop blocks 1 and 2 (envPos 32 to 95) */
 
-	return PWMaliasFilter(sample);
+/*-----------------------------------------------------------------------*/
+/**
+ * Advance the envelope by 'n' samples. When no voice uses the envelope
+ * a run can span several of its periods, so the loop back into blocks
+ * 1 and 2 may happen more than once.
+ */
+
+static void	YM2149_EnvAdvance(YM2149context *ym , ymu32 n)
+{
+	ymu32	k;
+
+	for ( ; n > 0 ; n -= k )
+	{
+		k = n;
+		if ( ym->envStep )				/* samples until the end of block 2 */
+		{
+			k = ( ((3*32) << 24) - ym->envPos + ym->envStep - 1 ) / ym->envStep;
+			if ( k > n )
+				k = n;
+		}
+
+		ym->envPos += k * ym->envStep;
+		if ( ym->envPos >= (3*32) << 24 )			/* blocks 0, 1 and 2 were used (envPos 0 to 95) */
+			ym->envPos -= (2*32) << 24;			/* replay/loop blocks 1 and 2 (envPos 32 to 95) */
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Main function : compute the next 'count' samples.
+ * Between two edges of the tone, noise or envelope generators the
+ * mixed output is constant, so each run is computed once and the
+ * positions are advanced by the whole run. Edges of generators that
+ * are not mixed in don't end a run. The low pass filter only changes
+ * a constant input until it has settled on it, after that the rest
+ * of the run is a plain fill.
+ */
+
+static void	YM2149_NextSamples(YM2149context *ym , ymsample *out , ymu32 count)
+{
+	while ( count > 0 )
+	{
+		ymsample	sample = YM2149_CurrentSample(ym);
+		ymu32		n = count;
+		ymu32		i;
+
+		if ( !ym->mixerTA )
+			n = YM2149_SamplesToEdge ( ym->posA , ym->stepA , n );
+		if ( !ym->mixerTB )
+			n = YM2149_SamplesToEdge ( ym->posB , ym->stepB , n );
+		if ( !ym->mixerTC )
+			n = YM2149_SamplesToEdge ( ym->posC , ym->stepC , n );
+		if ( !ym->mixerNA || !ym->mixerNB || !ym->mixerNC )
+			n = YM2149_SamplesToEdge ( ym->noisePos , ym->noiseStep , n );
+		if ( ym->EnvMask3Voices )
+			n = YM2149_SamplesToEdge ( ym->envPos , ym->envStep , n );
+
+		/* Increment positions */
+		ym->posA += n * ym->stepA;
+		ym->posB += n * ym->stepB;
+		ym->posC += n * ym->stepC;
+
+		YM2149_NoiseAdvance ( ym , n );
+
+		YM2149_EnvAdvance ( ym , n );
+
+		for ( i=0 ; i<n && ( ym->filterY0 != sample || ym->filterX1 != sample ) ; i++ )
+			*out++ = PWMaliasFilter(ym, sample);
+
+		for ( ; i<n ; i++ )
+			*out++ = sample;
+
+		count -= n;
+	}
 }
 
 
@@ -792,126 +877,126 @@ static ymsample	YM2149_NextSample(void)
  * time an YM register is changed.
  */
 #define BIT_SHIFT 24
-void Sound_WriteReg( int reg , u8 data )
+void Sound_WriteReg( YM2149context *ym , int reg , u8 data )
 {
 	switch (reg)
 	{
 		case 0:
-			SoundRegs[0] = data;
-			stepA = Ym2149_ToneStepCompute ( SoundRegs[1] , SoundRegs[0] );
-			if (!stepA) posA = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[0] = data;
+			ym->stepA = Ym2149_ToneStepCompute ( ym->SoundRegs[1] , ym->SoundRegs[0] );
+			if (!ym->stepA) ym->posA = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 1:
-			SoundRegs[1] = data & 0x0f;
-			stepA = Ym2149_ToneStepCompute ( SoundRegs[1] , SoundRegs[0] );
-			if (!stepA) posA = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[1] = data & 0x0f;
+			ym->stepA = Ym2149_ToneStepCompute ( ym->SoundRegs[1] , ym->SoundRegs[0] );
+			if (!ym->stepA) ym->posA = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 2:
-			SoundRegs[2] = data;
-			stepB = Ym2149_ToneStepCompute ( SoundRegs[3] , SoundRegs[2] );
-			if (!stepB) posB = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[2] = data;
+			ym->stepB = Ym2149_ToneStepCompute ( ym->SoundRegs[3] , ym->SoundRegs[2] );
+			if (!ym->stepB) ym->posB = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 3:
-			SoundRegs[3] = data & 0x0f;
-			stepB = Ym2149_ToneStepCompute ( SoundRegs[3] , SoundRegs[2] );
-			if (!stepB) posB = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[3] = data & 0x0f;
+			ym->stepB = Ym2149_ToneStepCompute ( ym->SoundRegs[3] , ym->SoundRegs[2] );
+			if (!ym->stepB) ym->posB = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 4:
-			SoundRegs[4] = data;
-			stepC = Ym2149_ToneStepCompute ( SoundRegs[5] , SoundRegs[4] );
-			if (!stepC) posC = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[4] = data;
+			ym->stepC = Ym2149_ToneStepCompute ( ym->SoundRegs[5] , ym->SoundRegs[4] );
+			if (!ym->stepC) ym->posC = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 5:
-			SoundRegs[5] = data & 0x0f;
-			stepC = Ym2149_ToneStepCompute ( SoundRegs[5] , SoundRegs[4] );
-			if (!stepC) posC = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
+			ym->SoundRegs[5] = data & 0x0f;
+			ym->stepC = Ym2149_ToneStepCompute ( ym->SoundRegs[5] , ym->SoundRegs[4] );
+			if (!ym->stepC) ym->posC = 1u<<BIT_SHIFT;		// Assume output always 1 if 0 period (for Digi-sample)
 			break;
 
 		case 6:
-			SoundRegs[6] = data & 0x1f;
-			noiseStep = Ym2149_NoiseStepCompute ( SoundRegs[6] );
-			if (!noiseStep)
+			ym->SoundRegs[6] = data & 0x1f;
+			ym->noiseStep = Ym2149_NoiseStepCompute ( ym->SoundRegs[6] );
+			if (!ym->noiseStep)
 			{
-				noisePos = 0;
-				currentNoise = 0xffff;
+				ym->noisePos = 0;
+				ym->currentNoise = 0xffff;
 			}
 			break;
 
 		case 7:
-			SoundRegs[7] = data & 0x3f;			/* ignore bits 6 and 7 */
-			mixerTA = (data&(1<<0)) ? 0xffff : 0;
-			mixerTB = (data&(1<<1)) ? 0xffff : 0;
-			mixerTC = (data&(1<<2)) ? 0xffff : 0;
-			mixerNA = (data&(1<<3)) ? 0xffff : 0;
-			mixerNB = (data&(1<<4)) ? 0xffff : 0;
-			mixerNC = (data&(1<<5)) ? 0xffff : 0;
+			ym->SoundRegs[7] = data & 0x3f;			/* ignore bits 6 and 7 */
+			ym->mixerTA = (data&(1<<0)) ? 0xffff : 0;
+			ym->mixerTB = (data&(1<<1)) ? 0xffff : 0;
+			ym->mixerTC = (data&(1<<2)) ? 0xffff : 0;
+			ym->mixerNA = (data&(1<<3)) ? 0xffff : 0;
+			ym->mixerNB = (data&(1<<4)) ? 0xffff : 0;
+			ym->mixerNC = (data&(1<<5)) ? 0xffff : 0;
 			break;
 
 		case 8:
-			SoundRegs[8] = data & 0x1f;
+			ym->SoundRegs[8] = data & 0x1f;
 			if ( data & 0x10 )
 			{
-				EnvMask3Voices |= YM_MASK_A;		/* env ON */
-				Vol3Voices &= ~YM_MASK_A;		/* fixed vol OFF */
+				ym->EnvMask3Voices |= YM_MASK_A;		/* env ON */
+				ym->Vol3Voices &= ~YM_MASK_A;		/* fixed vol OFF */
 			}
 			else
 			{
-				EnvMask3Voices &= ~YM_MASK_A;		/* env OFF */
-				Vol3Voices &= ~YM_MASK_A;		/* clear previous vol */
-				Vol3Voices |= YmVolume4to5[ SoundRegs[8] ];	/* fixed vol ON */
+				ym->EnvMask3Voices &= ~YM_MASK_A;		/* env OFF */
+				ym->Vol3Voices &= ~YM_MASK_A;		/* clear previous vol */
+				ym->Vol3Voices |= YmVolume4to5[ ym->SoundRegs[8] ];	/* fixed vol ON */
 			}
 			break;
 
 		case 9:
-			SoundRegs[9] = data & 0x1f;
+			ym->SoundRegs[9] = data & 0x1f;
 			if ( data & 0x10 )
 			{
-				EnvMask3Voices |= YM_MASK_B;		/* env ON */
-				Vol3Voices &= ~YM_MASK_B;		/* fixed vol OFF */
+				ym->EnvMask3Voices |= YM_MASK_B;		/* env ON */
+				ym->Vol3Voices &= ~YM_MASK_B;		/* fixed vol OFF */
 			}
 			else
 			{
-				EnvMask3Voices &= ~YM_MASK_B;		/* env OFF */
-				Vol3Voices &= ~YM_MASK_B;		/* clear previous vol */
-				Vol3Voices |= ( YmVolume4to5[ SoundRegs[9] ] ) << 5;	/* fixed vol ON */
+				ym->EnvMask3Voices &= ~YM_MASK_B;		/* env OFF */
+				ym->Vol3Voices &= ~YM_MASK_B;		/* clear previous vol */
+				ym->Vol3Voices |= ( YmVolume4to5[ ym->SoundRegs[9] ] ) << 5;	/* fixed vol ON */
 			}
 			break;
 
 		case 10:
-			SoundRegs[10] = data & 0x1f;
+			ym->SoundRegs[10] = data & 0x1f;
 			if ( data & 0x10 )
 			{
-				EnvMask3Voices |= YM_MASK_C;		/* env ON */
-				Vol3Voices &= ~YM_MASK_C;		/* fixed vol OFF */
+				ym->EnvMask3Voices |= YM_MASK_C;		/* env ON */
+				ym->Vol3Voices &= ~YM_MASK_C;		/* fixed vol OFF */
 			}
 			else
 			{
-				EnvMask3Voices &= ~YM_MASK_C;		/* env OFF */
-				Vol3Voices &= ~YM_MASK_C;		/* clear previous vol */
-				Vol3Voices |= ( YmVolume4to5[ SoundRegs[10] ] ) << 10;	/* fixed vol ON */
+				ym->EnvMask3Voices &= ~YM_MASK_C;		/* env OFF */
+				ym->Vol3Voices &= ~YM_MASK_C;		/* clear previous vol */
+				ym->Vol3Voices |= ( YmVolume4to5[ ym->SoundRegs[10] ] ) << 10;	/* fixed vol ON */
 			}
 			break;
 
 		case 11:
-			SoundRegs[11] = data;
-			envStep = Ym2149_EnvStepCompute ( SoundRegs[12] , SoundRegs[11] );
+			ym->SoundRegs[11] = data;
+			ym->envStep = Ym2149_EnvStepCompute ( ym->SoundRegs[12] , ym->SoundRegs[11] );
 			break;
 
 		case 12:
-			SoundRegs[12] = data;
-			envStep = Ym2149_EnvStepCompute ( SoundRegs[12] , SoundRegs[11] );
+			ym->SoundRegs[12] = data;
+			ym->envStep = Ym2149_EnvStepCompute ( ym->SoundRegs[12] , ym->SoundRegs[11] );
 			break;
 
 		case 13:
-			SoundRegs[13] = data & 0xf;
-			envPos = 0;					/* when writing to EnvShape, we must reset the EnvPos */
-			envShape = SoundRegs[13];
-			bEnvelopeFreqFlag = true;			/* used for YmFormat saving */
+			ym->SoundRegs[13] = data & 0xf;
+			ym->envPos = 0;					/* when writing to EnvShape, we must reset the EnvPos */
+			ym->envShape = ym->SoundRegs[13];
+			ym->bEnvelopeFreqFlag = true;			/* used for YmFormat saving */
 			break;
 
 	}
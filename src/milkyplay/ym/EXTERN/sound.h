@@ -51,6 +51,38 @@ typedef		yms16			ymsample;	/* Output samples are mono 16bits signed PCM */
 
 extern int	YmVolumeMixing;
 
-void Sound_WriteReg( int reg , ymu8 data );
+/* State of one emulated YM2149. Everything that changes while playing is	*/
+/* kept here so that several chips can run at the same time, the envelope	*/
+/* shapes and the volume tables are built once and shared read only.		*/
+struct YM2149context_
+{
+	ymu32	stepA , stepB , stepC;
+	ymu32	posA , posB , posC;
+	ymu32	mixerTA , mixerTB , mixerTC;
+	ymu32	mixerNA , mixerNB , mixerNC;
+
+	ymu32	noiseStep;
+	ymu32	noisePos;
+	ymu32	currentNoise;
+	ymu32	RndRack;				/* current random seed */
+
+	ymu32	envStep;
+	ymu32	envPos;
+	int	envShape;
+
+	ymu16	EnvMask3Voices;				/* mask is 0x1f for voices having an active envelope */
+	ymu16	Vol3Voices;				/* volume 0-0x1f for voices having a constant volume */
+							/* volume is set to 0 if voice has an envelope in EnvMask3Voices */
+
+	yms32	filterY0 , filterX1;			/* PWMaliasFilter history */
+
+	ymu8	SoundRegs[ 14 ];
+	ymu8	selectedReg;				/* register selected for the next write */
+
+	bool	bEnvelopeFreqFlag;			/* Cleared each frame for YM saving */
+};
+typedef struct YM2149context_ YM2149context;
+
+void Sound_WriteReg( YM2149context *ym , int reg , ymu8 data );
 
 #endif  /* HATARI_SOUND_H */
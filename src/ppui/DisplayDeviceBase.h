@@ -203,6 +203,14 @@ public:
 
 	virtual void update(const PPRect& r) = 0;
 
+	// Several damaged areas at once, devices which can should
+	// present them with a single swap
+	virtual void updateRects(const PPRect* rects, pp_int32 numRects)
+	{
+		for (pp_int32 i = 0; i < numRects; i++)
+			update(rects[i]);
+	}
+
 	virtual void setSize(const PPSize& size) { this->size = size; }
 	virtual const PPSize& getSize() const { return this->size; }
 
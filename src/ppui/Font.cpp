@@ -1585,6 +1585,9 @@ PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeig
 
 	bitstream = new Bitstream(fontBits, 0);
 
+	glyphRows = new pp_uint32[256*charHeight];
+	buildGlyphRows();
+
 	this->fontId = fontId;
 
 	fontInstances[numFontInstances++] = this;
@@ -1592,9 +1595,25 @@ PPFont::PPFont(pp_uint8* bits, const pp_uint32 chrWidth, const pp_uint32 chrHeig
 
 PPFont::~PPFont()
 {
+	delete[] glyphRows;
 	delete bitstream;
 }
 
+void PPFont::buildGlyphRows()
+{
+	// the framebuffer graphics draw characters from these instead
+	// of picking the bits out of the bitstream one by one
+	for (pp_uint32 chr = 0; chr < 256; chr++)
+		for (pp_uint32 y = 0; y < charHeight; y++)
+		{
+			pp_uint32 mask = 0;
+			for (pp_uint32 x = 0; x < charWidth; x++)
+				if (getPixelBit((pp_uint8)chr, x, y))
+					mask |= 1 << x;
+			glyphRows[chr*charHeight+y] = mask;
+		}
+}
+
 PPFont* PPFont::getFont(pp_uint32 fontId)
 {
 	pp_uint32 i;
@@ -1770,6 +1789,7 @@ void PPFont::selectFontFace(FontID fontID, const char* faceName)
 				fontInstances[j]->fontBits = (pp_uint8*)fontEntries[i].data;
 				fontInstances[j]->bitstream->setSource(fontInstances[j]->fontBits, fontEntries[i].width*fontEntries[i].height / 8);
 			}
+			fontInstances[j]->buildGlyphRows();
 		}
 }
 
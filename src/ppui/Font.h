@@ -114,11 +114,16 @@ private:
 	
 	static void createLargeFromSystem(pp_uint32 index);
 
+	void buildGlyphRows();
+
 public:
 
 	pp_uint8* fontBits;
 	Bitstream* bitstream;
 
+	// one bit mask per character line, bit x is pixel x
+	pp_uint32* glyphRows;
+
 	const pp_uint32 charWidth, charHeight;
 	const pp_uint32 charDim;
 
@@ -132,6 +137,8 @@ public:
 
 	bool getPixelBit(pp_uint8 chr, pp_uint32 x, pp_uint32 y) const { return bitstream->read(chr*charDim+y*charWidth+x); }
 
+	const pp_uint32* getGlyphRows(pp_uint8 chr) const { return glyphRows + chr*charHeight; }
+
 	pp_uint32 getStrWidth(const char* str) const;
 	
 	enum ShrinkTypes
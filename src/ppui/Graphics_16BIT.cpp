@@ -75,7 +75,11 @@ void PPGraphics_16BIT::fill(PPRect rect)
 	pp_uint16* dest = (pp_uint16*)buffer+hPitch*rect.y1+rect.x1;
 
 	const pp_int32 width = rect.x2 - rect.x1;
-	const pp_int32 height = rect.y2 - rect.y1; 
+	const pp_int32 height = rect.y2 - rect.y1;
+
+	if (width <= 0)
+		return;
+ 
 	
 	const pp_int16 color16 = this->color16;
 	
@@ -309,28 +313,24 @@ void PPGraphics_16BIT::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool under
 	pp_uint16* buff = (pp_uint16*)buffer+(pitch>>1)*y+x;	
 	
 	const pp_uint32 cchrDim = chr*charDim;
-	const pp_uint32 incr = (pitch>>1)-(charWidth);
 
 	if (x>= currentClipRect.x1 && x + charWidth < currentClipRect.x2 &&
 		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
 	{
 		
-		pp_uint32 yChr = cchrDim;
+		const pp_uint32* glyphRows = currentFont->getGlyphRows(chr);
 		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_uint16* dst = buff;
+			for (pp_uint32 bits = glyphRows[i]; bits; bits >>= 1)
 			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
+				if (bits & 1)
 				{
-					*buff = color16;
+					*dst = color16;
 				}
-				buff++;
-				xChr++;
+				dst++;
 			}
-			
-			buff+=incr;
-			yChr+=charWidth;
+			buff+=pitch>>1;
 		}
 	}
 	else
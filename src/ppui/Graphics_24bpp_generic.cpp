@@ -30,6 +30,7 @@
 
 #include "Graphics.h"
 #include "Font.h"
+#include "fastfill.h"
 
 #define BPP 3
 
@@ -102,30 +103,19 @@ void PPGraphics_24bpp_generic::fill(PPRect rect)
 	
 	pp_int32 len = (rect.x2-rect.x1); 
 
+	if (len <= 0)
+		return;
+
 	pp_uint8* buff = (pp_uint8*)buffer+(pitch*rect.y1+rect.x1*BPP); 
 	
 	for (pp_int32 y = rect.y1; y < rect.y2; y++)
 	{				
-		pp_uint8* ptr = buff;
-		
-		pp_int32 i;
-		
-		for (i = 0; i < len; i++)
-		{
 #ifndef __ppc__
-			*ptr = rgb & 255;
-			*(ptr+1) = (rgb >> 8) & 255;
-			*(ptr+2) = (rgb >> 16) & 255;
+		fill_triplet(buff, rgb & 255, (rgb >> 8) & 255, (rgb >> 16) & 255, len);
 #else
-			*ptr = (rgb >> 16) & 255;
-			*(ptr+1) = (rgb >> 8) & 255;
-			*(ptr+2) = rgb & 255;
+		fill_triplet(buff, (rgb >> 16) & 255, (rgb >> 8) & 255, rgb & 255, len);
 #endif
-			ptr+=3;
-		}
-		
 		buff+=pitch;
-		
 	}	
 
 }
@@ -167,22 +157,17 @@ void PPGraphics_24bpp_generic::drawHLine(pp_int32 x1, pp_int32 x2, pp_int32 y)
 		(currentColor.b << bitPosB);
 
 	pp_int32 len = (rx-lx); 
+
+	if (len <= 0)
+		return;
+
 	pp_uint8* buff = (pp_uint8*)buffer+pitch*y+lx*BPP;
 
-	pp_int32 i;		
-	for (i = 0; i < len; i++)
-	{
 #ifndef __ppc__
-		*buff = rgb & 255;
-		*(buff+1) = (rgb >> 8) & 255;
-		*(buff+2) = (rgb >> 16) & 255;
+	fill_triplet(buff, rgb & 255, (rgb >> 8) & 255, (rgb >> 16) & 255, len);
 #else
-		*buff = (rgb >> 16) & 255;
-		*(buff+1) = (rgb >> 8) & 255;
-		*(buff+2) = rgb & 255;
+	fill_triplet(buff, (rgb >> 16) & 255, (rgb >> 8) & 255, rgb & 255, len);
 #endif
-		buff+=3;
-	}
 	
 }
 
@@ -338,29 +323,27 @@ void PPGraphics_24bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bo
 		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
 	{
 		
-		pp_uint32 yChr = cchrDim;
+		const pp_uint32* glyphRows = currentFont->getGlyphRows(chr);
 		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_uint8* dst = buff;
+			for (pp_uint32 bits = glyphRows[i]; bits; bits >>= 1)
 			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
+				if (bits & 1)
 				{
 #ifndef __ppc__
-					buff[0] = rgb & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = (rgb >> 16) & 255;		
+					dst[0] = rgb & 255;
+					dst[1] = (rgb >> 8) & 255;
+					dst[2] = (rgb >> 16) & 255;		
 #else
-					buff[0] = (rgb >> 16) & 255;
-					buff[1] = (rgb >> 8) & 255;
-					buff[2] = rgb & 255;		
+					dst[0] = (rgb >> 16) & 255;
+					dst[1] = (rgb >> 8) & 255;
+					dst[2] = rgb & 255;		
 #endif		
 				}
-				buff+=BPP;
-				xChr++;
+				dst+=BPP;
 			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
+			buff+=pitch;
 		}
 	}
 	else
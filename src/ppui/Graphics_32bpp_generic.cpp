@@ -281,21 +281,19 @@ void PPGraphics_32bpp_generic::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bo
 	{
 		pp_uint8* buff = (pp_uint8*)buffer + y*pitch + x*BPP;
 		
-		pp_uint32 yChr = cchrDim;
-		for (pp_uint32 i = 0; i < charHeight; i++)
+		const pp_uint32* glyphRows = currentFont->getGlyphRows(chr);
+		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < charWidth; j++)
+			pp_uint8* dst = buff;
+			for (pp_uint32 bits = glyphRows[i]; bits; bits >>= 1)
 			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
+				if (bits & 1)
 				{
-					*reinterpret_cast<pp_uint32*>(buff) = rgb1;
+					*reinterpret_cast<pp_uint32*>(dst) = rgb1;
 				}
-				buff+=BPP;
-				xChr++;
+				dst+=BPP;
 			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
+			buff+=pitch;
 		}
 	}
 	else
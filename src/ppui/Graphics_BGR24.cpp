@@ -22,6 +22,7 @@
 
 #include "Graphics.h"
 #include "Font.h"
+#include "fastfill.h"
 
 #define BPP 3
 
@@ -75,56 +76,21 @@ void PPGraphics_BGR24::fill(PPRect rect)
 	if (rect.x2 > currentClipRect.x2)
 		rect.x2 = currentClipRect.x2;
 
+	pp_int32 len = rect.x2-rect.x1;
+
+	if (len <= 0)
+		return;
+
 	pp_uint8 r = (pp_uint8)currentColor.r;
 	pp_uint8 g = (pp_uint8)currentColor.g;
 	pp_uint8 b = (pp_uint8)currentColor.b;
 
-	pp_uint32 rgb1 = (((pp_uint32)currentColor.b) << 24) +
-		(((pp_uint32)r) << 16) +
-		(((pp_uint32)g) << 8) +
-		(((pp_uint32)b));
-	
-	pp_uint32 rgb2 = (((pp_uint32)currentColor.g) << 24) +
-		(((pp_uint32)b) << 16) +
-		(((pp_uint32)r) << 8) +
-		(((pp_uint32)g));
-	
-	pp_uint32 rgb3 = (((pp_uint32)currentColor.r) << 24) +
-		(((pp_uint32)g) << 16) +
-		(((pp_uint32)b) << 8) +
-		(((pp_uint32)r));
-
-	pp_int32 realLen = (rect.x2-rect.x1)*BPP; 
-	pp_int32 len = realLen/12;
-	pp_int32 remainder = (((rect.x2-rect.x1)*BPP)%12) / 3;
-
 	pp_uint8* buff = (pp_uint8*)buffer+(pitch*rect.y1+rect.x1*BPP); 
 	
 	for (pp_int32 y = rect.y1; y < rect.y2; y++)
 	{				
-		pp_uint32* ptr = reinterpret_cast<pp_uint32*>(buff);
-		
-		pp_int32 i;
-		
-		for (i = 0; i < len; i++)
-		{
-			*ptr = rgb1;
-			*(ptr+1) = rgb2;
-			*(ptr+2) = rgb3;
-			ptr+=3;
-		}
-		
-		buff = reinterpret_cast<pp_uint8*>(ptr);
-		
-		for (i = 0; i < remainder; i++)
-		{
-			*buff++ = (pp_uint8)b;
-			*buff++ = (pp_uint8)g;
-			*buff++ = (pp_uint8)r;		
-		}
-
-		buff+=(pitch - realLen);
-		
+		fill_triplet(buff, b, g, r, len);
+		buff+=pitch;
 	}	
 
 }
@@ -161,45 +127,14 @@ void PPGraphics_BGR24::drawHLine(pp_int32 x1, pp_int32 x2, pp_int32 y)
 	if (y >= currentClipRect.y2)
 		return;
 
-	pp_uint8* buff = (pp_uint8*)buffer+pitch*y+lx*BPP;
-
-	pp_int32 len = ((rx-lx)*BPP)/12;
-	pp_int32 remainder = (((rx-lx)*BPP)%12) / 3;
+	pp_int32 len = rx-lx;
 
-	pp_uint32 rgb1 = (((pp_uint32)currentColor.b) << 24) +
-					 (((pp_uint32)currentColor.r) << 16) +
-					 (((pp_uint32)currentColor.g) << 8) +
-					 (((pp_uint32)currentColor.b));
-
-	pp_uint32 rgb2 = (((pp_uint32)currentColor.g) << 24) +
-					 (((pp_uint32)currentColor.b) << 16) +
-					 (((pp_uint32)currentColor.r) << 8) +
-					 (((pp_uint32)currentColor.g));
-
-	pp_uint32 rgb3 = (((pp_uint32)currentColor.r) << 24) +
-					 (((pp_uint32)currentColor.g) << 16) +
-					 (((pp_uint32)currentColor.b) << 8) +
-					 (((pp_uint32)currentColor.r));
-
-	pp_uint32* ptr = reinterpret_cast<pp_uint32*>(buff);
-
-	pp_int32 i;
-
-	for (i = 0; i < len; i++)
-	{
-		*ptr++ = rgb1;
-		*ptr++ = rgb2;
-		*ptr++ = rgb3;
-	}
+	if (len <= 0)
+		return;
 
-	buff = reinterpret_cast<pp_uint8*>(ptr);
+	pp_uint8* buff = (pp_uint8*)buffer+pitch*y+lx*BPP;
 
-	for (i = 0; i < remainder; i++)
-	{
-		*buff++ = (pp_uint8)currentColor.b;
-		*buff++ = (pp_uint8)currentColor.g;
-		*buff++ = (pp_uint8)currentColor.r;		
-	}
+	fill_triplet(buff, (pp_uint8)currentColor.b, (pp_uint8)currentColor.g, (pp_uint8)currentColor.r, len);
 
 }
 
@@ -370,23 +305,21 @@ void PPGraphics_BGR24::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool under
 		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
 	{
 		
-		pp_uint32 yChr = cchrDim;
+		const pp_uint32* glyphRows = currentFont->getGlyphRows(chr);
 		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_uint8* dst = buff;
+			for (pp_uint32 bits = glyphRows[i]; bits; bits >>= 1)
 			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
+				if (bits & 1)
 				{
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;
+					dst[0] = b;
+					dst[1] = g;
+					dst[2] = r;
 				}
-				buff+=BPP;
-				xChr++;
+				dst+=BPP;
 			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
+			buff+=pitch;
 		}
 	}
 	else
@@ -323,23 +323,21 @@ void PPGraphics_BGR24_SLOW::drawChar(pp_uint8 chr, pp_int32 x, pp_int32 y, bool
 		y>= currentClipRect.y1 && y + charHeight < currentClipRect.y2)
 	{
 		
-		pp_uint32 yChr = cchrDim;
+		const pp_uint32* glyphRows = currentFont->getGlyphRows(chr);
 		for (pp_uint32 i = 0; i < (unsigned)charHeight; i++)
 		{
-			pp_uint32 xChr = yChr;
-			for (pp_uint32 j = 0; j < (unsigned)charWidth; j++)
+			pp_uint8* dst = buff;
+			for (pp_uint32 bits = glyphRows[i]; bits; bits >>= 1)
 			{
-				if ((fontbuffer[xChr>>3]>>(xChr&7)&1))
+				if (bits & 1)
 				{
-					buff[0] = b;
-					buff[1] = g;
-					buff[2] = r;
+					dst[0] = b;
+					dst[1] = g;
+					dst[2] = r;
 				}
-				buff+=BPP;
-				xChr++;
+				dst+=BPP;
 			}
-			buff+=pitch-(charWidth*BPP);
-			yChr+=charWidth;
+			buff+=pitch;
 		}
 	}
 	else
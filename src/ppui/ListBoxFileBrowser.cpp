@@ -39,7 +39,8 @@ PPListBoxFileBrowser::PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen,
 	directoryPrefix("<DIR>  "), directorySuffix(""),
 	sortAscending(true),
 	cycleFilenames(true),
-	sortType(SortByName)
+	sortType(SortByName),
+	fileInfoProvider(NULL)
 {
 	setRightButtonConfirm(true);
 	currentPath = PPPathFactory::createPath();
@@ -100,6 +101,15 @@ void PPListBoxFileBrowser::refreshFiles()
 	iterateFilesInFolder();
 }
 
+void PPListBoxFileBrowser::refreshFileInfo()
+{
+	if (PPListBox::getNumItems() != pathEntries.size())
+		return;
+
+	for (pp_int32 i = 0; i < pathEntries.size(); i++)
+		PPListBox::updateItem(i, getFileListItem(*pathEntries.get(i)));
+}
+
 const PPPathEntry* PPListBoxFileBrowser::getPathEntry(pp_int32 index) const
 {
 	return pathEntries.get(index);
@@ -288,18 +298,30 @@ void PPListBoxFileBrowser::buildFileList()
 	PPListBox::clear();
 	
 	for (pp_int32 i = 0; i < pathEntries.size(); i++)
+		PPListBox::addItem(getFileListItem(*pathEntries.get(i)));
+}
+
+PPString PPListBoxFileBrowser::getFileListItem(const PPPathEntry& entry)
+{
+	char* nameASCIIZ = entry.getName().toASCIIZ();
+	PPString str(entry.isDirectory() ? directoryPrefix : filePrefix);
+	str.append(nameASCIIZ);
+	str.append(entry.isDirectory() ? directorySuffix : fileSuffix);
+	delete[] nameASCIIZ;
+	
+	appendFileSize(str, entry);
+	
+	if (fileInfoProvider && entry.isFile())
 	{
-		const PPPathEntry* entry = pathEntries.get(i);
-		char* nameASCIIZ = entry->getName().toASCIIZ();
-		PPString str(entry->isDirectory() ? directoryPrefix : filePrefix);
-		str.append(nameASCIIZ);
-		str.append(entry->isDirectory() ? directorySuffix : fileSuffix);
-		
-		appendFileSize(str, *entry);
+		PPSystemString fileFullPath = getCurrentPathAsString();
+		fileFullPath.append(entry.getName());
 		
-		PPListBox::addItem(str);
-		delete[] nameASCIIZ;
+		PPString info;
+		if (fileInfoProvider->getFileInfo(fileFullPath, info))
+			str.append(info);
 	}
+	
+	return str;
 }
 
 void PPListBoxFileBrowser::appendFileSize(PPString& name, const PPPathEntry& entry)
@@ -45,6 +45,15 @@ public:
 		NumSortRules
 	};
 
+	// Supplies extra information about files (like the play time of a song)
+	// which is shown after their size. If it's not available yet it can be 
+	// filled in later by calling refreshFileInfo()
+	class FileInfoProvider
+	{
+	public:
+		virtual bool getFileInfo(const PPSystemString& fileFullPath, PPString& info) = 0;
+	};
+
 private:
 	class PPPath* currentPath;
 	PPSystemString* initialPath;
@@ -62,6 +71,8 @@ private:
 
 	SortTypes sortType;
 
+	FileInfoProvider* fileInfoProvider;
+
 public:
 	PPListBoxFileBrowser(pp_int32 id, PPScreen* parentScreen, EventListenerInterface* eventListener, 
 						 const PPPoint& location, const PPSize& size);
@@ -73,6 +84,10 @@ public:
 	virtual bool receiveTimerEvent() const { return false; }	
 	
 	void refreshFiles();
+	// updates the entries without reading the folder again
+	void refreshFileInfo();
+	
+	void setFileInfoProvider(FileInfoProvider* provider) { fileInfoProvider = provider; }
 	
 	void setSortAscending(bool sortAscending) { this->sortAscending = sortAscending; }
 	void setCycleFilenames(bool cycleFilenames) { this->cycleFilenames = cycleFilenames; }
@@ -124,6 +139,7 @@ public:
 private:
 	void iterateFilesInFolder();
 	void buildFileList();
+	PPString getFileListItem(const PPPathEntry& entry);
 	void sortFileList();
 	void cycle(char chr);
 	static void appendFileSize(PPString& name, const PPPathEntry& entry);
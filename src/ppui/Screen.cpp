@@ -56,10 +56,15 @@ PPScreen::PPScreen(PPDisplayDeviceBase* displayDevice, EventListenerInterface* e
 	modalControl(NULL),
 	showDragHilite(false),
 	rootContainer(NULL),
-	lastMouseOverControl(NULL)
+	lastMouseOverControl(NULL),
+	eventDepth(0),
+	deferUpdates(false),
+	numDirtyRects(0),
+	fullUpdatePending(false)
 {
 	contextMenuControls = new PPSimpleVector<PPControl>(16, false);
 	timerEventControls = new PPSimpleVector<PPControl>(16, false);
+	pendingPaintControls = new PPSimpleVector<PPControl>(16, false);
 	
 	rootContainer = new PPTransparentContainer(-1, this, eventListener, 
 											   PPPoint(0, 0), 
@@ -70,6 +75,7 @@ PPScreen::~PPScreen()
 {
 	delete contextMenuControls;
 	delete timerEventControls;
+	delete pendingPaintControls;
 }
 
 void PPScreen::adjustEventMouseCoordinates(PPEvent* event)
@@ -89,6 +95,17 @@ void PPScreen::adjustEventMouseCoordinates(PPEvent* event)
 }
 
 void PPScreen::raiseEvent(PPEvent* event)
+{
+	eventDepth++;
+	routeEvent(event);
+	eventDepth--;
+	
+	// also when nested: modal loops dispatch events from within an event
+	if (!deferUpdates)
+		flushUpdates();
+}
+
+void PPScreen::routeEvent(PPEvent* event)
 {
 	if (event->isMouseEvent())
 		adjustEventMouseCoordinates(event);
@@ -331,8 +348,16 @@ void PPScreen::paint(bool update/*= true*/, bool clean/*=false*/)
 
 	displayDevice->close();
 	
+	// everything has been painted
+	pendingPaintControls->clear();
+	
 	if (update)
-		displayDevice->update();
+	{
+		if (isCollectingUpdates())
+			fullUpdatePending = true;
+		else
+			displayDevice->update();
+	}
 }
 
 void PPScreen::paintContextMenuControl(PPControl* control, bool update/* = true*/)
@@ -359,22 +384,7 @@ void PPScreen::paintContextMenuControl(PPControl* control, bool update/* = true*
 	displayDevice->close();
 
 	if (update)
-	{
-		PPRect rect = control->getBoundingRect();
-		
-		rect.x1--;
-		if (rect.x1 < 0) rect.x1 = 0;
-		rect.y1--;
-		if (rect.y1 < 0) rect.y1 = 0;
-
-		rect.x2++;
-		if (rect.x2 > getWidth()) rect.x2 = getWidth();
-		rect.y2++;
-		if (rect.y2 > getHeight()) rect.y2 = getHeight();
-		
-		displayDevice->update(rect);
-	}
-
+		updateControl(control);
 }
 
 void PPScreen::paintControl(PPControl* control, bool update/*= true*/)
@@ -382,10 +392,39 @@ void PPScreen::paintControl(PPControl* control, bool update/*= true*/)
 	if (displayDevice == NULL || !control->isVisible())
 		return;
 
+	// paint it when the event has been handled, only once if it's asked for repeatedly
+	if (isCollectingUpdates() && update)
+	{
+		for (pp_int32 i = 0; i < pendingPaintControls->size(); i++)
+		{
+			if (pendingPaintControls->get(i) == control)
+			{
+				pendingPaintControls->removeNoDestroy(i);
+				break;
+			}
+		}
+		
+		pendingPaintControls->add(control);
+		return;
+	}
+
 	PPGraphicsAbstract* g = displayDevice->open();
 	if (!g)
 		return;
 
+	control = paintControlInternal(g, control);
+
+	displayDevice->close();
+
+	if (update && control)
+	{
+		updateControl(control);
+	}
+
+}
+
+PPControl* PPScreen::paintControlInternal(PPGraphicsAbstract* g, PPControl* control)
+{
 	// modal control overlapping everything
 	if (modalControl && modalControl->isVisible() &&
 		modalControl->getLocation().x == 0 &&
@@ -412,7 +451,7 @@ void PPScreen::paintControl(PPControl* control, bool update/*= true*/)
 		}
 		
 		if (!isModalControlChild)
-			return;
+			return NULL;
 	}
 	
 	control->paint(g);	
@@ -444,14 +483,8 @@ void PPScreen::paintControl(PPControl* control, bool update/*= true*/)
 		if (modalControl->getBoundingRect().intersect(control->getBoundingRect()))
 			modalControl->paint(g);
 	}
-
-	displayDevice->close();
-
-	if (update)
-	{
-		updateControl(control);
-	}
-
+	
+	return control;
 }
 
 void PPScreen::paintSplash(const pp_uint8* rawData, pp_uint32 width, pp_uint32 height, pp_uint32 pitch, pp_uint32 bpp, pp_int32 intensity/* = 256*/)
@@ -475,8 +508,19 @@ void PPScreen::paintSplash(const pp_uint8* rawData, pp_uint32 width, pp_uint32 h
 
 void PPScreen::update()
 {
+	if (deferUpdates)
+	{
+		fullUpdatePending = true;
+		return;
+	}
+
 	if (displayDevice) 
 	{
+		// whatever is still pending has been asked for, show it now
+		paintPendingControls();
+		numDirtyRects = 0;
+		fullUpdatePending = false;
+
 		if (showDragHilite)
 		{
 			PPGraphicsAbstract* g = displayDevice->open();
@@ -487,7 +531,7 @@ void PPScreen::update()
 	}
 }
 
-void PPScreen::updateControl(PPControl* control)
+PPRect PPScreen::getUpdateRect(PPControl* control) const
 {
 	PPRect rect = control->getBoundingRect();
 	
@@ -501,7 +545,173 @@ void PPScreen::updateControl(PPControl* control)
 	rect.y2++;
 	if (rect.y2 > getHeight()) rect.y2 = getHeight();
 	
-	displayDevice->update(rect);
+	return rect;
+}
+
+void PPScreen::updateControl(PPControl* control)
+{
+	PPRect rect = getUpdateRect(control);
+	
+	if (isCollectingUpdates())
+		addDirtyRect(rect);
+	else
+		displayDevice->update(rect);
+}
+
+static bool isControlInContainer(PPContainer* container, PPControl* control)
+{
+	PPSimpleVector<PPControl>& controls = container->getControls();
+	
+	for (pp_int32 i = 0; i < controls.size(); i++)
+	{
+		PPControl* ctrl = controls.get(i);
+		if (ctrl == control)
+			return true;
+		
+		if (ctrl->isContainer() && isControlInContainer(static_cast<PPContainer*>(ctrl), control))
+			return true;
+	}
+	
+	return false;
+}
+
+bool PPScreen::isAttached(PPControl* control) const
+{
+	// controls may have been removed and destroyed since they asked
+	// to be painted, only pointers are compared here
+	if (control == rootContainer || control == modalControl)
+		return true;
+
+	if (isControlInContainer(rootContainer, control))
+		return true;
+
+	if (modalControl && modalControl->isContainer() &&
+		isControlInContainer(static_cast<PPContainer*>(modalControl), control))
+		return true;
+
+	for (pp_int32 i = 0; i < contextMenuControls->size(); i++)
+	{
+		PPControl* ctrl = contextMenuControls->get(i);
+		if (ctrl == control)
+			return true;
+		
+		if (ctrl->isContainer() && isControlInContainer(static_cast<PPContainer*>(ctrl), control))
+			return true;
+	}
+	
+	return false;
+}
+
+void PPScreen::addDirtyRect(const PPRect& rect)
+{
+	if (fullUpdatePending || rect.width() <= 0 || rect.height() <= 0)
+		return;
+
+	PPRect r = rect;
+	
+	// merge with everything it touches, merged rects may touch others
+	bool merged = true;
+	while (merged)
+	{
+		merged = false;
+		for (pp_int32 i = 0; i < numDirtyRects; i++)
+		{
+			const PPRect& d = dirtyRects[i];
+			if (!d.intersect(r))
+				continue;
+			
+			if (d.x1 < r.x1) r.x1 = d.x1;
+			if (d.y1 < r.y1) r.y1 = d.y1;
+			if (d.x2 > r.x2) r.x2 = d.x2;
+			if (d.y2 > r.y2) r.y2 = d.y2;
+			
+			dirtyRects[i] = dirtyRects[--numDirtyRects];
+			merged = true;
+			break;
+		}
+	}
+	
+	if (numDirtyRects == MAXDIRTYRECTS)
+	{
+		// too scattered, just take the bounding box
+		for (pp_int32 i = 0; i < numDirtyRects; i++)
+		{
+			const PPRect& d = dirtyRects[i];
+			if (d.x1 < r.x1) r.x1 = d.x1;
+			if (d.y1 < r.y1) r.y1 = d.y1;
+			if (d.x2 > r.x2) r.x2 = d.x2;
+			if (d.y2 > r.y2) r.y2 = d.y2;
+		}
+		numDirtyRects = 0;
+	}
+	
+	dirtyRects[numDirtyRects++] = r;
+}
+
+void PPScreen::paintPendingControls()
+{
+	if (!pendingPaintControls->size())
+		return;
+	
+	PPGraphicsAbstract* g = displayDevice->open();
+	if (!g)
+	{
+		pendingPaintControls->clear();
+		return;
+	}
+
+	for (pp_int32 i = 0; i < pendingPaintControls->size(); i++)
+	{
+		PPControl* control = pendingPaintControls->get(i);
+		
+		if (!isAttached(control) || !control->isVisible())
+			continue;
+		
+		control = paintControlInternal(g, control);
+		if (control)
+			addDirtyRect(getUpdateRect(control));
+	}
+	
+	displayDevice->close();
+	
+	pendingPaintControls->clear();
+}
+
+void PPScreen::flushUpdates()
+{
+	if (displayDevice == NULL)
+		return;
+
+	paintPendingControls();
+	
+	if (!fullUpdatePending && !numDirtyRects)
+		return;
+	
+	if (showDragHilite)
+	{
+		PPGraphicsAbstract* g = displayDevice->open();
+		if (g)
+		{
+			paintDragHighlite(g);		
+			displayDevice->close();
+		}
+	}
+	
+	if (fullUpdatePending)
+		displayDevice->update();
+	else
+		displayDevice->updateRects(dirtyRects, numDirtyRects);
+	
+	numDirtyRects = 0;
+	fullUpdatePending = false;
+}
+
+void PPScreen::setDeferredUpdates(bool deferUpdates)
+{
+	this->deferUpdates = deferUpdates;
+	
+	if (!deferUpdates)
+		flushUpdates();
 }
 
 void PPScreen::setFocus(PPControl* control, bool repaint/* = true*/)
@@ -648,7 +858,12 @@ void PPScreen::setModalControl(PPControl* control, bool repaint/* = true*/)
 	modalControl = control; 
 	
 	if (repaint)
+	{
 		paint(); 
+		// a modal loop might be waiting for input before the event returns
+		if (!deferUpdates)
+			flushUpdates();
+	}
 }
 
 
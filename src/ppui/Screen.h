@@ -73,10 +73,37 @@ private:
 	PPPoint lastMousePoint;
 	PPControl* lastMouseOverControl;
 	
+	// While an event is being dispatched, controls asking to be painted
+	// are collected and painted once when the event has been handled.
+	// The damaged areas are presented together in a single update.
+	// With deferred updates that's left to the platform's frame clock,
+	// which calls flushUpdates() once per frame.
+	enum
+	{
+		MAXDIRTYRECTS = 16
+	};
+
+	pp_int32 eventDepth;
+	bool deferUpdates;
+	PPSimpleVector<PPControl>* pendingPaintControls;
+	PPRect dirtyRects[MAXDIRTYRECTS];
+	pp_int32 numDirtyRects;
+	bool fullUpdatePending;
+
 	void paintDragHighlite(PPGraphicsAbstract* g);
 
 	void adjustEventMouseCoordinates(PPEvent* event);
 
+	void routeEvent(PPEvent* event);
+
+	PPControl* paintControlInternal(PPGraphicsAbstract* g, PPControl* control);
+	PPRect getUpdateRect(PPControl* control) const;
+	bool isAttached(PPControl* control) const;
+
+	bool isCollectingUpdates() const { return eventDepth || deferUpdates; }
+	void addDirtyRect(const PPRect& rect);
+	void paintPendingControls();
+
 public:
 	PPScreen(PPDisplayDeviceBase* displayDevice, EventListenerInterface* eventListener = NULL);
 
@@ -96,6 +123,13 @@ public:
 	void update();
 	void updateControl(PPControl* control);
 	
+	// paint the controls which have asked for it and present everything
+	// that has been damaged since the last time
+	void flushUpdates();
+	// for platforms presenting at the display refresh: updates are 
+	// collected across events until flushUpdates() is called
+	void setDeferredUpdates(bool deferUpdates);
+
 	void pauseUpdate(bool pause);
 	void enableDisplay(bool enable);
 	bool isDisplayEnabled();
@@ -28,6 +28,14 @@
  *
  */
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FASTFILL_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FASTFILL_NEON
+#include <arm_neon.h>
+#endif
+
 #ifdef __GNUC__
 static __attribute__((noinline)) void fill_dword(pp_uint32* buff, pp_uint32 dw, pp_uint32 len)
 #else
@@ -64,6 +72,43 @@ static inline void fill_dword(pp_uint32* buff, pp_uint32 dw, pp_uint32 len)
 				 "addi r3,r3,4\n"		// advance by 4
 				 "cmpw cr7,r11,r9\n"
 				 "bne cr7,1b"); 
+#elif defined(FASTFILL_SSE2) || defined(FASTFILL_NEON)
+	// single stores until the destination is 16 byte aligned
+	while (len && (reinterpret_cast<size_t>(buff) & 15))
+	{
+		*buff++ = dw;
+		len--;
+	}
+
+#ifdef FASTFILL_SSE2
+	const __m128i v = _mm_set1_epi32((int)dw);
+#define FASTFILL_STORE(ptr) _mm_store_si128(reinterpret_cast<__m128i*>(ptr), v)
+#else
+	const uint32x4_t v = vdupq_n_u32(dw);
+#define FASTFILL_STORE(ptr) vst1q_u32(ptr, v)
+#endif
+
+	pp_uint32 newlen = len >> 4;
+	while (newlen--)
+	{
+		FASTFILL_STORE(buff);
+		FASTFILL_STORE(buff+4);
+		FASTFILL_STORE(buff+8);
+		FASTFILL_STORE(buff+12);
+		buff+=16;
+	}
+
+	len &= 15;
+	while (len >= 4)
+	{
+		FASTFILL_STORE(buff);
+		buff+=4;
+		len-=4;
+	}
+#undef FASTFILL_STORE
+
+	while (len--)
+		*buff++ = dw;
 #else
 	pp_uint32 newlen = len >> 2;
 	pp_uint32 remlen = len & 3;
@@ -113,3 +158,63 @@ static inline void fill_dword_vertical(pp_uint32* buff, pp_uint32 dw, pp_uint32
 	} while (--len);
 #endif
 }
+
+// Fills len pixels of three bytes each, c0 to c2 are stored in that order
+static inline void fill_triplet(pp_uint8* buff, pp_uint8 c0, pp_uint8 c1, pp_uint8 c2, pp_uint32 len)
+{
+	// 16 pixels make up 48 bytes, that's three vectors or twelve dwords
+	pp_uint32 pattern32[12];
+	pp_uint8* pattern = reinterpret_cast<pp_uint8*>(pattern32);
+	for (pp_uint32 i = 0; i < 48; i+=3)
+	{
+		pattern[i] = c0;
+		pattern[i+1] = c1;
+		pattern[i+2] = c2;
+	}
+
+#if defined(FASTFILL_SSE2)
+	const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+	const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern+16));
+	const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern+32));
+	while (len >= 16)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buff), v0);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buff+16), v1);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(buff+32), v2);
+		buff+=48;
+		len-=16;
+	}
+#elif defined(FASTFILL_NEON)
+	const uint8x16_t v0 = vld1q_u8(pattern);
+	const uint8x16_t v1 = vld1q_u8(pattern+16);
+	const uint8x16_t v2 = vld1q_u8(pattern+32);
+	while (len >= 16)
+	{
+		vst1q_u8(buff, v0);
+		vst1q_u8(buff+16, v1);
+		vst1q_u8(buff+32, v2);
+		buff+=48;
+		len-=16;
+	}
+#endif
+
+	const pp_uint32 dw0 = pattern32[0];
+	const pp_uint32 dw1 = pattern32[1];
+	const pp_uint32 dw2 = pattern32[2];
+	while (len >= 4)
+	{
+		pp_uint32* ptr = reinterpret_cast<pp_uint32*>(buff);
+		*ptr = dw0;
+		*(ptr+1) = dw1;
+		*(ptr+2) = dw2;
+		buff+=12;
+		len-=4;
+	}
+
+	while (len--)
+	{
+		*buff++ = c0;
+		*buff++ = c1;
+		*buff++ = c2;
+	}
+}
@@ -39,6 +39,7 @@
 
 void processSDLEvents(const SDL_Event& event);
 void processSDLUserEvents(const SDL_UserEvent& event);
+bool waitEventOrFrame(SDL_Event* event);
 
 extern PPMutex* globalMutex;
 
@@ -93,7 +94,7 @@ PPModalDialog::ReturnCodes SDL_runModalLoop(PPScreen* screen, PPDialogBase* dial
 		globalMutex->unlock();
 
 	// Create our own event loop
-	while (!exitModalLoop && SDL_WaitEvent(&event)) 
+	while (!exitModalLoop && waitEventOrFrame(&event)) 
 	{
 		switch (event.type) 
 		{
@@ -31,6 +31,101 @@
 #include "DisplayDeviceFB_SDL.h"
 #include "Graphics.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SCALE_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SCALE_NEON
+#include <arm_neon.h>
+#endif
+
+// Nearest neighbour scaling of a line of pixels by an integer factor
+static void scaleRow(const pp_uint8* src, pp_uint8* dst, pp_int32 width, pp_uint32 bytesPerPixel, pp_int32 scale)
+{
+	for (pp_int32 x = 0; x < width; x++)
+	{
+		for (pp_int32 i = 0; i < scale; i++)
+		{
+			for (pp_uint32 j = 0; j < bytesPerPixel; j++)
+				dst[j] = src[j];
+			dst+=bytesPerPixel;
+		}
+		src+=bytesPerPixel;
+	}
+}
+
+static void scaleRow32(const pp_uint32* src, pp_uint32* dst, pp_int32 width, pp_int32 scale)
+{
+#if defined(SCALE_SSE2)
+	switch (scale)
+	{
+		case 2:
+			for (; width >= 4; width-=4, src+=4, dst+=8)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi32(v, v));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+4), _mm_unpackhi_epi32(v, v));
+			}
+			break;
+		case 3:
+			for (; width >= 4; width-=4, src+=4, dst+=12)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi32(v, _MM_SHUFFLE(1,0,0,0)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,1,1)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,2)));
+			}
+			break;
+		case 4:
+			for (; width >= 4; width-=4, src+=4, dst+=16)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_shuffle_epi32(v, _MM_SHUFFLE(0,0,0,0)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+4), _mm_shuffle_epi32(v, _MM_SHUFFLE(1,1,1,1)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+8), _mm_shuffle_epi32(v, _MM_SHUFFLE(2,2,2,2)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst+12), _mm_shuffle_epi32(v, _MM_SHUFFLE(3,3,3,3)));
+			}
+			break;
+	}
+#elif defined(SCALE_NEON)
+	// interleaving stores of the same vector repeat every pixel
+	switch (scale)
+	{
+		case 2:
+			for (; width >= 4; width-=4, src+=4, dst+=8)
+			{
+				uint32x4_t v = vld1q_u32(src);
+				uint32x4x2_t p = { { v, v } };
+				vst2q_u32(dst, p);
+			}
+			break;
+		case 3:
+			for (; width >= 4; width-=4, src+=4, dst+=12)
+			{
+				uint32x4_t v = vld1q_u32(src);
+				uint32x4x3_t p = { { v, v, v } };
+				vst3q_u32(dst, p);
+			}
+			break;
+		case 4:
+			for (; width >= 4; width-=4, src+=4, dst+=16)
+			{
+				uint32x4_t v = vld1q_u32(src);
+				uint32x4x4_t p = { { v, v, v, v } };
+				vst4q_u32(dst, p);
+			}
+			break;
+	}
+#endif
+
+	for (; width > 0; width--)
+	{
+		const pp_uint32 pixel = *src++;
+		for (pp_int32 i = 0; i < scale; i++)
+			*dst++ = pixel;
+	}
+}
+
 PPDisplayDeviceFB::PPDisplayDeviceFB(pp_int32 width,
 									 pp_int32 height, 
 									 pp_int32 scaleFactor,
@@ -56,8 +151,8 @@ PPDisplayDeviceFB::PPDisplayDeviceFB(pp_int32 width,
 		exit(EXIT_FAILURE);
 	}
 	
-	// Create renderer for the window
-	theRenderer = SDL_CreateRenderer(theWindow, -1, 0);
+	// Create renderer for the window, presents are synced to the display refresh
+	theRenderer = SDL_CreateRenderer(theWindow, -1, SDL_RENDERER_PRESENTVSYNC);
 	if (theRenderer == NULL)
 	{
 		fprintf(stderr, "SDL: SDL_CreateRenderer failed: %s\n", SDL_GetError());
@@ -224,9 +319,7 @@ void PPDisplayDeviceFB::update()
 	
 	// Update entire texture and copy to renderer
 	SDL_UpdateTexture(theTexture, NULL, theSurface->pixels, theSurface->pitch);
-	SDL_RenderClear(theRenderer);
-	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
-	SDL_RenderPresent(theRenderer);
+	present();
 }
 
 void PPDisplayDeviceFB::update(const PPRect& r)
@@ -239,6 +332,28 @@ void PPDisplayDeviceFB::update(const PPRect& r)
 		return;
 	}
 
+	updateTexture(r);
+	present();
+}
+
+void PPDisplayDeviceFB::updateRects(const PPRect* rects, pp_int32 numRects)
+{
+	if (!isUpdateAllowed() || !isEnabled())
+		return;
+	
+	if (theSurface->locked || !numRects)
+	{
+		return;
+	}
+
+	for (pp_int32 i = 0; i < numRects; i++)
+		updateTexture(rects[i]);
+
+	present();
+}
+
+void PPDisplayDeviceFB::updateTexture(const PPRect& r)
+{
 	swap(r);
 	
 	PPRect r2(r);
@@ -251,8 +366,12 @@ void PPDisplayDeviceFB::update(const PPRect& r)
 	// Calculate destination pixel data offset based on row pitch and x coordinate
 	void* surfaceOffset = (char*) theSurface->pixels + r2.y1 * theSurface->pitch + r2.x1 * theSurface->format->BytesPerPixel;
 	
-	// Update dirty area of texture and copy to renderer
+	// Update dirty area of texture
 	SDL_UpdateTexture(theTexture, &r3, surfaceOffset, theSurface->pitch);
+}
+
+void PPDisplayDeviceFB::present()
+{
 	SDL_RenderClear(theRenderer);
 	SDL_RenderCopy(theRenderer, theTexture, NULL, NULL);
 	SDL_RenderPresent(theRenderer);
@@ -280,106 +399,32 @@ void PPDisplayDeviceFB::swap(const PPRect& r2)
 			
 			if (SDL_LockSurface(theSurface) < 0)
 				return;
-						
-			const pp_uint32 srcBPP = temporaryBufferBPP/8;
-			const pp_uint32 dstBPP = theSurface->format->BytesPerPixel;
 
-			PPRect destRect(r);		
-			destRect.scale(scaleFactor);
+			const pp_uint32 bytesPerPixel = temporaryBufferBPP/8;
 
-			const pp_uint32 stepU = (r.x2 - r.x1) * 65536 / (destRect.x2 - destRect.x1);
-			const pp_uint32 stepV = (r.y2 - r.y1) * 65536 / (destRect.y2 - destRect.y1);
-			
-			switch (temporaryBufferBPP)
+			if (bytesPerPixel < 2 || bytesPerPixel > 4)
 			{
-				case 16:
-				{
-					pp_uint32 srcPitch = temporaryBufferPitch;
-					pp_uint32 dstPitch = theSurface->pitch;
-					
-					pp_uint8* src = (pp_uint8*)temporaryBuffer; 
-					pp_uint8* dst = (pp_uint8*)theSurface->pixels;
-
-					pp_uint32 v = r.y1 * 65536;
-					for (pp_uint32 y = destRect.y1; y < destRect.y2; y++)
-					{
-						pp_uint32 u = r.x1 * 65536;
-						pp_uint16* dstPtr = (pp_uint16*)(dst + y*dstPitch + destRect.x1*dstBPP);
-						pp_uint8* srcPtr = src + (v>>16)*srcPitch;
-						for (pp_uint32 x = destRect.x1; x < destRect.x2; x++)
-						{
-							*dstPtr++ = *(pp_uint16*)(srcPtr + (u>>16) * srcBPP);
-							u += stepU;
-						}
-						v += stepV;
-					}
-
-					
-					break;
-				}
-
-				case 24:
-				{
-					pp_uint32 srcPitch = temporaryBufferPitch;
-					pp_uint32 dstPitch = theSurface->pitch;
-					
-					pp_uint8* src = (pp_uint8*)temporaryBuffer; 
-					pp_uint8* dst = (pp_uint8*)theSurface->pixels;
-					
-					const pp_uint32 srcBPP = temporaryBufferBPP/8;
-					const pp_uint32 dstBPP = theSurface->format->BytesPerPixel;
+				fprintf(stderr, "SDL: Unsupported color depth for requested orientation");
+				exit(2);
+			}
 
-					pp_uint32 v = r.y1 * 65536;
-					for (pp_uint32 y = destRect.y1; y < destRect.y2; y++)
-					{
-						pp_uint32 u = r.x1 * 65536;
-						pp_uint8* dstPtr = (pp_uint8*)(dst + y*dstPitch + destRect.x1*dstBPP);
-						pp_uint8* srcPtr = src + (v>>16)*srcPitch;
-						for (pp_uint32 x = destRect.x1; x < destRect.x2; x++)
-						{
-							*dstPtr = *(pp_uint8*)(srcPtr + (u>>16) * srcBPP);
-							*(dstPtr+1) = *(pp_uint8*)(srcPtr + (u>>16) * srcBPP + 1);
-							*(dstPtr+2) = *(pp_uint8*)(srcPtr + (u>>16) * srcBPP + 2);
-							dstPtr+=3;
-							u += stepU;
-						}
-						v += stepV;
-					}
-																
-					break;
-				}
-				
-				case 32:
-				{
-					pp_uint32 srcPitch = temporaryBufferPitch;
-					pp_uint32 dstPitch = theSurface->pitch;
-					
-					pp_uint8* src = (pp_uint8*)temporaryBuffer; 
-					pp_uint8* dst = (pp_uint8*)theSurface->pixels;
-					
-					const pp_uint32 srcBPP = temporaryBufferBPP/8;
-					const pp_uint32 dstBPP = theSurface->format->BytesPerPixel;
+			const pp_int32 width = r.x2 - r.x1;
+			const pp_uint32 dstPitch = theSurface->pitch;
+			const pp_uint32 rowSize = width * scaleFactor * bytesPerPixel;
 
-					pp_uint32 v = r.y1 * 65536;
-					for (pp_uint32 y = destRect.y1; y < destRect.y2; y++)
-					{
-						pp_uint32 u = r.x1 * 65536;
-						pp_uint32* dstPtr = (pp_uint32*)(dst + y*dstPitch + destRect.x1*dstBPP);
-						pp_uint8* srcPtr = src + (v>>16)*srcPitch;
-						for (pp_uint32 x = destRect.x1; x < destRect.x2; x++)
-						{
-							*dstPtr++ = *(pp_uint32*)(srcPtr + (u>>16) * srcBPP);
-							u += stepU;
-						}
-						v += stepV;
-					}
+			for (pp_int32 y = r.y1; y < r.y2; y++)
+			{
+				const pp_uint8* srcPtr = temporaryBuffer + y*temporaryBufferPitch + r.x1*bytesPerPixel;
+				pp_uint8* dstPtr = (pp_uint8*)theSurface->pixels + y*scaleFactor*dstPitch + r.x1*scaleFactor*bytesPerPixel;
 
-					break;
-				}
+				if (bytesPerPixel == 4)
+					scaleRow32((const pp_uint32*)srcPtr, (pp_uint32*)dstPtr, width, scaleFactor);
+				else
+					scaleRow(srcPtr, dstPtr, width, bytesPerPixel, scaleFactor);
 				
-				default:
-					fprintf(stderr, "SDL: Unsupported color depth for requested orientation");
-					exit(2);
+				// the other lines are copies of the first one, which is still in the cache
+				for (pp_int32 i = 1; i < scaleFactor; i++)
+					memcpy(dstPtr + i*dstPitch, dstPtr, rowSize);
 			}
 			
 			SDL_UnlockSurface(theSurface);				
@@ -43,6 +43,10 @@ private:
 	// used for rotating coordinates etc.
 	void swap(const PPRect& r);
 
+	// copies a damaged area into the texture, doesn't present
+	void updateTexture(const PPRect& r);
+	void present();
+
 public:
 	PPDisplayDeviceFB(pp_int32 width,
 					  pp_int32 height, 
@@ -62,6 +66,7 @@ public:
 
 	void update();
 	void update(const PPRect& r);
+	virtual void updateRects(const PPRect* rects, pp_int32 numRects);
 protected:
 	SDL_Surface* theSurface;
 	SDL_Texture* theTexture;
@@ -0,0 +1,230 @@
+/*
+ *  tools/loadziptest.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Loads packed modules the way Tracker::loadGenericFileType does:
+ *  the archive is decompressed into memory, identified there and the
+ *  module is loaded from that buffer, no temporary files involved.
+ *  A small MOD is written into a .zip and a .gz archive (both stored,
+ *  no compression needed) in the current directory.
+ *
+ *  Link with milkyplay, compression (zziplib and zlib) and
+ *  tracker/FileIdentificator.cpp, returns 0 if everything loads.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "XMFile.h"
+#include "XModule.h"
+#include "Decompressor.h"
+#include "FileIdentificator.h"
+
+static const char* moduleTitle = "zipped module";
+
+static mp_uint32 crc32(const mp_ubyte* data, mp_uint32 size)
+{
+	mp_uint32 crc = 0xFFFFFFFF;
+	for (mp_uint32 i = 0; i < size; i++)
+	{
+		crc ^= data[i];
+		for (mp_sint32 j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return ~crc;
+}
+
+// 4 channel ProTracker module, one sample, one pattern
+static mp_uint32 buildModule(mp_ubyte* mod)
+{
+	const mp_uint32 sampleLength = 32;
+	mp_uint32 size = 1084 + 64*4*4 + sampleLength;
+
+	memset(mod, 0, size);
+	strcpy((char*)mod, moduleTitle);
+
+	mp_ubyte* smp = mod + 20;
+	strcpy((char*)smp, "square");
+	smp[22] = 0; smp[23] = sampleLength / 2;
+	smp[25] = 64;
+	smp[28] = 0; smp[29] = 1;
+
+	mod[950] = 1;
+	mod[951] = 127;
+	memcpy(mod + 1080, "M.K.", 4);
+
+	// C-3 with sample 1 in the first channel
+	mp_ubyte* pattern = mod + 1084;
+	pattern[0] = 0x01; pattern[1] = 0xAC; pattern[2] = 0x10;
+
+	mp_ubyte* sample = mod + 1084 + 64*4*4;
+	for (mp_uint32 i = 0; i < sampleLength; i++)
+		sample[i] = i < sampleLength / 2 ? 0x40 : 0xC0;
+
+	return size;
+}
+
+static bool writeZip(const char* fileName, const mp_ubyte* data, mp_uint32 size)
+{
+	XMFile f(PPSystemString(fileName), true);
+	if (!f.isOpenForWriting())
+		return false;
+
+	const char* name = "test.mod";
+	const mp_uword nameLength = (mp_uword)strlen(name);
+	const mp_uint32 crc = crc32(data, size);
+
+	// local header, stored
+	f.writeDword(0x04034b50);
+	f.writeWord(10);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeDword(crc);
+	f.writeDword(size);
+	f.writeDword(size);
+	f.writeWord(nameLength);
+	f.writeWord(0);
+	f.write(name, 1, nameLength);
+	f.write(data, 1, size);
+
+	const mp_uint32 centralDirectory = 30 + nameLength + size;
+
+	f.writeDword(0x02014b50);
+	f.writeWord(20);
+	f.writeWord(10);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeDword(crc);
+	f.writeDword(size);
+	f.writeDword(size);
+	f.writeWord(nameLength);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeDword(0);
+	f.writeDword(0);
+	f.write(name, 1, nameLength);
+
+	f.writeDword(0x06054b50);
+	f.writeWord(0);
+	f.writeWord(0);
+	f.writeWord(1);
+	f.writeWord(1);
+	f.writeDword(46 + nameLength);
+	f.writeDword(centralDirectory);
+	f.writeWord(0);
+
+	return true;
+}
+
+static bool writeGZip(const char* fileName, const mp_ubyte* data, mp_uint32 size)
+{
+	XMFile f(PPSystemString(fileName), true);
+	if (!f.isOpenForWriting())
+		return false;
+
+	// DecompressorGZIP wants the original file name in the header
+	static const mp_ubyte header[10] = { 0x1F, 0x8B, 8, 8, 0, 0, 0, 0, 0, 3 };
+	f.write(header, 1, sizeof(header));
+	f.write("test.mod", 1, 9);
+
+	// a single final stored deflate block
+	f.writeByte(1);
+	f.writeWord((mp_uword)size);
+	f.writeWord((mp_uword)~size);
+	f.write(data, 1, size);
+
+	f.writeDword(crc32(data, size));
+	f.writeDword(size);
+
+	return true;
+}
+
+static bool loadPacked(const char* fileName)
+{
+	const PPSystemString archiveName(fileName);
+
+	// this is what Tracker::loadGenericFileType does
+	XMBufferFile decompressedFile(archiveName);
+	Decompressor decompressor(archiveName);
+	if (!decompressor.decompress(decompressedFile, DecompressorBase::HintAll))
+	{
+		fprintf(stderr, "%s: can't decompress\n", fileName);
+		return false;
+	}
+
+	// the decompressor leaves the position at the end
+	if (!FileIdentificator::isModule(decompressedFile))
+	{
+		fprintf(stderr, "%s: not identified as a module\n", fileName);
+		return false;
+	}
+
+	// ModuleEditor::openSong rewinds too
+	XModule module;
+	decompressedFile.seek(0);
+	if (module.loadModule(decompressedFile) != MP_OK)
+	{
+		fprintf(stderr, "%s: can't load the module\n", fileName);
+		return false;
+	}
+
+	if (strcmp(module.header.name, moduleTitle) != 0 ||
+		module.header.ordnum != 1 ||
+		module.header.patnum != 1 ||
+		module.header.channum != 4)
+	{
+		fprintf(stderr, "%s: module loaded incorrectly\n", fileName);
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, const char* argv[])
+{
+	static mp_ubyte mod[1084 + 64*4*4 + 32];
+	mp_uint32 size = buildModule(mod);
+
+	bool result = true;
+
+	if (!writeZip("loadziptest.zip", mod, size) ||
+		!writeGZip("loadziptest.mod.gz", mod, size))
+	{
+		fprintf(stderr, "can't write the test archives\n");
+		return 1;
+	}
+
+	result &= loadPacked("loadziptest.zip");
+	result &= loadPacked("loadziptest.mod.gz");
+
+	XMFile::remove(PPSystemString("loadziptest.zip"));
+	XMFile::remove(PPSystemString("loadziptest.mod.gz"));
+
+	printf(result ? "passed\n" : "failed\n");
+
+	return result ? 0 : 1;
+}
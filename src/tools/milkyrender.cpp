@@ -0,0 +1,194 @@
+/*
+ *  tools/milkyrender.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  Headless batch renderer, bounces modules to WAV files without any
+ *  audio device or UI. Link against milkyplay only and build with
+ *  the same defines as the library (MILKYTRACKER).
+ *
+ *  milkyrender [options] module1 [module2 ...]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <iostream>
+#include "OfflineRenderer.h"
+#include "AudioDriver_NULL.h"
+#include "XModule.h"
+#include "ChannelMixer.h"
+#include "ResamplerYM.h"
+
+using namespace std;
+
+static void usage()
+{
+	cerr << "usage: milkyrender [options] module1 [module2 ...]" << endl
+		 << "  -o file      output file (single module only), default is <module>.wav" << endl
+		 << "  -n           render without writing any output (benchmark)" << endl
+		 << "  -r rate      sample rate (default 44100)" << endl
+		 << "  -b frames    block size in sample frames (default 1024)" << endl
+		 << "  -i type      interpolation: 0 = none, 1 = linear (default), 2 = band limited" << endl
+		 << "  -noramp      disable volume ramping" << endl
+		 << "  -f           write 32 bit float instead of 16 bit samples" << endl
+		 << "  -s shift     divide the mix by 2^shift before output (default 1)" << endl
+		 << "  -t threads   mixer threads, 0 = all cores (default 1)" << endl
+		 << "  -p threads   split each song into segments rendered at the same time," << endl
+		 << "               0 = all cores (default 1)" << endl
+		 << "  -l seconds   cut songs after this many seconds (default unlimited)" << endl
+		 << "  -y file      YM2149 sound bank for the YM channels" << endl;
+}
+
+static string getOutputFileName(const char* moduleFileName)
+{
+	string name(moduleFileName);
+
+	string::size_type dot = name.find_last_of('.');
+	string::size_type sep = name.find_last_of("/\\");
+	if (dot != string::npos && (sep == string::npos || dot > sep))
+		name.erase(dot);
+
+	return name + ".wav";
+}
+
+int main(int argc, const char* argv[])
+{
+	OfflineRenderer::Settings settings;
+	const char* outputFileName = NULL;
+	bool writeOutput = true;
+	int interpolation = 1;
+	bool ramping = true;
+
+	int i;
+	for (i = 1; i < argc && argv[i][0] == '-'; i++)
+	{
+		const char* option = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (strcmp(option, "-n") == 0)
+			writeOutput = false;
+		else if (strcmp(option, "-f") == 0)
+			settings.sampleFormat = MasterMixer::SampleFormatFloat32;
+		else if (strcmp(option, "-noramp") == 0)
+			ramping = false;
+		else if (strcmp(option, "-o") == 0 && hasValue)
+			outputFileName = argv[++i];
+		else if (strcmp(option, "-r") == 0 && hasValue)
+			settings.sampleRate = atoi(argv[++i]);
+		else if (strcmp(option, "-b") == 0 && hasValue)
+			settings.blockSize = atoi(argv[++i]);
+		else if (strcmp(option, "-i") == 0 && hasValue)
+			interpolation = atoi(argv[++i]);
+		else if (strcmp(option, "-s") == 0 && hasValue)
+			settings.sampleShift = atoi(argv[++i]);
+		else if (strcmp(option, "-t") == 0 && hasValue)
+			settings.mixerThreads = atoi(argv[++i]);
+		else if (strcmp(option, "-p") == 0 && hasValue)
+			settings.segmentThreads = atoi(argv[++i]);
+		else if (strcmp(option, "-l") == 0 && hasValue)
+			settings.maxSeconds = atoi(argv[++i]);
+		else if (strcmp(option, "-y") == 0 && hasValue)
+		{
+			ResamplerYM::SetSndSynFilename(argv[++i]);
+			if (!ResamplerYM::Reload())
+			{
+				cerr << argv[i] << ": " << ResamplerYM::GetError() << endl;
+				return -1;
+			}
+		}
+		else
+		{
+			usage();
+			return -1;
+		}
+	}
+
+	int numModules = argc - i;
+	if (numModules <= 0 ||
+		(outputFileName && numModules > 1) ||
+		interpolation < 0 || interpolation > 2 ||
+		settings.sampleRate < 8000 || settings.blockSize == 0 || settings.sampleShift > 8)
+	{
+		usage();
+		return -1;
+	}
+
+	// MIXER_NORMAL, MIXER_LERPING and MIXER_BLS with their ramping variants
+	settings.resamplerType = (MixerSettings::ResamplerTypes)((interpolation << 1) | (ramping ? 1 : 0));
+
+	OfflineRenderer renderer(settings);
+
+	mp_int64 totalFrames = 0;
+	double totalSeconds = 0.0;
+	int numFailed = 0;
+
+	for (; i < argc; i++)
+	{
+		const char* moduleFileName = argv[i];
+
+		XModule module;
+		mp_sint32 res = module.loadModule(moduleFileName);
+		if (res == MP_OK)
+		{
+			if (writeOutput)
+			{
+				string fileName = outputFileName ? string(outputFileName) : getOutputFileName(moduleFileName);
+				res = renderer.renderToWAV(module, fileName.c_str());
+			}
+			else
+			{
+				AudioDriver_NULL nullDriver;
+				res = renderer.render(module, nullDriver);
+			}
+		}
+
+		if (res != MP_OK)
+		{
+			cerr << moduleFileName << ": failed (" << res << ")" << endl;
+			numFailed++;
+			continue;
+		}
+
+		const OfflineRenderer::Statistics& statistics = renderer.getStatistics();
+		totalFrames += statistics.numFrames;
+		totalSeconds += statistics.elapsedSeconds;
+
+		printf("%s: %lld frames in %.3f s, %.0f frames/s (%.1fx realtime)\n",
+			   moduleFileName,
+			   (long long)statistics.numFrames,
+			   statistics.elapsedSeconds,
+			   statistics.getFramesPerSecond(),
+			   statistics.getFramesPerSecond() / settings.sampleRate);
+	}
+
+	if (numModules > 1 && totalSeconds > 0.0)
+	{
+		printf("total: %d modules, %lld frames in %.3f s, %.0f frames/s\n",
+			   numModules - numFailed,
+			   (long long)totalFrames,
+			   totalSeconds,
+			   totalFrames / totalSeconds);
+	}
+
+	return numFailed ? 1 : 0;
+}
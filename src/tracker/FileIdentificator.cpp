@@ -83,10 +83,16 @@ FileIdentificator::FileTypes FileIdentificator::getFileType()
 
 bool FileIdentificator::isModule()
 {
-	mp_ubyte buffer[2048];
+	return isModule(*f);
+}
+
+bool FileIdentificator::isModule(XMFileBase& f)
+{
+	mp_ubyte buffer[XModule::IdentificationBufferSize];
+	memset(buffer, 0, sizeof(buffer));
 	
-	f->seek(0);
-	f->read(buffer, 1, 2048);
+	f.seek(0);
+	f.read(buffer, 1, sizeof(buffer));
 	
 	return XModule::identifyModule(buffer) != NULL;
 }
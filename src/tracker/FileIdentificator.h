@@ -33,6 +33,7 @@
 
 #include "BasicTypes.h"
 
+class XMFileBase;
 class XMFile;
 
 class FileIdentificator
@@ -67,6 +68,10 @@ public:
 	bool isValid() { return f != NULL; }
 	
 	FileTypes getFileType();
+
+	// whether f holds a module, reads from the start whatever
+	// the position is, e.g. after decompressing into f
+	static bool isModule(XMFileBase& f);
 };
 
 #endif
@@ -109,6 +109,7 @@ ModuleEditor::ModuleEditor() :
 	envelopeEditor(NULL),
 	playerCriticalSection(NULL),
 	changed(false),
+	estimatedPlayTime(-1),
 	eSaveType(ModSaveTypeXM),
 	lastRequestedPatternIndex(0),
 	currentOrderIndex(0),
@@ -559,6 +560,7 @@ bool ModuleEditor::allocatePattern(TXMPattern* pattern)
 		return false;
 
 	memset(pattern->patternData, 0, patternSize);
+	pattern->setDirty();
 	return true;
 }
 
@@ -576,6 +578,7 @@ void ModuleEditor::createEmptySong(bool clearPatterns/* = true*/, bool clearInst
 		if (clearPatterns && clearInstruments)
 		{
 			changed = false;
+			estimatedPlayTime = -1;
 
 			eSaveType = ModSaveTypeXM;
 			
@@ -627,19 +630,7 @@ bool ModuleEditor::isEmpty() const
 	
 	if (pattern->patternData != NULL)
 	{
-		mp_sint32 slotSize = pattern->effnum * 2 + 2;
-		
-		mp_sint32 patternSize = slotSize * pattern->channum * pattern->rows;
-		
-		bool empty = true;
-		for (mp_sint32 j = 0; j < patternSize; j++)
-			if (pattern->patternData[j])
-			{
-				empty = false;
-				break;
-			}
-	
-		if (!empty)
+		if (!pattern->isEmpty())
 			return false;
 	} 
 
@@ -663,29 +654,46 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 	if (!XMFile::exists(fileName))
 		return false;
 
-	mp_sint32 nRes = module->loadModule(fileName);
+	return finishOpenSong(module->loadModule(fileName), preferredFileName ? preferredFileName : fileName, true);
+}
+
+bool ModuleEditor::openSong(XMFileBase& f, const SYSCHAR* fileName, bool loadSynthSounds/* = true*/)
+{
+	f.seek(0);
 	
-	if (module != nullptr)
+	return finishOpenSong(module->loadModule(f), fileName, loadSynthSounds);
+}
+
+void ModuleEditor::loadSynthSounds(const SYSCHAR* songFileName)
+{
+	char drive[256];
+	char dir[256];
+	char filename[256];
+
+	_splitpath(songFileName, drive, dir, filename, NULL);
+	strcat(drive, dir);
+	strcat(drive, filename);
+	strcat(drive, ".INI");
+
+	if (XMFile::exists(drive))
 	{
-		module->header.speed = 125;
+		ResamplerYM::SetSndSynFilename(drive);
+		ResamplerYM::Reload();
 	}
+}
 
-	if (nRes == MP_OK)
+bool ModuleEditor::finishOpenSong(mp_sint32 nRes, const SYSCHAR* fileName, bool loadSynthSounds)
+{
+	if (module != nullptr)
 	{
-		char drive[256];
-		char dir[256];
-		char filename[256];
+		module->header.speed = 125;
+	}
 
-		_splitpath(fileName, drive, dir, filename, NULL);
-		strcat(drive, dir);
-		strcat(drive, filename);
-		strcat(drive, ".INI");
+	estimatedPlayTime = -1;
 
-		if (XMFile::exists(drive))
-		{
-			ResamplerYM::GetInstance()->SetSndSynFilename(drive);
-			ResamplerYM::GetInstance()->Reload();
-		}
+	if (nRes == MP_OK && loadSynthSounds)
+	{
+		ModuleEditor::loadSynthSounds(fileName);
 	}
 
 	// unknown format
@@ -718,15 +726,17 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 			}
 		} 
 	
-		PPSystemString tempFile(getTempFilename());
-	
 		try
 		{
-			res = module->saveExtendedModule(tempFile) == MP_OK;
+			// convert by round tripping through XM in memory
+			XMBufferFile f;
+			
+			res = module->saveExtendedModule(f) == MP_OK;
 			if(!res)
 				return res;
 
-			res = module->loadModule(tempFile) == MP_OK;
+			f.seek(0);
+			res = module->loadModule(f) == MP_OK;
 		} catch (const std::bad_alloc &) {
 			return false;
 		}
@@ -744,8 +754,6 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 				}
 			}
 		} 
-	
-		XMFile::remove(tempFile);
 	}
 
 	if (module->header.channum > TrackerConfig::numPlayerChannels)
@@ -763,7 +771,7 @@ bool ModuleEditor::openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFil
 		for (mp_sint32 i = 0; i < module->header.patnum; i++)
 			getPattern(i);
 		
-		PPSystemString strFileName = preferredFileName ? preferredFileName : fileName;
+		PPSystemString strFileName = fileName;
 
 		moduleFileName = strFileName.stripExtension();
 		
@@ -990,20 +998,8 @@ void ModuleEditor::cleanUnusedPatterns()
 
 		if (pattern->patternData == NULL)
 			continue;
-			
-		mp_sint32 slotSize = pattern->effnum * 2 + 2;
-		
-		mp_sint32 patternSize = slotSize * pattern->channum * pattern->rows;
-		
-		bool empty = true;
-		for (mp_sint32 j = 0; j < patternSize; j++)
-			if (pattern->patternData[j])
-			{
-				empty = false;
-				break;
-			}
 		
-		if (empty)
+		if (pattern->isEmpty())
 		{
 			bool found = false;
 			for (mp_sint32 j = 0; j < module->header.ordnum; j++)
@@ -1078,6 +1074,7 @@ TXMPattern* ModuleEditor::getPattern(mp_sint32 index, bool cleanUnusedPatterns/*
 		pattern->patternData = newPatternData;
 	
 		pattern->channum = (mp_ubyte)TrackerConfig::numPlayerChannels;
+		pattern->setDirty();
 	}
 
 	// update number of patterns in module header if necessary
@@ -102,6 +102,9 @@ private:
 
 	bool changed;
 
+	// seconds, -1 if it hasn't been estimated
+	pp_int32 estimatedPlayTime;
+
 	PPSystemString moduleFileName;
 	PPSystemString sampleFileName;
 	PPSystemString instrumentFileName;
@@ -123,6 +126,10 @@ private:
 	// make sure everything is fine
 	void validateInstruments();
 
+	// everything after the module has been loaded, fileName is the name
+	// the song gets (and where its .INI is looked for)
+	bool finishOpenSong(mp_sint32 loadResult, const SYSCHAR* fileName, bool loadSynthSounds);
+
 	// insert an XIInstrument at position index
 	bool insertXIInstrument(mp_sint32 index, const XIInstrument* ins);
 
@@ -172,8 +179,12 @@ public:
 	const PatternEditorTools::Position& getCurrentCursorPosition() { return currentCursorPosition; }
 
 	void setChanged() { changed = true; }
+	void clearChanged() { changed = false; }
 	bool hasChanged() const { return changed; }
 
+	void setEstimatedPlayTime(pp_int32 estimatedPlayTime) { this->estimatedPlayTime = estimatedPlayTime; }
+	pp_int32 getEstimatedPlayTime() const { return estimatedPlayTime; }
+
 	void reloadCurrentPattern();
 	void reloadSample(mp_sint32 insIndex, mp_sint32 smpIndex);
 	void reloadEnvelope(mp_sint32 insIndex, mp_sint32 smpIndex, mp_sint32 type);
@@ -238,6 +249,11 @@ public:
 	bool isEmpty() const;
 						 
 	bool openSong(const SYSCHAR* fileName, const SYSCHAR* preferredFileName = NULL);	
+	// song which is already in memory (e.g. decompressed), fileName is the one it goes by
+	// editors which aren't attached yet may do this on another thread, the synth 
+	// sounds are shared and have to be loaded on the UI thread afterwards then
+	bool openSong(XMFileBase& f, const SYSCHAR* fileName, bool loadSynthSounds = true);
+	static void loadSynthSounds(const SYSCHAR* songFileName);
 	bool saveSong(const SYSCHAR* fileName, ModSaveTypes saveType = ModSaveTypeXM);
 	mp_sint32 saveBackup(const SYSCHAR* fileName);
 	
@@ -0,0 +1,186 @@
+/*
+ *  tracker/ModuleLoader.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  ModuleLoader.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "ModuleLoader.h"
+#include "ModuleEditor.h"
+#include "XMFile.h"
+#include "Decompressor.h"
+#include "SongAnalysis.h"
+
+ModuleLoader::ModuleLoader() :
+	cancelled(false),
+	finished(false),
+	progress(0),
+	moduleEditor(NULL),
+	decompressedFile(NULL),
+	decompress(false),
+	analysisCache(NULL),
+	result(false),
+	file(NULL)
+{
+}
+
+ModuleLoader::~ModuleLoader()
+{
+	cancel();
+	join();
+	
+	delete moduleEditor;
+	delete decompressedFile;
+}
+
+void ModuleLoader::start(ModuleEditor* moduleEditor, const PPSystemString& fileName, 
+						 XMBufferFile* decompressedFile, bool decompress,
+						 SongAnalysisCache* analysisCache/* = NULL*/)
+{
+	ASSERT(!isLoading());
+
+	this->moduleEditor = moduleEditor;
+	this->fileName = fileName;
+	this->decompressedFile = decompressedFile;
+	this->decompress = decompress;
+	this->analysisCache = analysisCache;
+	
+	result = false;
+	cancelled = false;
+	finished = false;
+	progress = 0;
+	
+	thread = std::thread(&ModuleLoader::run, this);
+}
+
+void ModuleLoader::run()
+{
+	if (decompressedFile == NULL && decompress)
+	{
+		decompressedFile = new XMBufferFile(fileName);
+		Decompressor decompressor(fileName);
+		if (!decompressor.decompress(*decompressedFile, DecompressorBase::HintModules))
+		{
+			delete decompressedFile;
+			decompressedFile = NULL;
+			finished = true;
+			return;
+		}
+	}
+	
+	XMMappedFile* mappedFile = NULL;
+	XMFile* plainFile = NULL;
+	
+	if (decompressedFile)
+	{
+		file = decompressedFile;
+	}
+	else
+	{
+		// same as XModule::loadModule(fileName)
+		mappedFile = new XMMappedFile(fileName);
+		if (mappedFile->isOpen())
+		{
+			file = mappedFile;
+		}
+		else
+		{
+			plainFile = new XMFile(fileName);
+			file = plainFile;
+		}
+	}
+	
+	if (file->isOpen())
+	{
+		moduleEditor->getModule()->setLoadingObserver(this);
+		
+		// synth sounds are shared, they're loaded when the song is handed over
+		result = moduleEditor->openSong(*file, fileName, false);
+
+		moduleEditor->getModule()->setLoadingObserver(NULL);
+		
+		if (result && analysisCache && !cancelled)
+			estimatePlayTime();
+	}
+	
+	file = NULL;
+	delete plainFile;
+	delete mappedFile;
+	
+	delete decompressedFile;
+	decompressedFile = NULL;
+	
+	progress = 100;
+	finished = true;
+}
+
+void ModuleLoader::estimatePlayTime()
+{
+	SongAnalysis analysis;
+	mp_uint64 hash = SongAnalysisCache::hash(*file);
+	
+	if (!analysisCache->lookup(hash, analysis))
+	{
+		analysis.analyze(*moduleEditor->getModule());
+		analysisCache->store(hash, analysis);
+	}
+	
+	moduleEditor->setEstimatedPlayTime(analysis.getDuration() / 1000);
+}
+
+bool ModuleLoader::continueLoading()
+{
+	// samples make up most of a module and they're loaded in file 
+	// order, so the file position is good enough for progress
+	mp_uint32 size = file->size();
+	if (size)
+		progress = (pp_int32)(((mp_int64)file->pos() * 100) / size);
+
+	return !cancelled;
+}
+
+void ModuleLoader::cancel()
+{
+	cancelled = true;
+}
+
+void ModuleLoader::join()
+{
+	if (thread.joinable())
+		thread.join();
+}
+
+ModuleEditor* ModuleLoader::takeModuleEditor(bool& result)
+{
+	ASSERT(isFinished());
+	
+	join();
+
+	ModuleEditor* moduleEditor = this->moduleEditor;
+	this->moduleEditor = NULL;
+
+	result = this->result && !cancelled;
+
+	return moduleEditor;
+}
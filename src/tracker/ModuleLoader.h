@@ -0,0 +1,105 @@
+/*
+ *  tracker/ModuleLoader.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  ModuleLoader.h
+ *  MilkyTracker
+ *
+ *  Loads a module into a fresh module editor on a thread of its own, 
+ *  so the UI (and the other tabs) stay usable while huge modules with
+ *  packed samples are loading. The editor isn't attached to a player
+ *  or a tab until it's handed over, only then it becomes visible.
+ *  The UI thread polls the loader, there are no callbacks.
+ */
+
+#ifndef __MODULELOADER_H__
+#define __MODULELOADER_H__
+
+#include "BasicTypes.h"
+#include "XModule.h"
+#include <thread>
+#include <atomic>
+
+class ModuleEditor;
+class XMFileBase;
+class XMBufferFile;
+class SongAnalysisCache;
+
+class ModuleLoader : public XModule::LoadingObserver
+{
+private:
+	std::thread thread;
+	
+	std::atomic<bool> cancelled;
+	std::atomic<bool> finished;
+	std::atomic<pp_int32> progress;
+	
+	ModuleEditor* moduleEditor;
+	PPSystemString fileName;
+	// already decompressed contents, loaded instead of the file
+	XMBufferFile* decompressedFile;
+	bool decompress;
+	// the play time is estimated when given
+	SongAnalysisCache* analysisCache;
+	bool result;
+	
+	// only touched by the loading thread
+	XMFileBase* file;
+
+	void run();
+	void estimatePlayTime();
+	
+	virtual bool continueLoading();
+
+	void join();
+
+public:
+	ModuleLoader();
+	~ModuleLoader();
+	
+	// starts loading fileName into moduleEditor, which the loader owns until
+	// it's taken back. decompressedFile (owned too) is loaded instead of the
+	// file if given, otherwise the file is decompressed first if requested.
+	// The play time is looked up in analysisCache or found and stored there
+	// if a cache is given
+	void start(ModuleEditor* moduleEditor, const PPSystemString& fileName, 
+			   XMBufferFile* decompressedFile, bool decompress,
+			   SongAnalysisCache* analysisCache = NULL);
+
+	// the module editor is handed back as usual, with an empty song
+	void cancel();
+	
+	// started and not taken back yet
+	bool isLoading() const { return moduleEditor != NULL; }
+	bool isFinished() const { return finished; }
+	bool isCancelled() const { return cancelled; }
+	
+	// percent
+	pp_int32 getProgress() const { return progress; }
+	
+	const PPSystemString& getFileName() const { return fileName; }
+
+	// once finished, returns the editor and whether the song could be loaded
+	ModuleEditor* takeModuleEditor(bool& result);
+};
+
+#endif
@@ -309,6 +309,7 @@ bool PatternEditor::revoke(const PatternUndoStackEntry* stackEntry)
 			delete[] pattern->patternData;
 			pattern->patternData = new mp_ubyte[patternSize];
 			memset(pattern->patternData, 0, patternSize);
+			pattern->setDirty();
 		}
 	}
 	
@@ -367,6 +368,7 @@ void PatternEditor::clearPattern()
 	pp_int32 patSize = pattern->channum * (pattern->effnum*2+2) * pattern->rows;	
 
 	memset(pattern->patternData, 0, patSize);
+	pattern->setDirty();
 }
 
 void PatternEditor::cut(ClipBoard& clipBoard)
@@ -478,6 +480,7 @@ bool PatternEditor::resizePattern(pp_int32 newRowNum, bool withUndo /*= true*/)
 		pattern->patternData = newPatternData;
 		
 		pattern->rows = newRowNum;
+		pattern->setDirty();
 		
 		// see if something has changed, if this is the case
 		// save original & changes
@@ -493,6 +496,7 @@ bool PatternEditor::resizePattern(pp_int32 newRowNum, bool withUndo /*= true*/)
 		pattern->patternData = newPatternData;
 		
 		pattern->rows = newRowNum;
+		pattern->setDirty();
 		
 		lastOperationDidChangeRows = true;
 		lastOperationDidChangeCursor = false;
@@ -1729,6 +1733,7 @@ void PatternEditor::insertNote(pp_int32 channel, pp_int32 row)
 	}
 	
 	memset(row*rowSize + channel*slotSize + pattern->patternData, 0, slotSize);
+	pattern->setDirty();
 	
 	finishUndo(LastChangeInsertNote);
 }
@@ -1756,6 +1761,7 @@ void PatternEditor::insertLine(pp_int32 row)
 	}
 	
 	memset(row*rowSize + pattern->patternData, 0, rowSize);
+	pattern->setDirty();
 	
 	finishUndo(LastChangeInsertLine);
 }
@@ -1785,6 +1791,7 @@ void PatternEditor::deleteNote(pp_int32 channel, pp_int32 row)
 	}
 	
 	memset((pattern->rows-1)*rowSize + channel*slotSize + pattern->patternData, 0, slotSize);
+	pattern->setDirty();
 	
 	finishUndo(LastChangeDeleteNote);
 }
@@ -1812,6 +1819,7 @@ void PatternEditor::deleteLine(pp_int32 row)
 	}
 	
 	memset((pattern->rows-1)*rowSize + pattern->patternData, 0, rowSize);
+	pattern->setDirty();
 	
 	finishUndo(LastChangeDeleteLine);
 }
@@ -121,6 +121,8 @@ void PatternEditor::ClipBoard::makeCopy(TXMPattern& pattern, const PatternEditor
 			}
 		}
 
+	if (clear)
+		pattern.setDirty();
 }
 
 void PatternEditor::ClipBoard::paste(TXMPattern& pattern, pp_int32 sc, pp_int32 sr, bool transparent/* = false*/)
@@ -175,4 +177,6 @@ void PatternEditor::ClipBoard::paste(TXMPattern& pattern, pp_int32 sc, pp_int32
 				}
 			}
 		}
+
+	pattern.setDirty();
 }
@@ -110,6 +110,9 @@ PatternEditorControl::PatternEditorControl(pp_int32 id, PPScreen* parentScreen,
 	
 	transposeHandlerResponder = new TransposeHandlerResponder(*this);
 	dialog = NULL;
+
+	cellTextCache = new CellText[CELLTEXTCACHESIZE];
+	flushCellTextCache();
 }
 
 PatternEditorControl::~PatternEditorControl()
@@ -131,6 +134,8 @@ PatternEditorControl::~PatternEditorControl()
 
 	delete transposeHandlerResponder;
 	delete dialog;
+
+	delete[] cellTextCache;
 }
 
 void PatternEditorControl::setFont(PPFont* font)
@@ -195,6 +200,99 @@ static inline pp_int32 myMod(pp_int32 a, pp_int32 b)
 	return r < 0 ? b + r : r;
 }
 
+void PatternEditorControl::formatCellText(TXMPattern* pattern, pp_int32 channel, pp_int32 row, CellText& cellText)
+{
+	char* name;
+
+	patternTools.setPosition(pattern, channel, row);
+
+	cellText.note = patternTools.getNote();
+	PatternTools::getNoteName(cellText.noteName, cellText.note);
+
+	name = cellText.instrument;
+	pp_uint32 i = patternTools.getInstrument();
+	if (i)
+		PatternTools::convertToHex(name, i, 2);
+	else 
+	{
+		name[0] = name[1] = '\xf4';
+		name[2] = 0;
+	}
+	
+	if (name[0] == '0')
+		name[0] = '\xf4';
+
+	pp_int32 eff, op;
+
+	name = cellText.volume;
+	name[0] = name[1] = '\xf4';
+	name[2] = 0;
+	if (pattern->effnum >= 2)
+	{
+		patternTools.getFirstEffect(eff, op);
+		PatternTools::convertEffectsToFT2(eff, op);
+		PatternTools::getVolumeName(name, PatternTools::getVolumeFromEffect(eff, op));
+	}
+
+	if (pattern->effnum == 1)
+		patternTools.getFirstEffect(eff, op);
+	else
+		patternTools.getNextEffect(eff, op);
+	PatternTools::convertEffectsToFT2(eff, op);
+
+	if (eff == 0 && op == 0)
+	{
+		cellText.effect[0] = properties.zeroEffectCharacter;
+		cellText.effect[1] = 0;
+		cellText.operand[0] = cellText.operand[1] = properties.zeroEffectCharacter;
+		cellText.operand[2] = 0;
+	}
+	else
+	{
+		PatternTools::getEffectName(cellText.effect, eff);
+		PatternTools::convertToHex(cellText.operand, op, 2);
+	}
+}
+
+const PatternEditorControl::CellText& PatternEditorControl::getCellText(TXMPattern* pattern, pp_int32 channel, pp_int32 row, CellText& temp)
+{
+	// the text depends on note, instrument and the effects shown
+	pp_uint32 keySize = pattern->effnum >= 2 ? 6 : 4;
+
+	if (pattern->effnum < 1 || channel < 0 || row < 0 ||
+		channel >= pattern->channum || row >= pattern->rows)
+	{
+		formatCellText(pattern, channel, row, temp);
+		return temp;
+	}
+
+	const pp_uint8* key = pattern->patternData + (pattern->effnum*2+2)*(pattern->channum*row + channel);
+
+	pp_uint32 hash = keySize;
+	for (pp_uint32 i = 0; i < keySize; i++)
+		hash = hash*31 + key[i];
+	hash ^= hash >> 10;
+
+	CellText& cellText = cellTextCache[hash & (CELLTEXTCACHESIZE-1)];
+
+	if (cellText.keySize != keySize || memcmp(cellText.key, key, keySize) != 0)
+	{
+		formatCellText(pattern, channel, row, cellText);
+		cellText.keySize = keySize;
+		memcpy(cellText.key, key, keySize);
+	}
+
+	return cellText;
+}
+
+void PatternEditorControl::flushCellTextCache()
+{
+	for (pp_int32 i = 0; i < CELLTEXTCACHESIZE; i++)
+		cellTextCache[i].keySize = 0;
+
+	cellTextZeroEffectCharacter = properties.zeroEffectCharacter;
+}
+
 void PatternEditorControl::paint(PPGraphicsAbstract* g)
 {
 	if (!isVisible())
@@ -269,8 +367,6 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 	const pp_uint32 fontCharWidth2x = font->getCharWidth()*2 + 1;
 	const pp_uint32 fontCharWidth1x = font->getCharWidth()*1 + 1;	
 	
-	PatternTools* patternTools = &this->patternTools;
-	
 	// ;----------------- Little adjustment for scrolling in center
 	if (properties.scrollMode == ScrollModeToCenter)
 	{
@@ -306,6 +402,11 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 
 	pp_int32 numVisibleChannels = patternEditor->getNumChannels();
 
+	if (cellTextZeroEffectCharacter != properties.zeroEffectCharacter)
+		flushCellTextCache();
+
+	CellText tempCellText;
+
 	for (pp_int32 i2 = startIndex;; i2++)
 	{
 		i = i2 < 0 ? startIndex - i2 - 1: i2;
@@ -446,85 +547,6 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 		
 		g->drawString(name, px, py);
 
-		// draw channels
-		for (j = startPos; j < numVisibleChannels; j++)
-		{
-
-			pp_int32 px = (location.x + (j-startPos) * slotSize + SCROLLBARWIDTH) + (getRowCountWidth() + 4);
-			
-			// columns are already in invisible area => abort
-			if (px >= location.x + size.width)
-				break;
-			
-			pp_int32 py = location.y + SCROLLBARWIDTH;
-
-			if (menuInvokeChannel == j)
-				g->setColor(255-dColor.r, 255-dColor.g, 255-dColor.b);
-			else
-				g->setColor(dColor);
-
-			{
-				PPColor nsdColor = g->getColor(), nsbColor = g->getColor();
-				
-				if (menuInvokeChannel != j)
-				{
-					// adjust not so dark color
-					nsdColor.scaleFixed(50000);
-					
-					// adjust bright color
-					nsbColor.scaleFixed(80000);
-				}
-				else
-				{
-					// adjust not so dark color
-					nsdColor.scaleFixed(30000);
-					
-					// adjust bright color
-					nsbColor.scaleFixed(60000);
-				}
-				
-				PPRect rect(px, py, px+slotSize, py + font->getCharHeight()+1);
-				g->fillVerticalShaded(rect, nsbColor, nsdColor, false);
-				
-			}
-			
-			if (muteChannels[j])
-			{
-				g->setColor(128, 128, 128);
-			}
-			else
-			{
-				if (!(j&1))
-					g->setColor(hiLightPrimary);
-				else
-					g->setColor(textColor);
-					
-				if (j == menuInvokeChannel)
-				{
-					PPColor col = g->getColor();
-					col.r = textColor.r - col.r;
-					col.g = textColor.g - col.g;
-					col.b = textColor.b - col.b;
-					col.clamp();
-					g->setColor(col);
-				}
-			}
-
-			if (j < 4)
-			{
-				sprintf(name, "pcm%i", j+1);
-			}
-			else
-			{
-				sprintf(name, "ym%i", j+1-4);
-			}
-
-			if (muteChannels[j])
-				strcat(name, "-Mute");
-
-			g->drawString(name, px + (slotSize>>1)-(((pp_int32)strlen(name)*font->getCharWidth())>>1), py+1);
-		}
-
 		for (j = startPos; j < numVisibleChannels; j++)
 		{
 			pp_int32 px = (j-startPos) * slotSize + startx;
@@ -603,14 +625,14 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 				g->drawHLine(px + cursorPositions[cursor.inner], px + cursorPositions[cursor.inner]+cursorSizes[cursor.inner], py + font->getCharHeight());
 			}
 
-			patternTools->setPosition(pattern, j, row);
+			const CellText& cellText = getCellText(pattern, j, row, tempCellText);
 
 			PPColor noteCol = noteColor;
 
 			// Show notes in red if outside PT 3 octaves
 			if(properties.ptNoteLimit
-			   && ((patternTools->getNote() >= 71 && patternTools->getNote() < patternTools->getNoteOffNote())
-				   || patternTools->getNote() < 36))
+			   && ((cellText.note >= 71 && cellText.note < PatternTools::getNoteOffNote())
+				   || cellText.note < 36))
 			{
 				noteCol.set(0xff,00,00);
 			}
@@ -621,8 +643,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			}
 
 			g->setColor(noteCol);
-			patternTools->getNoteName(name, patternTools->getNote());
-			g->drawString(name,px, py);
+			g->drawString(cellText.noteName, px, py);
 
 			px += fontCharWidth3x + properties.spacing;
 			
@@ -635,20 +656,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			else
 				g->setColor(insColor);
 
-			pp_uint32 i = patternTools->getInstrument();
-
-			if (i)
-				patternTools->convertToHex(name, i, 2);
-			else 
-			{
-				name[0] = name[1] = '\xf4';
-				name[2] = 0;
-			}
-			
-			if (name[0] == '0')
-			name[0] = '\xf4';
-
-			g->drawString(name,px, py);
+			g->drawString(cellText.instrument, px, py);
 			
 			px += fontCharWidth2x + properties.spacing;
 
@@ -661,22 +669,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			else
 				g->setColor(volColor);
 
-			pp_int32 eff, op;
-
-			name[0] = name[1] = '\xf4';
-			name[2] = 0;
-			if (pattern->effnum >= 2)
-			{
-				patternTools->getFirstEffect(eff, op);
-				
-				patternTools->convertEffectsToFT2(eff, op);
-				
-				pp_int32 volume = patternTools->getVolumeFromEffect(eff, op);
-			
-				patternTools->getVolumeName(name, volume);
-			}
-
-			g->drawString(name,px, py);
+			g->drawString(cellText.volume, px, py);
 			
 			px += fontCharWidth2x + properties.spacing;
 
@@ -689,28 +682,7 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			else
 				g->setColor(effColor);
 			
-			if (pattern->effnum == 1)
-			{
-				patternTools->getFirstEffect(eff, op);				
-				patternTools->convertEffectsToFT2(eff, op);
-			}
-			else
-			{
-				patternTools->getNextEffect(eff, op);				
-				patternTools->convertEffectsToFT2(eff, op);
-			}
-
-			if (eff == 0 && op == 0)
-			{
-				name[0] = properties.zeroEffectCharacter;
-				name[1] = 0;
-			}
-			else
-			{
-				patternTools->getEffectName(name, eff);
-			}
-
-			g->drawString(name,px, py);
+			g->drawString(cellText.effect, px, py);
 
 			px += fontCharWidth1x;
 
@@ -723,20 +695,90 @@ void PatternEditorControl::paint(PPGraphicsAbstract* g)
 			else
 				g->setColor(opColor);
 			
-			if (eff == 0 && op == 0)
+			g->drawString(cellText.operand, px, py);
+		}
+	}
+
+	// ;----------------- channel headings
+	for (j = startPos; j < numVisibleChannels; j++)
+	{
+
+		pp_int32 px = (location.x + (j-startPos) * slotSize + SCROLLBARWIDTH) + (getRowCountWidth() + 4);
+		
+		// columns are already in invisible area => abort
+		if (px >= location.x + size.width)
+			break;
+		
+		pp_int32 py = location.y + SCROLLBARWIDTH;
+
+		if (menuInvokeChannel == j)
+			g->setColor(255-dColor.r, 255-dColor.g, 255-dColor.b);
+		else
+			g->setColor(dColor);
+
+		{
+			PPColor nsdColor = g->getColor(), nsbColor = g->getColor();
+			
+			if (menuInvokeChannel != j)
+			{
+				// adjust not so dark color
+				nsdColor.scaleFixed(50000);
+				
+				// adjust bright color
+				nsbColor.scaleFixed(80000);
+			}
+			else
 			{
-				name[0] = name[1] = properties.zeroEffectCharacter;
-				name[2] = 0;
+				// adjust not so dark color
+				nsdColor.scaleFixed(30000);
+				
+				// adjust bright color
+				nsbColor.scaleFixed(60000);
 			}
+			
+			PPRect rect(px, py, px+slotSize, py + font->getCharHeight()+1);
+			g->fillVerticalShaded(rect, nsbColor, nsdColor, false);
+			
+		}
+		
+		if (muteChannels[j])
+		{
+			g->setColor(128, 128, 128);
+		}
+		else
+		{
+			if (!(j&1))
+				g->setColor(hiLightPrimary);
 			else
+				g->setColor(textColor);
+				
+			if (j == menuInvokeChannel)
 			{
-				patternTools->convertToHex(name, op, 2);
-			}			
+				PPColor col = g->getColor();
+				col.r = textColor.r - col.r;
+				col.g = textColor.g - col.g;
+				col.b = textColor.b - col.b;
+				col.clamp();
+				g->setColor(col);
+			}
+		}
 
-			g->drawString(name,px, py);
+		if (j < 4)
+		{
+			sprintf(name, "pcm%i", j+1);
 		}
+		else
+		{
+			sprintf(name, "ym%i", j+1-4);
+		}
+
+		if (muteChannels[j])
+			strcat(name, "-Mute");
+
+		g->drawString(name, px + (slotSize>>1)-(((pp_int32)strlen(name)*font->getCharWidth())>>1), py+1);
 	}
 
+
 	for (j = startPos; j < numVisibleChannels; j++)
 	{
 
@@ -331,6 +331,37 @@ private:
 	PPDialogBase* dialog;
 	TransposeHandlerResponder* transposeHandlerResponder;
 
+private:
+	// --- Text of the visible cells
+	// Looked up by the cell data itself, so scrolling and switching
+	// patterns keep hitting the cache. Colors, cursor and selection
+	// are applied when painting.
+	enum
+	{
+		CELLTEXTCACHESIZE = 1024,
+		CELLTEXTMAXKEYSIZE = 6
+	};
+
+	struct CellText
+	{
+		pp_uint32 keySize;
+		pp_uint8 key[CELLTEXTMAXKEYSIZE];
+
+		pp_int32 note;
+		char noteName[4];
+		char instrument[3];
+		char volume[3];
+		char effect[2];
+		char operand[3];
+	};
+
+	CellText* cellTextCache;
+	char cellTextZeroEffectCharacter;
+
+	void formatCellText(TXMPattern* pattern, pp_int32 channel, pp_int32 row, CellText& cellText);
+	const CellText& getCellText(TXMPattern* pattern, pp_int32 channel, pp_int32 row, CellText& temp);
+	void flushCellTextCache();
+
 private:
 	pp_int32 getRowCountWidth();
 
@@ -35,6 +35,16 @@
 PatternEditorTools::PatternEditorTools(TXMPattern* pattern) :
 	pattern(pattern)
 {
+	// every tool operation may write to the pattern
+	if (pattern)
+		pattern->setDirty();
+}
+
+void PatternEditorTools::attachPattern(TXMPattern* pattern)
+{
+	this->pattern = pattern;
+	if (pattern)
+		pattern->setDirty();
 }
 
 PatternEditorTools::Position PatternEditorTools::getMarkStart()
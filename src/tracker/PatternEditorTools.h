@@ -155,7 +155,7 @@ private:
 public:
 	PatternEditorTools(TXMPattern* pattern = NULL);
 
-	void attachPattern(TXMPattern* pattern) { this->pattern = pattern; }
+	void attachPattern(TXMPattern* pattern);
 
 	void clearSelection(const Position& ss, const Position& se);
 	bool expandPattern();
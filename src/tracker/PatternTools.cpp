@@ -66,6 +66,7 @@ void PatternTools::setNote(pp_uint32 note)
 		return;
 
 	*(pattern->patternData + offset) = (pp_uint8)note;
+	pattern->setDirty();
 }
 
 pp_int32 PatternTools::getInstrument()
@@ -82,6 +83,7 @@ void PatternTools::setInstrument(pp_uint32 instrument)
 		return;
 
 	*(pattern->patternData + offset + 1) = (pp_uint8)instrument;
+	pattern->setDirty();
 }
 
 void PatternTools::getFirstEffect(pp_int32& effect, pp_int32& operand)
@@ -124,6 +126,8 @@ void PatternTools::setFirstEffect(pp_int32 effect, pp_int32 operand)
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2) = (pp_uint8)effect;
 	
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2 + 1) = (pp_uint8)operand;
+
+	pattern->setDirty();
 }
 
 void PatternTools::setNextEffect(pp_int32 effect, pp_int32 operand)
@@ -136,6 +140,8 @@ void PatternTools::setNextEffect(pp_int32 effect, pp_int32 operand)
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2) = (pp_uint8)effect;
 	
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2 + 1) = (pp_uint8)operand;
+
+	pattern->setDirty();
 }
 
 void PatternTools::setEffect(pp_int32 currentEffectIndex, pp_int32 effect, pp_int32 operand)
@@ -146,6 +152,8 @@ void PatternTools::setEffect(pp_int32 currentEffectIndex, pp_int32 effect, pp_in
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2) = (pp_uint8)effect;
 	
 	*(pattern->patternData + offset + 2 + currentEffectIndex*2 + 1) = (pp_uint8)operand;
+
+	pattern->setDirty();
 }
 
 void PatternTools::getEffect(pp_int32 currentEffectIndex, pp_int32& effect, pp_int32& operand)
@@ -0,0 +1,216 @@
+/*
+ *  tracker/PlayTimeScanner.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  PlayTimeScanner.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "PlayTimeScanner.h"
+#include "FileIdentificator.h"
+#include "Decompressor.h"
+#include "XModule.h"
+#include "XMFile.h"
+#include "SongAnalysis.h"
+#include <new>
+
+PlayTimeScanner::PlayTimeScanner(SongAnalysisCache& analysisCache) :
+	analysisCache(analysisCache),
+	stopped(false),
+	newPlayTimes(false)
+{
+	thread = std::thread(&PlayTimeScanner::run, this);
+}
+
+PlayTimeScanner::~PlayTimeScanner()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopped = true;
+	}
+	condition.notify_one();
+	
+	thread.join();
+}
+
+bool PlayTimeScanner::getFileInfo(const PPSystemString& fileFullPath, PPString& info)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::basic_string<SYSCHAR> key(fileFullPath);
+	
+	std::map<std::basic_string<SYSCHAR>, pp_int32>::const_iterator it = playTimes.find(key);
+	if (it == playTimes.end())
+	{
+		playTimes[key] = PlayTimePending;
+		requests.push_back(fileFullPath);
+		condition.notify_one();
+		return false;
+	}
+	
+	pp_int32 playTime = it->second;
+	if (playTime < 0)
+		return false;
+	
+	char buffer[32];
+	if (playTime >= 3600)
+		sprintf(buffer, " [%i:%02i:%02i]", playTime / 3600, (playTime / 60) % 60, playTime % 60);
+	else
+		sprintf(buffer, " [%i:%02i]", playTime / 60, playTime % 60);
+	
+	info = buffer;
+	return true;
+}
+
+bool PlayTimeScanner::hasNewPlayTimes()
+{
+	return newPlayTimes.exchange(false);
+}
+
+void PlayTimeScanner::run()
+{
+	while (true)
+	{
+		PPSystemString fileName;
+		
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (!stopped && requests.empty())
+				condition.wait(lock);
+				
+			if (stopped)
+				return;
+				
+			fileName = requests.front();
+			requests.pop_front();
+		}
+		
+		pp_int32 playTime = scan(fileName);
+		
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			playTimes[std::basic_string<SYSCHAR>(fileName)] = playTime;
+		}
+		
+		if (playTime >= 0)
+			newPlayTimes = true;
+	}
+}
+
+bool PlayTimeScanner::convertModule(XModule& module)
+{
+	// the module loader analyses the song as the editor has it, and both
+	// store under the same hash, see ModuleEditor::finishOpenSong()
+	module.header.speed = 125;
+	
+	if (module.getType() == XModule::ModuleType_XM)
+		return true;
+
+	try
+	{
+		// the editor round trips everything through XM, which also
+		// decides how the song is played (FT2 style pattern loops)
+		XMBufferFile f;
+		if (module.saveExtendedModule(f) != MP_OK)
+			return false;
+		
+		f.seek(0);
+		return module.loadModule(f) == MP_OK;
+	} 
+	catch (const std::bad_alloc&) 
+	{
+		return false;
+	}
+}
+
+pp_int32 PlayTimeScanner::scan(const PPSystemString& fileName)
+{
+	FileIdentificator::FileTypes type = FileIdentificator(fileName).getFileType();
+	if (type != FileIdentificator::FileTypeModule && 
+		type != FileIdentificator::FileTypeCompressed)
+		return PlayTimeUnknown;
+
+	XMBufferFile* decompressedFile = NULL;
+	XMMappedFile* mappedFile = NULL;
+	XMFile* plainFile = NULL;
+	XMFileBase* file;
+	
+	// same files as ModuleLoader, so both end up with the same hash
+	if (type == FileIdentificator::FileTypeCompressed)
+	{
+		decompressedFile = new XMBufferFile(fileName);
+		Decompressor decompressor(fileName);
+		if (!decompressor.decompress(*decompressedFile, DecompressorBase::HintModules))
+		{
+			delete decompressedFile;
+			return PlayTimeUnknown;
+		}
+		file = decompressedFile;
+	}
+	else
+	{
+		mappedFile = new XMMappedFile(fileName);
+		if (mappedFile->isOpen())
+		{
+			file = mappedFile;
+		}
+		else
+		{
+			plainFile = new XMFile(fileName);
+			file = plainFile;
+		}
+	}
+	
+	pp_int32 playTime = PlayTimeUnknown;
+	
+	if (file->isOpen())
+	{
+		SongAnalysis analysis;
+		mp_uint64 hash = SongAnalysisCache::hash(*file);
+		
+		if (analysisCache.lookup(hash, analysis))
+		{
+			playTime = analysis.getDuration() / 1000;
+		}
+		else
+		{
+			XModule* module = new XModule();
+			
+			file->seek(0);
+			if (module->loadModule(*file) == MP_OK && convertModule(*module))
+			{
+				analysis.analyze(*module);
+				analysisCache.store(hash, analysis);
+				playTime = analysis.getDuration() / 1000;
+			}
+			
+			delete module;
+		}
+	}
+	
+	delete plainFile;
+	delete mappedFile;
+	delete decompressedFile;
+	
+	return playTime;
+}
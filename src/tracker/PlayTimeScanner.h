@@ -0,0 +1,90 @@
+/*
+ *  tracker/PlayTimeScanner.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  PlayTimeScanner.h
+ *  MilkyTracker
+ *
+ *  Finds out the play time of the songs listed in the disk browser on a
+ *  thread of its own. Songs which have been analysed before are taken 
+ *  from the analysis cache, that only takes hashing the file.
+ *  The UI thread polls the scanner and refreshes the list when new 
+ *  play times have come in.
+ */
+
+#ifndef __PLAYTIMESCANNER_H__
+#define __PLAYTIMESCANNER_H__
+
+#include "BasicTypes.h"
+#include "MilkyPlayCommon.h"
+#include "ListBoxFileBrowser.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+
+class SongAnalysisCache;
+class XModule;
+
+class PlayTimeScanner : public PPListBoxFileBrowser::FileInfoProvider
+{
+private:
+	enum
+	{
+		PlayTimeUnknown = -1,
+		PlayTimePending = -2
+	};
+
+	SongAnalysisCache& analysisCache;
+
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable condition;
+	
+	std::deque<PPSystemString> requests;
+	// seconds, by full path
+	std::map<std::basic_string<SYSCHAR>, pp_int32> playTimes;
+	
+	std::atomic<bool> stopped;
+	std::atomic<bool> newPlayTimes;
+
+	void run();
+	
+	static bool convertModule(XModule& module);
+	pp_int32 scan(const PPSystemString& fileName);
+
+public:
+	PlayTimeScanner(SongAnalysisCache& analysisCache);
+	virtual ~PlayTimeScanner();
+	
+	// from PPListBoxFileBrowser::FileInfoProvider, queues files
+	// it doesn't know yet
+	virtual bool getFileInfo(const PPSystemString& fileFullPath, PPString& info);
+	
+	// play times have been found since the last call
+	bool hasNewPlayTimes();
+};
+
+#endif
@@ -268,6 +268,14 @@ void PlayerController::setInstrumentYMSoundsMapping(const std::map<int, int>& _i
 	}
 }
 
+void PlayerController::stopYM()
+{
+	ResamplerYM* ymresampler = player ? player->getYMResampler() : NULL;
+
+	if (ymresampler)
+		ymresampler->Stop();
+}
+
 
 void PlayerController::reset()
 {
@@ -312,8 +320,7 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 	multiChannelKeyJazz(true),
 	multiChannelRecord(true),
 	mixerDataCacheSize(fakeScopes ? 0 : 512*2),
-	mixerDataCache(fakeScopes ? NULL : new mp_sint32[mixerDataCacheSize]),
-	YMscopeIndex(0)
+	mixerDataCache(fakeScopes ? NULL : new mp_sint32[mixerDataCacheSize])
 {
 	criticalSection = new PlayerCriticalSection(*this);
 
@@ -321,6 +328,8 @@ PlayerController::PlayerController(MasterMixer* mixer, bool fakeScopes) :
 	player->setPlayMode(PlayerBase::PlayMode_FastTracker2);
 	player->resetMainVolumeOnStartPlay(false);
 	player->setBufferSize(mixer->getBufferSize());
+	// without scope data the scopes stay flat
+	player->setScopeBufferEnabled(!fakeScopes);
 
 	currentPlayingChannel = useVirtualChannels ? numPlayerChannels : 0;
 	
@@ -1215,145 +1224,51 @@ bool PlayerController::isNotePlaying(mp_sint32 ins, mp_sint32 channel, mp_sint32
 	return false;
 }
 
-#define FULLMIXER_8BIT_NORMAL_TEMP \
-	if (sample) { \
-		sd1 = ((mp_sbyte)sample[smppos])<<8; \
-		sd2 = ((mp_sbyte)sample[smppos+1])<<8; \
-		sd1 =((sd1<<12)+(smpposfrac>>4)*(sd2-sd1))>>12; \
-		y = (sd1*vol)>>9; \
-	} \
-	else { \
-		y = 0; \
- 	} \
-	fetcher.fetchSampleData(y);
-
-#define FULLMIXER_16BIT_NORMAL_TEMP \
-	if (sample) { \
-		sd1 = ((mp_sword*)(sample))[smppos]; \
-		sd2 = ((mp_sword*)(sample))[smppos+1]; \
-		sd1 =((sd1<<12)+(smpposfrac>>4)*(sd2-sd1))>>12; \
-		y = (sd1*vol)>>9; \
-	} \
-	else { \
-		y = 0; \
- 	} \
-	fetcher.fetchSampleData(y);
-
 void PlayerController::grabSampleData(mp_uint32 chnIndex, mp_sint32 count, mp_sint32 fMul, SampleDataFetcher& fetcher)
 {
 	if (!player)
 		return;	
 
-	if (mixerDataCache && (count * 2 > mixerDataCacheSize))
-	{
-		delete[] mixerDataCache;
-		mixerDataCacheSize = count * 2 * 2;		
-		mixerDataCache = new mp_sint32[mixerDataCacheSize];
-	}
-
-	if (chnIndex >= 4)
-	{
-		if ((YMscopeIndex + count) > ResamplerYM::BUFFERCOPY_LENGTH)
-		{
-			YMscopeIndex = 0;
-		}
-
-		auto s = ResamplerYM::GetInstance()->getBufferCopy(YMscopeIndex, count);
-		YMscopeIndex += count;
-		
-		for (mp_sint32 i = 0; i < count; i++)
-		{
-			fetcher.fetchSampleData((s[0] + s[1]) >> 1);
-			s += 2;
-		}
-
-		return;
-	}
-	
-	ChannelMixer* mixer = player;
-
-	ChannelMixer::TMixerChannel* chn = &mixer->channel[chnIndex];
-	
-	pp_int32 j = getCurrentBeatIndex();
-
-	if (chn->flags & ChannelMixer::MP_SAMPLE_PLAY)
+	// the mixer keeps what every channel has played, show the last fMul 
+	// frames before the one being heard stretched over count points
+	if (mixerDataCache && count > 0)
 	{
-		// this is critical
-		// it might be that the audio thread modifies the data as we are
-		// accessing it... So in the worst case we're getting a sample 
-		// but the channel state data does belong to another sample already
-		// in that case we're displaying garbage...
-		// BUT it's important that we only access sample data
-		// within the range of the current sample we have
-		ChannelMixer::TMixerChannel channel;	
-		channel.sample = chn->timeRecord[j].sample;
-		
-		if (channel.sample == NULL)
-			goto resort;
-		
-		channel.smplen = TXMSample::getSampleSizeInSamples((mp_ubyte*)channel.sample);
-		channel.flags = chn->timeRecord[j].flags;
-		channel.smppos = chn->timeRecord[j].smppos % channel.smplen;
-		channel.smpposfrac = chn->timeRecord[j].smpposfrac;
-		channel.smpadd = chn->timeRecord[j].smpadd;
-		channel.loopend = channel.loopendcopy = chn->timeRecord[j].loopend % (channel.smplen+1);
-		channel.loopstart = chn->timeRecord[j].loopstart % (channel.smplen+1);
-		if (channel.loopstart >= channel.loopend)
-			channel.flags &= ~3;
-		channel.vol = chn->timeRecord[j].volPan & 0xFFFF;
-		channel.pan = chn->timeRecord[j].volPan >> 16;
-		channel.fixedtimefrac = chn->timeRecord[j].fixedtimefrac;
-		channel.cutoff = ChannelMixer::MP_INVALID_VALUE;
-		channel.resonance = ChannelMixer::MP_INVALID_VALUE;
-//		channel.index = chnIndex; Uncomment this if you like crackly audio
-		// The scopes (which I assume is what this function is for) are currently
-		// using channel 33, to avoid interfering with playback
-		
-		channel.bitmask = chn->bitmask;
-		channel.bitshift = chn->bitshift;
-
-		if ((chnIndex == 0) || (chnIndex == 3))
-		{
-			channel.STebalanceLeft = chn->STebalanceLeft;
-		}
-		else
+		if (fMul > mixerDataCacheSize)
 		{
-			channel.STebalanceLeft = chn->STebalanceRight;
+			delete[] mixerDataCache;
+			mixerDataCacheSize = fMul * 2;		
+			mixerDataCache = new mp_sint32[mixerDataCacheSize];
 		}
-		channel.STebalanceRight = 0;
 
-		channel.smpadd = (channel.smpadd*fMul) / (!count ? 1 : count);		
-		chn = &channel;
-				
-		if (mixerDataCache && channel.smpadd <= 65536)
+		if (player->grabScopeData(chnIndex, getCurrentSamplePosition(), mixerDataCache, fMul))
 		{
-			memset(mixerDataCache, 0, count*2*sizeof(mp_sint32));
+			ChannelMixer* mixer = player;
 
-			channel.rsmpadd = (mp_sint32)((1.0 / channel.smpadd) * 65536.0);
+			// the scope holds the channel's share of the mix (left + right),
+			// undo the mixer's amplification to get back to the 16 bit range
+			// the painter expects
+			mp_sint32 scopeMul, scopeDiv;
+			if (mixer->channel[chnIndex].isymchannel)
+			{
+				// both sides at MP_YMAMPLIFY/64
+				scopeMul = 64;
+				scopeDiv = ChannelMixer::MP_YMAMPLIFY * 2;
+			}
+			else
+			{
+				// one side at MP_DMAAMPLIFY/256
+				scopeMul = 256;
+				scopeDiv = ChannelMixer::MP_DMAAMPLIFY;
+			}
 
-			// we only need the left channel as no panning is involved
-			channel.finalvoll = (channel.vol*128*256)<<6; 
-			channel.finalvolr = 0;
-			channel.rampFromVolStepL = channel.rampFromVolStepR = 0;
-			
-			mixer->addChannelToResampler(player->getCurrentResampler(), chn, mixerDataCache, count, count);
-		
 			for (mp_sint32 i = 0; i < count; i++)
-				fetcher.fetchSampleData(mixerDataCache[i*2]);
+				fetcher.fetchSampleData((mixerDataCache[(i*fMul)/count]*scopeMul) / scopeDiv);
+			return;
 		}
-		else
-		{
-			pp_int32 vol = chn->vol;	
-			mp_sint32 y;		
-			FULLMIXER_TEMPLATE(FULLMIXER_8BIT_NORMAL_TEMP, FULLMIXER_16BIT_NORMAL_TEMP, 16, 0);
-		}		
-	}
-	else
-	{
-resort:
-		for (mp_sint32 i = 0; i < count; i++)
-			fetcher.fetchSampleData(0);
 	}
+	
+	for (mp_sint32 i = 0; i < count; i++)
+		fetcher.fetchSampleData(0);
 }
 
 bool PlayerController::hasSampleData(mp_uint32 chnIndex)
@@ -1361,14 +1276,15 @@ bool PlayerController::hasSampleData(mp_uint32 chnIndex)
 	if (!player)
 		return false;	
 
-	if (chnIndex >= 4)
+	ChannelMixer* mixer = player;
+
+	// the YM chip is always running
+	if (mixer->channel[chnIndex].isymchannel)
 	{
 		return true;
 	}
 	else
 	{
-		ChannelMixer* mixer = player;
-
 		ChannelMixer::TMixerChannel* chn = &mixer->channel[chnIndex];
 
 		pp_int32 j = getCurrentBeatIndex();
@@ -98,8 +98,6 @@ private:
 	mp_sint32 mixerDataCacheSize;
 	mp_sint32* mixerDataCache;
 
-	mp_sint32 YMscopeIndex;
-
 	void assureNotSuspended();
 	void continuePlaying(bool assureNotSuspended);
 	
@@ -228,6 +226,8 @@ public:
 	bool hasSampleData(mp_uint32 chnIndex);
 
 	void setInstrumentYMSoundsMapping(const std::map<int, int>& _instrument2YMSoundsIndex, bool _activate);
+	// silence the YM2149 of this player
+	void stopYM();
 
 	friend class PlayerMaster;
 	friend class PlayerStatusTracker;
@@ -41,8 +41,6 @@
 #include "Screen.h"
 #include "PatternEditorControl.h"
 
-#include "ResamplerYM.h"
-
 
 PlayerLogic::PlayerLogic(Tracker& tracker) :
 	tracker(tracker),
@@ -115,7 +113,7 @@ void PlayerLogic::stopPlayer(PlayerController& playerController)
 {
 	playerController.stop();
 	playerController.resetPlayTimeCounter();
-	ResamplerYM::GetInstance()->Stop();
+	playerController.stopYM();
 }
 
 void PlayerLogic::stopSong()
@@ -38,6 +38,7 @@
 #include "AudioDriverManager.h"
 #include "PlayerSTD.h"
 #include "ResamplerHelper.h"
+#include "WorkerPool.h"
 
 class MasterMixerNotificationListener : public MasterMixer::MasterMixerNotificationListener
 {
@@ -95,10 +96,41 @@ void PlayerMaster::applySettingsToPlayerController(PlayerController& playerContr
 		playerController.getCriticalSection()->leave();
 	}
 	
+	if (player->getWorkerPool() != workerPool)
+	{
+		playerController.getCriticalSection()->enter();
+		player->setWorkerPool(workerPool);
+		playerController.getCriticalSection()->leave();
+	}
+	
 	if (!player->isPlaying() && wasPlaying)
 		player->resumePlaying(false);	
 }
 
+void PlayerMaster::applyMixerThreads(pp_int32 mixerThreads)
+{
+	WorkerPool* oldWorkerPool = workerPool;
+
+	pp_uint32 numThreads = mixerThreads ? mixerThreads : WorkerPool::getNumCores();
+	
+	// the thread calling the mixer is one of them
+	workerPool = numThreads > 1 ? new WorkerPool(numThreads - 1) : NULL;
+
+	// this closes the audio device
+	mixer->setWorkerPool(workerPool);
+
+	// players must let go of the old pool before it can be deleted
+	for (pp_int32 i = 0; i < playerControllers->size(); i++)
+	{
+		PlayerController& playerController = *playerControllers->get(i);
+		playerController.getCriticalSection()->enter();
+		playerController.player->setWorkerPool(workerPool);
+		playerController.getCriticalSection()->leave();
+	}
+	
+	delete oldWorkerPool;
+}
+
 const char* PlayerMaster::getPreferredAudioDriverID()
 {
 	AudioDriverManager audioDriverManager;
@@ -136,6 +168,7 @@ float PlayerMaster::convertBufferSizeToMillis(pp_uint32 sampleRate, pp_uint32 bu
 
 PlayerMaster::PlayerMaster(pp_uint32 numDevices/* = DefaultMaxDevices*/) :
 	listener(NULL),
+	workerPool(NULL),
 	oldBufferSize(getPreferredBufferSize()),
 	forcePowerOfTwoBufferSize(false),
 	multiChannelKeyJazz(true),
@@ -174,6 +207,7 @@ PlayerMaster::~PlayerMaster()
 	delete playerControllers;
 	delete mixer;
 	delete listener;
+	delete workerPool;
 }
 
 PlayerController* PlayerMaster::createPlayerController(bool fakeScopes)
@@ -270,6 +304,18 @@ bool PlayerMaster::applyNewMixerSettings(const TMixerSettings& settings, bool al
 		}
 	}
 
+	if (settings.floatOutput >= 0)
+	{
+		currentSettings.floatOutput = settings.floatOutput;
+		MasterMixer::SampleFormats sampleFormat = settings.floatOutput ? 
+			MasterMixer::SampleFormatFloat32 : MasterMixer::SampleFormatInt16;
+		if (sampleFormat != mixer->getSampleFormat())
+		{
+			mixer->setSampleFormat(sampleFormat);
+			restart = true;
+		}
+	}
+
 	if (settings.mixFreq >= 0)
 	{
 		currentSettings.mixFreq = settings.mixFreq;
@@ -297,6 +343,13 @@ bool PlayerMaster::applyNewMixerSettings(const TMixerSettings& settings, bool al
 	if (settings.resampler >= 0)
 		currentSettings.resampler = settings.resampler;
 	
+	if (settings.mixerThreads >= 0 && settings.mixerThreads != currentSettings.mixerThreads)
+	{
+		currentSettings.mixerThreads = settings.mixerThreads;
+		applyMixerThreads(settings.mixerThreads);
+		restart = true;
+	}
+	
 	// take over settings like sample rate and buffer size 
 	// those are retrieved from the master mixer and set for all players
 	// accordingly
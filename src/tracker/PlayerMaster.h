@@ -50,12 +50,17 @@ struct TMixerSettings
 	pp_int32 resampler;
 	// 0 = false, 1 = true, negative values means ignore 
 	pp_int32 ramping;
+	// 0 = 16 bit, 1 = 32 bit float (if supported by the driver), negative values means ignore 
+	pp_int32 floatOutput;
 	// NULL means ignore
 	char* audioDriverName;
     // default number of player channels
     pp_uint32 numPlayerChannels;
 	// 0 means disable virtual channels, negative value means ignore
 	pp_int32 numVirtualChannels;
+	// number of threads mixing the channels of a player, 0 = one per core, 
+	// 1 = mix on the audio thread only, negative values means ignore
+	pp_int32 mixerThreads;
 
 	TMixerSettings() :
 		mixFreq(-1),
@@ -65,9 +70,11 @@ struct TMixerSettings
 		powerOfTwoCompensation(-1),
 		resampler(-1),
 		ramping(-1),
+		floatOutput(-1),
 		audioDriverName(NULL),
         numPlayerChannels(TrackerConfig::numPlayerChannels),
-		numVirtualChannels(-1)
+		numVirtualChannels(-1),
+		mixerThreads(-1)
 	{
 	}
 
@@ -111,6 +118,9 @@ struct TMixerSettings
 		if (ramping != source.ramping)
 			return false;
 
+		if (floatOutput != source.floatOutput)
+			return false;
+
         if (numPlayerChannels != source.numPlayerChannels) {
             return false;
         }
@@ -118,6 +128,9 @@ struct TMixerSettings
 		if (numVirtualChannels != source.numVirtualChannels)
 			return false;
 
+		if (mixerThreads != source.mixerThreads)
+			return false;
+
 		return strcmp(audioDriverName, source.audioDriverName) == 0;
 	}
 	
@@ -142,6 +155,7 @@ private:
 
 	class MasterMixer* mixer;
 	class MasterMixerNotificationListener* listener;
+	class WorkerPool* workerPool;
 	PPSimpleVector<PlayerController>* playerControllers;
 	
 	TMixerSettings currentSettings;
@@ -155,6 +169,7 @@ private:
 	bool multiChannelRecord;
 	
 	void adjustSettings();
+	void applyMixerThreads(pp_int32 mixerThreads);
 	void applySettingsToPlayerController(PlayerController& playerController, const TMixerSettings& settings);
 	
 public:
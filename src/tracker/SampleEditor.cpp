@@ -190,6 +190,8 @@ void SampleEditor::prepareUndo()
 
 void SampleEditor::finishUndo()
 {
+	peakPyramid.invalidate();
+
 	if (undoStackEnabled && undoStackActivated && undoStack) 
 	{ 
 		// first of all the listener should get the chance to adjust
@@ -262,6 +264,7 @@ bool SampleEditor::revoke(const SampleUndoStackEntry* stackEntry)
 	}
 	
 	leaveCriticalSection();
+	peakPyramid.invalidate();
 	undoUserData = stackEntry->getUserData();
 	notifyListener(NotificationFetchUndoData);
 	notifyListener(NotificationChanges);
@@ -354,6 +357,8 @@ void SampleEditor::attachSample(TXMSample* sample, XModule* module)
 	this->sample = sample;
 	attachModule(module);
 
+	peakPyramid.invalidate();
+
 	resetSelection();
 	
 	notifyListener(NotificationReload);
@@ -825,6 +830,8 @@ void SampleEditor::drawSample(pp_int32 sampleIndex, float s)
 		setFloatSampleInWaveform(si, froms);
 		froms+=step;
 	}	
+
+	peakPyramid.invalidate(from, to+1);
 }
 
 void SampleEditor::endDrawing()
@@ -34,6 +34,7 @@
 #include "EditorBase.h"
 #include "Undo.h"
 #include "Singleton.h"
+#include "SamplePeakPyramid.h"
 
 struct TXMSample;
 
@@ -120,6 +121,8 @@ private:
 	bool drawing;
 	pp_int32 lastSamplePos;
 
+	SamplePeakPyramid peakPyramid;
+
 	void prepareUndo();
 	void finishUndo();
 	
@@ -139,6 +142,8 @@ public:
 	void reset();
 
 	TXMSample* getSample() { return sample; }
+	// min/max/RMS summary of the sample for drawing, brought up to date on access
+	const SamplePeakPyramid& getPeakPyramid() { peakPyramid.update(sample); return peakPyramid; }
 	pp_int32 getSampleLen() const { return sample ? sample->samplen : 0; }
 	bool isValidSample() const { return sample != NULL; }
 	bool isEmptySample() const;	
@@ -419,6 +419,15 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 	
 	mp_sint32 lasty = -(pp_int32)(sample->getSampleValue((pp_int32)(startPos*xScale))*scale);
 	
+	// more than one sample per pixel: draw the peaks of all samples
+	// covered by a column from the summary instead of picking one
+	const bool drawPeaks = xScale > 1.0f;
+	const SamplePeakPyramid* peakPyramid = drawPeaks ? &sampleEditor->getPeakPyramid() : NULL;
+	mp_sint32 lastymin = lasty, lastymax = lasty;
+	
+	PPColor rmsColor(TrackerConfig::colorSampleEditorWaveform);
+	rmsColor.interpolateFixed(PPColor(255, 255, 255), 32768);
+	
 	g->setColor(*borderColor);
 	g->setPixel(xOffset, yOffset);
 	
@@ -426,11 +435,13 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 	{
 		if ((pp_int32)((startPos+x)*xScale) < getVisibleLength())
 		{
+			bool selected = false;
 			if (sel && x >= (pp_int32)((sStart/xScale)-startPos) && x <= (pp_int32)((sEnd/xScale)-startPos) && (selectionTicker == -1))
 			{
 				g->setColor(255-dColor.r,255-dColor.g,255-dColor.b);
 				g->setPixel(xOffset + x, yOffset);
 				g->setColor(255, 255, 255);
+				selected = true;
 			}
 			else
 			{
@@ -439,6 +450,31 @@ void SampleEditorControl::paint(PPGraphicsAbstract* g)
 				g->setColor(TrackerConfig::colorSampleEditorWaveform);
 			}
 			
+			if (drawPeaks)
+			{
+				SamplePeakPyramid::Peak peak;
+				peakPyramid->query((pp_int32)((startPos+x)*xScale), (pp_int32)((startPos+x+1)*xScale), peak);
+				
+				mp_sint32 ymin = -(mp_sint32)(peak.max*scale);
+				mp_sint32 ymax = -(mp_sint32)(peak.min*scale);
+				
+				// connect to the previous column
+				mp_sint32 y1 = ymin > lastymax ? lastymax : ymin;
+				mp_sint32 y2 = ymax < lastymin ? lastymin : ymax;
+				g->drawVLine(yOffset + y1, yOffset + y2 + 1, xOffset + x);
+				
+				if (!selected)
+				{
+					mp_sint32 rms = (mp_sint32)(peak.rms*scale);
+					g->setColor(rmsColor);
+					g->drawVLine(yOffset - rms, yOffset + rms + 1, xOffset + x);
+				}
+				
+				lastymin = ymin;
+				lastymax = ymax;
+				continue;
+			}
+			
 			float findex = ((startPos+x)*xScale);
 			pp_int32 index = (pp_int32)(floor(findex));
 			pp_int32 index2 = index+1;
@@ -0,0 +1,277 @@
+/*
+ *  tracker/SamplePeakPyramid.cpp
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakPyramid.cpp
+ *  MilkyTracker
+ *
+ */
+
+#include "SamplePeakPyramid.h"
+#include "XModule.h"
+#include <math.h>
+
+SamplePeakPyramid::SamplePeakPyramid() :
+	nodes(NULL),
+	numNodes(0),
+	numLevels(0),
+	sample(NULL),
+	sampleData(NULL),
+	sampleLength(0),
+	sampleType(0),
+	loopEnd(-1),
+	dirtyStart(0),
+	dirtyEnd(0)
+{
+}
+
+SamplePeakPyramid::~SamplePeakPyramid()
+{
+	delete[] nodes;
+}
+
+void SamplePeakPyramid::allocate(pp_int32 length)
+{
+	numLevels = 0;
+	numNodes = 0;
+
+	pp_int32 size = (length + BlockSize - 1) >> BlockShift;
+	while (size > 0 && numLevels < MaxLevels)
+	{
+		levelOffsets[numLevels] = numNodes;
+		levelSizes[numLevels] = size;
+		numNodes += size;
+		numLevels++;
+
+		if (size == 1)
+			break;
+
+		size = (size + 1) >> 1;
+	}
+
+	delete[] nodes;
+	nodes = numNodes ? new Node[numNodes] : NULL;
+}
+
+pp_int32 SamplePeakPyramid::getValue(pp_int32 index) const
+{
+	// takes care of the loop area backup
+	return sample->getSampleValue(index);
+}
+
+void SamplePeakPyramid::rebuild(pp_int32 from, pp_int32 to)
+{
+	if (from < 0)
+		from = 0;
+	if (to > sampleLength)
+		to = sampleLength;
+	if (from >= to || !numLevels)
+		return;
+
+	pp_int32 first = from >> BlockShift;
+	pp_int32 last = (to - 1) >> BlockShift;
+
+	pp_int32 i;
+	for (i = first; i <= last; i++)
+	{
+		pp_int32 start = i << BlockShift;
+		pp_int32 end = start + BlockSize;
+		if (end > sampleLength)
+			end = sampleLength;
+
+		pp_int32 min = getValue(start);
+		pp_int32 max = min;
+		float sumSquares = 0.0f;
+		for (pp_int32 j = start; j < end; j++)
+		{
+			pp_int32 v = getValue(j);
+			if (v < min)
+				min = v;
+			if (v > max)
+				max = v;
+			sumSquares += (float)(v*v);
+		}
+
+		Node& node = nodes[i];
+		node.min = (pp_int16)min;
+		node.max = (pp_int16)max;
+		node.sumSquares = sumSquares;
+	}
+
+	// propagate the changed blocks upwards
+	for (pp_int32 l = 1; l < numLevels; l++)
+	{
+		first >>= 1;
+		last >>= 1;
+
+		const Node* children = nodes + levelOffsets[l-1];
+		Node* parents = nodes + levelOffsets[l];
+
+		for (i = first; i <= last; i++)
+		{
+			Node node = children[i*2];
+			if (i*2+1 < levelSizes[l-1])
+			{
+				const Node& right = children[i*2+1];
+				if (right.min < node.min)
+					node.min = right.min;
+				if (right.max > node.max)
+					node.max = right.max;
+				node.sumSquares += right.sumSquares;
+			}
+			parents[i] = node;
+		}
+	}
+}
+
+void SamplePeakPyramid::invalidate()
+{
+	// forces a full rebuild on the next update
+	sampleData = NULL;
+}
+
+void SamplePeakPyramid::invalidate(pp_int32 from, pp_int32 to)
+{
+	if (from >= to)
+		return;
+
+	if (dirtyStart >= dirtyEnd)
+	{
+		dirtyStart = from;
+		dirtyEnd = to;
+		return;
+	}
+
+	if (from < dirtyStart)
+		dirtyStart = from;
+	if (to > dirtyEnd)
+		dirtyEnd = to;
+}
+
+void SamplePeakPyramid::update(TXMSample* sample)
+{
+	if (sample == NULL || sample->sample == NULL)
+	{
+		this->sample = NULL;
+		sampleData = NULL;
+		sampleLength = 0;
+		numLevels = 0;
+		return;
+	}
+
+	pp_int32 loopEnd = (sample->type & 3) ? (pp_int32)(sample->loopstart + sample->looplen) : -1;
+
+	if (sample != this->sample ||
+		sample->sample != sampleData ||
+		(pp_int32)sample->samplen != sampleLength ||
+		(sample->type & 16) != (sampleType & 16))
+	{
+		this->sample = sample;
+		sampleData = sample->sample;
+		sampleLength = sample->samplen;
+		sampleType = sample->type;
+		this->loopEnd = loopEnd;
+
+		allocate(sampleLength);
+
+		dirtyStart = dirtyEnd = 0;
+		rebuild(0, sampleLength);
+		return;
+	}
+
+	// the few samples behind the loop end read from the loop area backup,
+	// which is smaller than a block
+	if (loopEnd != this->loopEnd)
+	{
+		if (this->loopEnd >= 0)
+			invalidate(this->loopEnd, this->loopEnd + BlockSize);
+		if (loopEnd >= 0)
+			invalidate(loopEnd, loopEnd + BlockSize);
+
+		this->loopEnd = loopEnd;
+	}
+	sampleType = sample->type;
+
+	if (dirtyStart < dirtyEnd)
+	{
+		rebuild(dirtyStart, dirtyEnd);
+		dirtyStart = dirtyEnd = 0;
+	}
+}
+
+void SamplePeakPyramid::query(pp_int32 from, pp_int32 to, Peak& peak) const
+{
+	if (from < 0)
+		from = 0;
+	if (to > sampleLength)
+		to = sampleLength;
+
+	if (from >= to || sample == NULL)
+	{
+		peak.min = peak.max = 0;
+		peak.rms = 0.0f;
+		return;
+	}
+
+	pp_int32 min = 32767, max = -32768;
+	float sumSquares = 0.0f;
+
+	pp_int32 pos = from;
+	while (pos < to)
+	{
+		if (!(pos & (BlockSize - 1)) && pos + BlockSize <= to && numLevels)
+		{
+			// take the biggest node which starts here and fits into the range
+			pp_int32 l = 0;
+			pp_int32 index = pos >> BlockShift;
+			pp_int32 size = BlockSize;
+			while (l + 1 < numLevels && !(index & 1) && pos + (size << 1) <= to)
+			{
+				index >>= 1;
+				size <<= 1;
+				l++;
+			}
+
+			const Node& node = nodes[levelOffsets[l] + index];
+			if (node.min < min)
+				min = node.min;
+			if (node.max > max)
+				max = node.max;
+			sumSquares += node.sumSquares;
+			pos += size;
+		}
+		else
+		{
+			pp_int32 v = getValue(pos);
+			if (v < min)
+				min = v;
+			if (v > max)
+				max = v;
+			sumSquares += (float)(v*v);
+			pos++;
+		}
+	}
+
+	peak.min = min;
+	peak.max = max;
+	peak.rms = sqrtf(sumSquares / (float)(to - from));
+}
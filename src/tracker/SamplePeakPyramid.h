@@ -0,0 +1,104 @@
+/*
+ *  tracker/SamplePeakPyramid.h
+ *
+ *  Copyright 2009 Peter Barth
+ *
+ *  This file is part of Milkytracker.
+ *
+ *  Milkytracker is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  Milkytracker is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with Milkytracker.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *  SamplePeakPyramid.h
+ *  MilkyTracker
+ *
+ *  Min/max/RMS summary of a sample at multiple resolutions. Each level
+ *  halves the one below, the lowest level summarizes blocks of
+ *  BlockSize samples. Any range of the sample can be summarized by
+ *  combining O(log n) nodes, so the sample editor can draw real peaks
+ *  at any zoom level without touching the sample data.
+ *  Changed ranges are rebuilt lazily on the next update().
+ */
+
+#ifndef __SAMPLEPEAKPYRAMID_H__
+#define __SAMPLEPEAKPYRAMID_H__
+
+#include "BasicTypes.h"
+
+struct TXMSample;
+
+class SamplePeakPyramid
+{
+public:
+	struct Peak
+	{
+		pp_int32 min, max;
+		float rms;
+	};
+
+private:
+	enum
+	{
+		BlockShift = 4,
+		BlockSize = 1 << BlockShift,
+		MaxLevels = 32
+	};
+
+	struct Node
+	{
+		pp_int16 min, max;
+		float sumSquares;
+	};
+
+	Node* nodes;
+	pp_int32 numNodes;
+	pp_int32 numLevels;
+	pp_int32 levelOffsets[MaxLevels];
+	pp_int32 levelSizes[MaxLevels];
+
+	// what the summary has been built from
+	TXMSample* sample;
+	const void* sampleData;
+	pp_int32 sampleLength;
+	pp_int32 sampleType;
+	pp_int32 loopEnd;
+
+	// range of samples which need to be rebuilt, empty if dirtyStart >= dirtyEnd
+	pp_int32 dirtyStart, dirtyEnd;
+
+	void allocate(pp_int32 length);
+	void rebuild(pp_int32 from, pp_int32 to);
+
+	pp_int32 getValue(pp_int32 index) const;
+
+public:
+	SamplePeakPyramid();
+	~SamplePeakPyramid();
+
+	// whole sample has changed
+	void invalidate();
+	// samples [from, to) have changed
+	void invalidate(pp_int32 from, pp_int32 to);
+
+	// bring the summary up to date, only dirty blocks are rebuilt
+	// unless the sample has been reallocated
+	void update(TXMSample* sample);
+
+	// summarize samples [from, to), values are in sample units
+	// ([-128,127] for 8 bit samples, [-32768,32767] for 16 bit samples)
+	void query(pp_int32 from, pp_int32 to, Peak& peak) const;
+};
+
+#endif
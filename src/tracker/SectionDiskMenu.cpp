@@ -45,6 +45,7 @@
 #include "StaticText.h"
 #include "ListBox.h"
 #include "ListBoxFileBrowser.h"
+#include "PlayTimeScanner.h"
 #include "CheckBox.h"
 #include "CheckBoxLabel.h"
 #include "PPUIConfig.h"
@@ -772,6 +773,7 @@ void SectionDiskMenu::init(pp_int32 px, pp_int32 py)
 	listBoxFiles->setDirectorySuffixPathSeperator();
 	listBoxFiles->setSortAscending(sortAscending);
 	listBoxFiles->setColorQueryListener(colorQueryListener);
+	listBoxFiles->setFileInfoProvider(tracker.playTimeScanner);
 	container->addControl(listBoxFiles);
 	fileBrowserExtent = listBoxFiles->getSize();
 
@@ -981,6 +983,17 @@ bool SectionDiskMenu::isFileBrowserVisible()
 	return listBoxFiles->isVisible();
 }
 
+void SectionDiskMenu::refreshFileInfo()
+{
+	if (listBoxFiles == NULL)
+		return;
+		
+	listBoxFiles->refreshFileInfo();
+	
+	if (isFileBrowserVisible())
+		tracker.screen->paintControl(listBoxFiles);
+}
+
 bool SectionDiskMenu::fileBrowserHasFocus()
 {
 	return tracker.screen->hasFocus(sectionContainer) && listBoxFiles->gotFocus();
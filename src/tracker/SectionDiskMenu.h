@@ -123,6 +123,9 @@ public:
 	void setCycleFilenames(bool cycleFilenames);
 	
 	PPListBoxFileBrowser* getListBoxFiles() { return listBoxFiles; }
+	
+	// file information (play times) has come in
+	void refreshFileInfo();
 
 private:
 	void prepareSection();
@@ -167,6 +167,24 @@ void TabManager::openNewTab(PlayerController* playerController/* = NULL*/, Modul
 	selectModuleEditor(doc);
 }
 
+void TabManager::replaceModuleEditor(ModuleEditor* moduleEditor)
+{
+	ASSERT(currentDocument && currentDocument->moduleEditor == tracker.moduleEditor);
+	
+	ModuleEditor* oldModuleEditor = currentDocument->moduleEditor;
+	PlayerController* playerController = currentDocument->playerController;
+	
+	playerController->attachModuleEditor(moduleEditor);					
+	moduleEditor->attachPlayerCriticalSection(playerController->getCriticalSection());
+	playerController->setSpeed(moduleEditor->getSongBPM(), moduleEditor->getSongTickSpeed());	
+
+	currentDocument->moduleEditor = moduleEditor;
+	tracker.moduleEditor = moduleEditor;
+	tracker.updateAfterTabSwitch();
+	
+	delete oldModuleEditor;
+}
+
 void TabManager::switchToTab(pp_uint32 index)
 {
 	TabHeaderControl* tabHeader = getTabHeaderControl();
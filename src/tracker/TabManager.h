@@ -85,6 +85,8 @@ public:
 	bool getResumeOnTabSwitch() const { return resumeOnTabSwitch; }
 
 	void openNewTab(PlayerController* playerController = NULL, ModuleEditor* moduleEditor = NULL);	
+	// the current tab gets moduleEditor, the one it had is deleted
+	void replaceModuleEditor(ModuleEditor* moduleEditor);
 	void switchToTab(pp_uint32 index);
 	void closeTab(pp_int32 index = -1);
 	ModuleEditor* getModuleEditorFromTabIndex(pp_int32 index);
@@ -33,6 +33,10 @@
 #include "SamplePlayer.h"
 #include "SimpleVector.h"
 #include "ModuleEditor.h"
+#include "ModuleLoader.h"
+#include "PlayTimeScanner.h"
+#include "SongAnalysis.h"
+#include "PPSystem.h"
 #include "TabTitleProvider.h"
 #include "PPUI.h"
 #include "PatternTools.h"
@@ -88,6 +92,24 @@
 #endif
 
 
+struct Tracker::PendingModule
+{
+	PPSystemString fileName;
+	// owned, see loadingParameters.decompressedFile
+	XMBufferFile* decompressedFile;
+	
+	PendingModule(const PPSystemString& fileName, XMBufferFile* decompressedFile) :
+		fileName(fileName),
+		decompressedFile(decompressedFile)
+	{
+	}
+	
+	~PendingModule()
+	{
+		delete decompressedFile;
+	}
+};
+
 static inline pp_int32 myMod(pp_int32 a, pp_int32 b)
 {
 	pp_int32 res = a%b;
@@ -165,6 +187,21 @@ Tracker::Tracker() :
 	
 	moduleEditor = tabManager->createModuleEditor();
 
+	moduleLoader = new ModuleLoader();
+	moduleLoaderTarget = NULL;
+	moduleLoaderTargetChanged = false;
+	moduleLoaderProgress = -1;
+	pendingModules = new PPSimpleVector<PendingModule>();
+
+#ifdef WIN32
+	analysisCache = new SongAnalysisCache(System::getConfigFileName(_T("songs.cache")));
+#else
+	PPSystemString analysisCacheFileName(System::getConfigFileName());
+	analysisCacheFileName.append("_songs.cache");
+	analysisCache = new SongAnalysisCache(analysisCacheFileName);
+#endif
+	playTimeScanner = new PlayTimeScanner(*analysisCache);
+
 	playerLogic = new PlayerLogic(*this);
 	recorderLogic = new RecorderLogic(*this);
 
@@ -208,6 +245,13 @@ Tracker::Tracker() :
 
 Tracker::~Tracker()
 {
+	// stops a module that's still loading
+	delete moduleLoader;
+	delete pendingModules;
+	delete playTimeScanner;
+	// writes back the play times found in this session
+	delete analysisCache;
+
 	delete eventKeyDownBindingsMilkyTracker;
 	delete eventKeyDownBindingsFastTracker;
 	
@@ -416,6 +460,8 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 	else if (event->getID() == eTimer)
 	{
 		doFollowSong();
+		updateLoadingInBackground();
+		updatePlayTimeScanner();
 	}
 #ifndef __LOWRES__
 	else if (event->getID() == eLMouseDown)
@@ -978,13 +1024,13 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 
 			case BUTTON_YM_TEST:
 			{
-				runBLSBatch(ResamplerYM::GetInstance()->GetSndSynFilename(), "SynthYMrun" BATCH_SUFFIX ".bat");
+				runBLSBatch(ResamplerYM::GetSndSynFilename(), "SynthYMrun" BATCH_SUFFIX ".bat");
 				break;
 			}
 
 			case BUTTON_YM_EDIT:
 			{
-				runBLSBatch(ResamplerYM::GetInstance()->GetSndSynFilename(), "SynthYMedit.bat");
+				runBLSBatch(ResamplerYM::GetSndSynFilename(), "SynthYMedit.bat");
 				break;
 			}
 
@@ -1012,7 +1058,7 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 			{
 				playerLogic->stopSong();
 
-				if ( ResamplerYM::GetInstance()->Reload() )
+				if ( ResamplerYM::Reload() )
 				{
 					fillYMSoundsListBox(listBoxYMsounds);
 					refreshYMSoundsIntrumentsMapping();
@@ -1028,9 +1074,9 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 
 					if (openPanel->runModal() == PPModalDialog::ReturnCodeOK)
 					{
-						ResamplerYM::GetInstance()->SetSndSynFilename(openPanel->getFileName().getStrBuffer());
+						ResamplerYM::SetSndSynFilename(openPanel->getFileName().getStrBuffer());
 
-						if (ResamplerYM::GetInstance()->Reload())
+						if (ResamplerYM::Reload())
 						{
 							fillYMSoundsListBox(listBoxYMsounds);
 							refreshYMSoundsIntrumentsMapping();
@@ -1041,8 +1087,8 @@ pp_int32 Tracker::handleEvent(PPObject* sender, PPEvent* event)
 						{
 							char temp[512];
 
-							sprintf(temp, "Error loading %s", ResamplerYM::GetInstance()->GetSndSynFilename());
-							PPMessageBox messageBox(nullptr, temp, ResamplerYM::GetInstance()->GetError());
+							sprintf(temp, "Error loading %s", ResamplerYM::GetSndSynFilename());
+							PPMessageBox messageBox(nullptr, temp, ResamplerYM::GetError());
 							messageBox.runModal();
 						}
 					}
@@ -2327,21 +2373,38 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 	FileIdentificator::FileTypes type = fileIdentificator->getFileType();
 	delete fileIdentificator;
 	// check for compression
+	XMBufferFile* decompressedFile = NULL;
 	if (type == FileIdentificator::FileTypeCompressed)
 	{
 		// if this is compressed, we try to uncompress it
 		// and choose that file type
-		PPSystemString tempFile(ModuleEditor::getTempFilename());
+		decompressedFile = new XMBufferFile(fileName);
 		Decompressor decompressor(fileName);
-		if (decompressor.decompress(tempFile, (DecompressorBase::Hints)fileTypeToHint(FileTypes::FileTypeAllFiles)))
+		if (decompressor.decompress(*decompressedFile, (DecompressorBase::Hints)fileTypeToHint(FileTypes::FileTypeAllFiles)))
 		{
-			fileIdentificator = new FileIdentificator(tempFile);
-			type = fileIdentificator->getFileType();
-			delete fileIdentificator;
-			Decompressor::removeFile(tempFile);
+			// modules are told apart in memory, anything else 
+			// needs the file identificator
+			if (FileIdentificator::isModule(*decompressedFile))
+			{
+				type = FileIdentificator::FileTypeModule;
+			}
+			else
+			{
+				PPSystemString tempFile(ModuleEditor::getTempFilename());
+				saveDecompressedFile(*decompressedFile, tempFile);
+				
+				fileIdentificator = new FileIdentificator(tempFile);
+				type = fileIdentificator->getFileType();
+				delete fileIdentificator;
+				Decompressor::removeFile(tempFile);
+				
+				delete decompressedFile;
+				decompressedFile = NULL;
+			}
 		}
 		else
 		{
+			delete decompressedFile;
 			showMessageBox(MESSAGEBOX_UNIVERSAL, "Unrecognized type/corrupt file", MessageBox_OK);			
 			return false;
 		}
@@ -2350,6 +2413,8 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 	switch (type)
 	{
 		case FileIdentificator::FileTypeModule:
+			// hand the decompressed module over, no need to decompress it twice
+			loadingParameters.decompressedFile = decompressedFile;
 			return loadTypeFromFile(FileTypes::FileTypeSongAllModules, fileName);		
 		case FileIdentificator::FileTypeInstrument:
 			return loadTypeFromFile(FileTypes::FileTypeSongAllInstruments, fileName);
@@ -2364,10 +2429,15 @@ bool Tracker::loadGenericFileType(const PPSystemString& fileName)
 	}
 }
 
+void Tracker::saveDecompressedFile(XMBufferFile& decompressedFile, const PPSystemString& fileName)
+{
+	XMFile f(fileName, true);
+	f.write(decompressedFile.getBuffer(), 1, decompressedFile.size());
+}
+
 bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bool suspendPlayer, bool repaint, bool saveCheck)
 {
 	loadingParameters.deleteFile = false;
-	loadingParameters.didOpenTab = false;
 	loadingParameters.eType = eType;
 	loadingParameters.filename = fileName;	
 	loadingParameters.preferredFilename = fileName;
@@ -2376,21 +2446,10 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 
 	loadingParameters.res = true;
 	
-	if (saveCheck && eType == FileTypes::FileTypeSongAllModules && !checkForChangesOpenModule())
-		return false;
-	
 	loadingParameters.lastError = "Error while loading/unknown format";	
 
 	signalWaitState(true);
 
-	if (eType == FileTypes::FileTypeSongAllModules &&
-		settingsDatabase->restore("TABS_LOADMODULEINNEWTAB")->getBoolValue() &&
-		(moduleEditor->hasChanged() || !moduleEditor->isEmpty()))
-	{
-		loadingParameters.didOpenTab = true;
-		tabManager->openNewTab();
-	}
-
 	bool rowPlay = playerController->isPlayingRowOnly();
 	loadingParameters.wasPlaying = rowPlay ? false : (playerController->isPlaying() || playerController->isPlayingPattern());
 	loadingParameters.wasPlayingPattern = rowPlay ? false : playerController->isPlayingPattern();
@@ -2409,25 +2468,25 @@ bool Tracker::prepareLoading(FileTypes eType, const PPSystemString& fileName, bo
 	if (type == FileIdentificator::FileTypeCompressed)
 	{
 		// if this is compressed, try to decompress
-		PPSystemString tempFile(ModuleEditor::getTempFilename());
+		XMBufferFile decompressedFile(fileName);
 		Decompressor decompressor(fileName);
-		if (decompressor.decompress(tempFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
-		{
-			// we compressed to a temporary file
-			// load that instead, but keep the original file name as preferred 
-			// base name for the module we're going to edit
-			loadingParameters.preferredFilename = loadingParameters.filename;
-			loadingParameters.filename = tempFile;
-			// delete file after loading, it's temporary
-			loadingParameters.deleteFile = true;
-		}
-		else
+		if (!decompressor.decompress(decompressedFile, (DecompressorBase::Hints)fileTypeToHint(eType)))
 		{
 			loadingParameters.lastError = "Unrecognized type/corrupt file";
 			loadingParameters.res = false;
 			finishLoading();
 			return false;
 		}
+
+		// the loaders want a file, write a temporary one
+		// and load that instead, but keep the original file name as 
+		// preferred base name for what we're going to edit
+		PPSystemString tempFile(ModuleEditor::getTempFilename());
+		saveDecompressedFile(decompressedFile, tempFile);
+
+		loadingParameters.filename = tempFile;
+		// delete file after loading, it's temporary
+		loadingParameters.deleteFile = true;
 	}
 	
 	return true;
@@ -2456,36 +2515,211 @@ bool Tracker::finishLoading()
 	
 	if (loadingParameters.deleteFile)
 		Decompressor::removeFile(loadingParameters.filename);
-		
-	if (!loadingParameters.res && loadingParameters.didOpenTab)
-		tabManager->closeTab();
 	
 	refreshYMSoundsIntrumentsMapping();
 
 	return loadingParameters.abortLoading ? true : loadingParameters.res;
 }
 
+bool Tracker::loadModuleInBackground(const PPSystemString& fileName, bool saveCheck)
+{
+	// loadGenericFileType() might have decompressed the module already
+	XMBufferFile* decompressedFile = loadingParameters.decompressedFile;
+	loadingParameters.decompressedFile = NULL;
+
+	// one module at a time, the others wait for their turn. There's no 
+	// asking for the changes then, a tab that has been edited by the time 
+	// a module is done loading is never replaced
+	if (moduleLoader->isLoading())
+	{
+		pendingModules->add(new PendingModule(fileName, decompressedFile));
+		return true;
+	}
+
+	if (saveCheck && !checkForChangesOpenModule())
+	{
+		delete decompressedFile;
+		return false;
+	}
+	
+	startLoadingInBackground(fileName, decompressedFile, true);
+	
+	return true;
+}
+
+void Tracker::startLoadingInBackground(const PPSystemString& fileName, XMBufferFile* decompressedFile, bool dropChanges)
+{
+	ASSERT(!moduleLoader->isLoading());
+
+	// decompressing can take as long as loading, leave it to the loader too
+	bool decompress = false;
+	if (decompressedFile == NULL)
+	{
+		FileIdentificator* fileIdentificator = new FileIdentificator(fileName);
+		decompress = fileIdentificator->getFileType() == FileIdentificator::FileTypeCompressed;
+		delete fileIdentificator;
+	}
+	
+	moduleLoaderTarget = moduleEditor;
+	moduleLoaderProgress = -1;
+
+	// the changes made so far have been saved or given up already, only 
+	// edits from now on keep the module from replacing this tab
+	bool newTab = settingsDatabase->restore("TABS_LOADMODULEINNEWTAB")->getBoolValue() && 
+		(moduleEditor->hasChanged() || !moduleEditor->isEmpty());
+	moduleLoaderTargetChanged = dropChanges && !newTab && moduleEditor->hasChanged();
+	if (moduleLoaderTargetChanged)
+		moduleEditor->clearChanged();
+	
+	moduleLoader->start(tabManager->createModuleEditor(), fileName, decompressedFile, decompress,
+						settingsDatabase->restore("AUTOESTPLAYTIME")->getBoolValue() ? analysisCache : NULL);
+
+	updateLoadingInBackground();
+}
+
+void Tracker::loadNextModuleInBackground()
+{
+	PendingModule* pendingModule = pendingModules->removeNoDestroy(0);
+	if (pendingModule == NULL)
+		return;
+	
+	startLoadingInBackground(pendingModule->fileName, pendingModule->decompressedFile, false);
+
+	pendingModule->decompressedFile = NULL;
+	delete pendingModule;
+}
+
+void Tracker::cancelLoadingInBackground()
+{
+	pendingModules->clear();
+
+	// the loader gives up at the next sample, it's reaped when it 
+	// has finished like any other load
+	if (moduleLoader->isLoading())
+		moduleLoader->cancel();
+}
+
+void Tracker::updateLoadingInBackground()
+{
+	if (!moduleLoader->isLoading())
+		return;
+	
+	if (moduleLoader->isFinished())
+	{
+		finishLoadingInBackground();
+		loadNextModuleInBackground();
+		return;
+	}
+	
+	pp_int32 progress = moduleLoader->getProgress();
+	if (progress == moduleLoaderProgress)
+		return;
+	
+	moduleLoaderProgress = progress;
+	
+	char buffer[32];
+	sprintf(buffer, " (%i%%)", progress);
+	
+	PPSystemString title = "BlitSTracker - Loading ";
+	title.append(moduleLoader->getFileName().stripPath());
+	title.append(buffer);
+	screen->setTitle(title);
+}
+
+void Tracker::finishLoadingInBackground()
+{
+	const PPSystemString fileName = moduleLoader->getFileName();
+	const bool cancelled = moduleLoader->isCancelled();
+
+	bool res;
+	ModuleEditor* loadedModuleEditor = moduleLoader->takeModuleEditor(res);
+	
+	// the current tab has been edited while loading (it might not even be
+	// the tab the module was meant for), don't throw that away
+	bool newTab = moduleEditor->hasChanged() ||
+		(settingsDatabase->restore("TABS_LOADMODULEINNEWTAB")->getBoolValue() && !moduleEditor->isEmpty());
+	
+	// the changes given up for the module count again if it doesn't 
+	// replace the tab they were made in (and that's still open)
+	if (moduleLoaderTargetChanged && !(res && !newTab && moduleEditor == moduleLoaderTarget))
+	{
+		for (pp_int32 i = 0; i < tabManager->getNumTabs(); i++)
+			if (tabManager->getModuleEditorFromTabIndex(i) == moduleLoaderTarget)
+				moduleLoaderTarget->setChanged();
+	}
+	
+	moduleLoaderTarget = NULL;
+	moduleLoaderTargetChanged = false;
+	
+	if (!res)
+	{
+		delete loadedModuleEditor;
+		updateWindowTitle(moduleEditor->getModuleFileName());
+		if (!cancelled)
+			showMessageBox(MESSAGEBOX_UNIVERSAL, "Error while loading/unknown format", MessageBox_OK);	
+		return;
+	}
+	
+	ModuleEditor::loadSynthSounds(fileName);
+	
+	bool rowPlay = playerController->isPlayingRowOnly();
+	bool wasPlaying = rowPlay ? false : (playerController->isPlaying() || playerController->isPlayingPattern());
+	bool wasPlayingPattern = rowPlay ? false : playerController->isPlayingPattern();
+	
+	if (newTab)
+	{
+		PlayerController* newPlayerController = tabManager->createPlayerController();
+		if (newPlayerController == NULL)
+		{
+			delete loadedModuleEditor;
+			updateWindowTitle(moduleEditor->getModuleFileName());
+			showMessageBox(MESSAGEBOX_UNIVERSAL, "Too many open modules.", MessageBox_OK);	
+			return;
+		}
+		
+		tabManager->openNewTab(newPlayerController, loadedModuleEditor);
+		wasPlaying = wasPlayingPattern = false;
+	}
+	else
+	{
+		scopesControl->enable(false);
+		playerController->suspendPlayer();
+
+		tabManager->replaceModuleEditor(loadedModuleEditor);
+	}
+	
+	updateAfterLoad(true, wasPlaying, wasPlayingPattern);
+	
+	if (!newTab)
+	{
+		playerController->resumePlayer(true);
+		scopesControl->enable(true);
+	}
+
+	RefreshSndSynFilename();
+	fillYMSoundsListBox(listBoxYMsounds);
+	refreshYMSoundsIntrumentsMapping();
+	screen->paint();
+	updateWindowTitle(moduleEditor->getModuleFileName());
+}
+
+void Tracker::updatePlayTimeScanner()
+{
+	if (playTimeScanner->hasNewPlayTimes())
+		sectionDiskMenu->refreshFileInfo();
+}
+
 bool Tracker::loadTypeFromFile(FileTypes eType, const PPSystemString& fileName, bool suspendPlayer/* = true*/, bool repaint/* = true*/, bool saveCheck/* = true*/)
 {
+	if (eType == FileTypes::FileTypeSongAllModules)
+		return loadModuleInBackground(fileName, saveCheck);
+
 	bool res = prepareLoading(eType, fileName, suspendPlayer, repaint, saveCheck);
 	if (!res)
 		return false;
 	
 	switch (eType)
 	{
-		case FileTypes::FileTypeSongAllModules:
-		{
-			if (loadingParameters.preferredFilename.length())
-				loadingParameters.res = moduleEditor->openSong(loadingParameters.filename,
-				loadingParameters.preferredFilename);
-			else
-				loadingParameters.res = moduleEditor->openSong(loadingParameters.filename,
-				NULL);
-			
-			updateAfterLoad(loadingParameters.res, loadingParameters.wasPlaying, loadingParameters.wasPlayingPattern);			
-			break;
-		}
-			
 		case FileTypes::FileTypePatternXP:
 		{
 			loadingParameters.res = getPatternEditor()->loadExtendedPattern(loadingParameters.filename);
@@ -2837,7 +3071,7 @@ bool Tracker::saveTypeWithDialog(FileTypes eSaveType, EventListenerInterface* fi
 
 void Tracker::RefreshSndSynFilename()
 {
-	PPString filename(ResamplerYM::GetInstance()->GetSndSynFilename());
+	PPString filename(ResamplerYM::GetSndSynFilename());
 
 	for (unsigned i = 0 ; i < filename.length() ; i++)
 		if (filename.charAt(i) == '\\')
@@ -38,7 +38,11 @@ template<class Type>
 class PPSimpleVector;
 
 class PPScreen;
+class XMBufferFile;
 class ModuleEditor;
+class ModuleLoader;
+class SongAnalysisCache;
+class PlayTimeScanner;
 class PatternEditor;
 class SampleEditor;
 class EnvelopeEditor;
@@ -110,6 +114,18 @@ private:
 	PlayerController* playerController;
 	PlayerMaster* playerMaster;
 	ModuleEditor* moduleEditor;
+	ModuleLoader* moduleLoader;
+	// module editor that was current when the background loading started
+	ModuleEditor* moduleLoaderTarget;
+	// its changes were given up for the module being loaded
+	bool moduleLoaderTargetChanged;
+	pp_int32 moduleLoaderProgress;
+	// modules waiting for the one that's loading, e.g. several dropped files
+	struct PendingModule;
+	PPSimpleVector<PendingModule>* pendingModules;
+	// play times of songs which have been loaded or listed before
+	SongAnalysisCache* analysisCache;
+	PlayTimeScanner* playTimeScanner;
 	class PlayerLogic* playerLogic;
 	class RecorderLogic* recorderLogic;
 	
@@ -364,12 +380,13 @@ private:
 		bool wasPlayingPattern;	
 		bool abortLoading;
 		bool deleteFile;
-		bool didOpenTab;
+		// decompressed module, handed to the module loader instead of filename
+		XMBufferFile* decompressedFile;
 		
 		TPrepareLoadingParameters() :
 			abortLoading(false),
 			deleteFile(false),
-			didOpenTab(false)
+			decompressedFile(NULL)
 		{
 		}
 	} loadingParameters;
@@ -381,6 +398,8 @@ private:
 
 	bool loadGenericFileType(const PPSystemString& fileName);
 
+	static void saveDecompressedFile(XMBufferFile& decompressedFile, const PPSystemString& fileName);
+
 	bool prepareLoading(FileTypes eType, 
 						const PPSystemString& fileName, 
 						bool suspendPlayer, 
@@ -389,6 +408,15 @@ private:
 
 	bool finishLoading();
 
+	// modules are loaded in the background, the song is handed over in one go
+	bool loadModuleInBackground(const PPSystemString& fileName, bool saveCheck);
+	void startLoadingInBackground(const PPSystemString& fileName, XMBufferFile* decompressedFile, bool dropChanges);
+	void loadNextModuleInBackground();
+	void cancelLoadingInBackground();
+	void updateLoadingInBackground();
+	void finishLoadingInBackground();
+	void updatePlayTimeScanner();
+
 	bool loadTypeFromFile(FileTypes eType, 
 						  const PPSystemString& fileName, 
 						  bool suspendPlayer = true, 
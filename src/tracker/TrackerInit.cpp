@@ -685,7 +685,7 @@ void Tracker::initListboxesSection(pp_int32 x, pp_int32 y)
 	button->setText("x");
 	container->addControl(button);	
 
-	PPStaticText* staticTextymsoundfilename = new PPStaticText(STATICTEXT_YMSOUNDFILENAME, NULL, NULL, PPPoint(offsetx+tinyButtonHeight, offsety+2), ResamplerYM::GetInstance()->GetSndSynFilename(), true);
+	PPStaticText* staticTextymsoundfilename = new PPStaticText(STATICTEXT_YMSOUNDFILENAME, NULL, NULL, PPPoint(offsetx+tinyButtonHeight, offsety+2), ResamplerYM::GetSndSynFilename(), true);
 	staticTextymsoundfilename->setFont(PPFont::getFont(PPFont::FONT_TINY));
 
 	container->addControl(staticTextymsoundfilename);
@@ -440,9 +440,12 @@ void Tracker::eventKeyDownBinding_Stop()
 	if (isActiveEditing())
 		return;
 
+	// stop loading too
+	cancelLoadingInBackground();
+
 	// is already playing? stop
 	playerController->resetPlayTimeCounter();
-	ResamplerYM::GetInstance()->Stop();
+	playerController->stopYM();
 
 	// stop song and reset main volume
 	ensureSongStopped(true, false);
@@ -78,6 +78,7 @@ void Tracker::buildDefaultSettings()
 	settingsDatabase->store("MIXERSHIFT", 1);
 	settingsDatabase->store("RAMPING", 1);
 	settingsDatabase->store("INTERPOLATION", MixerSettings::MIXER_BLS / 2);
+	settingsDatabase->store("FLOATOUTPUT", 0);
 	settingsDatabase->store("MIXERFREQ", PlayerMaster::getPreferredSampleRate());
 #ifdef __FORCEPOWEROFTWOBUFFERSIZE__
 	settingsDatabase->store("FORCEPOWEROFTWOBUFFERSIZE", 1);
@@ -186,6 +187,8 @@ void Tracker::buildDefaultSettings()
 	settingsDatabase->store("SAMPLEEDITORLASTVALUES", "");
 	// no virtual channels for instrument playback
 	settingsDatabase->store("VIRTUALCHANNELS", 0);
+	// mix channels on the audio thread only
+	settingsDatabase->store("MIXERTHREADS", 1);
     // default number of XM channel limit
     settingsDatabase->store("XMCHANNELLIMIT", 32);
 	// enable multichn recording by default
@@ -286,6 +289,10 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		settings.resampler = v2;
 	}
+	else if (theKey->getKey().compareTo("FLOATOUTPUT") == 0)
+	{
+		settings.floatOutput = v2;
+	}
 	else if (theKey->getKey().compareTo("FORCEPOWEROFTWOBUFFERSIZE") == 0)
 	{
 		settings.powerOfTwoCompensation = v2;
@@ -340,6 +347,11 @@ void Tracker::applySettingByKey(PPDictionaryKey* theKey, TMixerSettings& setting
 	{
 		settings.numVirtualChannels = v2;
 	}
+	// ---------------- Mixer threads -------------------
+	else if (theKey->getKey().compareTo("MIXERTHREADS") == 0)
+	{
+		settings.mixerThreads = v2;
+	}
     // ---------------- XM channel limit -------------------
     else if (theKey->getKey().compareTo("XMCHANNELLIMIT") == 0)
     {
@@ -626,9 +638,11 @@ void Tracker::getMixerSettingsFromDatabase(TMixerSettings& mixerSettings,
 	mixerSettings.powerOfTwoCompensation = currentSettings.restore("FORCEPOWEROFTWOBUFFERSIZE")->getIntValue();
 	mixerSettings.resampler = currentSettings.restore("INTERPOLATION")->getIntValue();
 	mixerSettings.ramping = currentSettings.restore("RAMPING")->getIntValue();
+	mixerSettings.floatOutput = currentSettings.restore("FLOATOUTPUT")->getIntValue();
 	mixerSettings.setAudioDriverName(currentSettings.restore("AUDIODRIVER")->getStringValue());
     mixerSettings.numPlayerChannels = currentSettings.restore("XMCHANNELLIMIT")->getIntValue();
 	mixerSettings.numVirtualChannels = currentSettings.restore("VIRTUALCHANNELS")->getIntValue();
+	mixerSettings.mixerThreads = currentSettings.restore("MIXERTHREADS")->getIntValue();
 }
 
 void Tracker::applySettings(TrackerSettingsDatabase* newSettings,
@@ -56,6 +56,7 @@
 #include "SectionQuickOptions.h"
 #include "Tools.h"
 #include "TitlePageManager.h"
+#include "SongAnalysis.h"
 #include "version.h"
 
 bool Tracker::checkForChanges(ModuleEditor* moduleEditor/* = NULL*/)
@@ -223,6 +224,8 @@ bool Tracker::shutDown()
 		settingsDatabase->serialize(f);
 	} // isOpenForWriting
 
+	analysisCache->save();
+
 	return true;
 }
 
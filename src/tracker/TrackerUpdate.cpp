@@ -207,8 +207,8 @@ bool Tracker::updatePlayTime()
 
 	sprintf(buffer,"%02i:%02i:%02i", hours, minutes, seconds);
 
-	playtime = -1; 
-	if (playtime == -1)
+	playtime = moduleEditor->getEstimatedPlayTime();
+	if (playtime < 0)
 	{
 		// strcpy(buffer2,"(--:--:--)");
 		// believe it or not, the VC 6.0 compiler
@@ -225,6 +225,10 @@ bool Tracker::updatePlayTime()
 		buffer2[9] = ')';
 		buffer2[10] = 0;
 	}
+	else
+	{
+		sprintf(buffer2, "(%02i:%02i:%02i)", (playtime / 3600) % 100, (playtime / 60) % 60, playtime % 60);
+	}
 	
 	strcat(buffer, buffer2);
 	
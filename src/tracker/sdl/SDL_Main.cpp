@@ -82,7 +82,9 @@
 #endif
 // --------------------------------------------------------------------------
 
-static SDL_TimerID			timer;
+// Frame clock, in performance counter units
+static Uint64				frameInterval		= 0;
+static Uint64				nextFrame			= 0;
 
 // Tracker globals
 static PPScreen*			myTrackerScreen		= NULL;
@@ -108,8 +110,6 @@ static MouseState mouseLeft = { 0, PPPoint(0,0), 0, false, 0 };
 static MouseState mouseRight = { 0, PPPoint(0,0), 0, false, 0 };
 static MouseState mouseMiddle = { 0, PPPoint(0,0), 0, false, 0 };
 
-static pp_uint32	timerTicker				= 0;
-
 static PPPoint		p;
 
 // This needs to be visible from outside
@@ -162,29 +162,26 @@ enum SDLUserEvents
 	SDLUserEventMidiKeyUp,
 };
 
-static SDLCALL Uint32 timerCallback(Uint32 interval, void* param)
+// Mouse buttons start repeating after being held this long (ms)
+#define MOUSE_REPEAT_DELAY 500
+
+static void frameTick()
 {
 	if (!myTrackerScreen || !myTracker || !ticking)
 	{
-		return interval;
+		return;
 	}
 
 	SDL_UserEvent ev;
 	ev.type = SDL_USEREVENT;
 
-	if (!(timerTicker % 1))
-	{
-		ev.code = SDLUserEventTimer;
-		SDL_PushEvent((SDL_Event*)&ev);
-
-		//PPEvent myEvent(eTimer);
-		//RaiseEventSerialized(&myEvent);
-	}
+	ev.code = SDLUserEventTimer;
+	SDL_PushEvent((SDL_Event*)&ev);
 
-	timerTicker++;
+	pp_uint32 now = PPGetTickCount();
 
 	if (mouseLeft.mouseDown &&
-		(timerTicker - mouseLeft.buttonDownStartTime) > 25)
+		(now - mouseLeft.buttonDownStartTime) > MOUSE_REPEAT_DELAY)
 	{
 		ev.code = SDLUserEventLMouseRepeat;
 		ev.data1 = reinterpret_cast<void*>(p.x);
@@ -196,7 +193,7 @@ static SDLCALL Uint32 timerCallback(Uint32 interval, void* param)
 	}
 
 	if (mouseRight.mouseDown &&
-		(timerTicker - mouseRight.buttonDownStartTime) > 25)
+		(now - mouseRight.buttonDownStartTime) > MOUSE_REPEAT_DELAY)
 	{
 		ev.code = SDLUserEventRMouseRepeat;
 		ev.data1 = reinterpret_cast<void*>(p.x);
@@ -208,7 +205,7 @@ static SDLCALL Uint32 timerCallback(Uint32 interval, void* param)
 	}
 
 	if (mouseMiddle.mouseDown &&
-		(timerTicker - mouseMiddle.buttonDownStartTime) > 25)
+		(now - mouseMiddle.buttonDownStartTime) > MOUSE_REPEAT_DELAY)
 	{
 		ev.code = SDLUserEventMMouseRepeat;
 		ev.data1 = reinterpret_cast<void*>(p.x);
@@ -218,8 +215,71 @@ static SDLCALL Uint32 timerCallback(Uint32 interval, void* param)
 		//PPEvent myEvent(eRMouseRepeat, &p, sizeof(PPPoint));
 		//RaiseEventSerialized(&myEvent);
 	}
+}
 
-	return interval;
+// Everything damaged since the last frame is presented in one go,
+// the present waits for the display refresh
+static void presentFrame()
+{
+	if (!myTrackerScreen || !ticking)
+	{
+		return;
+	}
+
+	globalMutex->lock();
+	myTrackerScreen->flushUpdates();
+	globalMutex->unlock();
+}
+
+// The UI used to be driven by a 20ms SDL timer, which beats against the
+// display refresh. Instead tick on a whole number of refresh periods
+// closest to 20ms, the presents are synced to the refresh anyway.
+static void initFrameClock(SDL_Window* window)
+{
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	SDL_DisplayMode mode;
+
+	frameInterval = frequency / 50;
+
+	if (window && SDL_GetWindowDisplayMode(window, &mode) == 0 && mode.refresh_rate > 0)
+	{
+		pp_int32 refreshesPerFrame = (mode.refresh_rate + 25) / 50;
+		if (refreshesPerFrame < 1)
+			refreshesPerFrame = 1;
+		frameInterval = frequency * refreshesPerFrame / mode.refresh_rate;
+	}
+
+	nextFrame = SDL_GetPerformanceCounter() + frameInterval;
+}
+
+// Replacement for SDL_WaitEvent which also pushes the timer events
+// and presents the screen when the next frame is due
+bool waitEventOrFrame(SDL_Event* event)
+{
+	while (true)
+	{
+		Uint64 now = SDL_GetPerformanceCounter();
+
+		if (frameInterval && now >= nextFrame)
+		{
+			frameTick();
+			presentFrame();
+
+			nextFrame += frameInterval;
+			// we're lagging behind, drop the missed frames
+			if (nextFrame <= now)
+				nextFrame = now + frameInterval;
+		}
+
+		if (!frameInterval)
+			return SDL_WaitEvent(event) != 0;
+
+		Uint64 frequency = SDL_GetPerformanceFrequency();
+		int timeout = (int)(((nextFrame - now) * 1000 + frequency - 1) / frequency);
+
+		if (SDL_WaitEventTimeout(event, timeout))
+			return true;
+	}
 }
 
 #ifdef HAVE_LIBASOUND
@@ -302,7 +362,7 @@ void translateMouseDownEvent(pp_int32 mouseButton, pp_int32 localMouseX, pp_int3
 		RaiseEventSerialized(&myEvent);
 
 		mouseLeft.mouseDown = true;
-		mouseLeft.buttonDownStartTime = timerTicker;
+		mouseLeft.buttonDownStartTime = PPGetTickCount();
 
 		if (!mouseLeft.clickCount)
 		{
@@ -333,7 +393,7 @@ void translateMouseDownEvent(pp_int32 mouseButton, pp_int32 localMouseX, pp_int3
 		RaiseEventSerialized(&myEvent);
 
 		mouseMiddle.mouseDown = true;
-		mouseMiddle.buttonDownStartTime = timerTicker;
+		mouseMiddle.buttonDownStartTime = PPGetTickCount();
 
 		if (!mouseMiddle.clickCount)
 		{
@@ -363,7 +423,7 @@ void translateMouseDownEvent(pp_int32 mouseButton, pp_int32 localMouseX, pp_int3
 		RaiseEventSerialized(&myEvent);
 
 		mouseRight.mouseDown = true;
-		mouseRight.buttonDownStartTime = timerTicker;
+		mouseRight.buttonDownStartTime = PPGetTickCount();
 
 		if (!mouseRight.clickCount)
 		{
@@ -836,12 +896,15 @@ void initTracker(pp_uint32 bpp, PPDisplayDevice::Orientations orientation,
 	InitMidi();
 #endif
 
-	// Try to create timer
-	timer = SDL_AddTimer(20, timerCallback, NULL);
+	// Start the frame clock driving the timer events
+	initFrameClock(myDisplayDevice->getWindow());
 
 	// Start capturing text input events
 	SDL_StartTextInput();
 
+	// From now on the screen is only presented by the frame clock
+	myTrackerScreen->setDeferredUpdates(true);
+
 	ticking = true;
 }
 
@@ -984,7 +1047,7 @@ unrecognizedCommandLineSwitch:
 
 	// Main event loop
 	done = 0;
-	while (!done && SDL_WaitEvent(&event))
+	while (!done && waitEventOrFrame(&event))
 	{
 		switch (event.type)
 		{
@@ -1035,7 +1098,6 @@ unrecognizedCommandLineSwitch:
 	}
 
 	ticking = false;
-	SDL_RemoveTimer(timer);
 
 	globalMutex->lock();
 #ifdef HAVE_LIBASOUND